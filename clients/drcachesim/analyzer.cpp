@@ -41,6 +41,7 @@
 #ifdef HAS_SNAPPY
 #    include "reader/snappy_file_reader.h"
 #endif
+#include "common/process_manifest.h"
 #include "common/utils.h"
 
 #ifdef HAS_ZLIB
@@ -100,6 +101,46 @@ get_reader(const std::string &path, int verbosity)
     return std::unique_ptr<reader_t>(new default_file_reader_t(path, verbosity));
 }
 
+static std::unique_ptr<reader_t>
+get_reader(const std::vector<std::string> &paths, int verbosity)
+{
+#ifdef HAS_SNAPPY
+    for (const std::string &path : paths) {
+        if (ends_with(path, ".sz"))
+            return std::unique_ptr<reader_t>(new snappy_file_reader_t(paths, verbosity));
+    }
+#endif
+    return std::unique_ptr<reader_t>(new default_file_reader_t(paths, verbosity));
+}
+
+// If trace_path is the -outdir of a -process_manifest run, fills in "paths" with
+// the final trace files of every process in its manifest.  Returns false on an
+// error listing those files.
+static bool
+get_process_manifest_files(const std::string &trace_path, std::vector<std::string> *paths)
+{
+    std::vector<process_manifest_entry_t> processes;
+    if (!directory_iterator_t::is_directory(trace_path) ||
+        !read_process_manifest(trace_path, &processes))
+        return true;
+    for (const process_manifest_entry_t &process : processes) {
+        const std::string dir = process_manifest_trace_dir(trace_path, process);
+        directory_iterator_t end;
+        directory_iterator_t iter(dir);
+        if (!iter) {
+            ERRMSG("Failed to list directory %s: %s", dir.c_str(),
+                   iter.error_string().c_str());
+            return false;
+        }
+        for (; iter != end; ++iter) {
+            if ((*iter) == "." || (*iter) == "..")
+                continue;
+            paths->push_back(dir + DIRSEP + *iter);
+        }
+    }
+    return true;
+}
+
 bool
 analyzer_t::init_file_reader(const std::string &trace_path, int verbosity)
 {
@@ -114,19 +155,29 @@ analyzer_t::init_file_reader(const std::string &trace_path, int verbosity)
             break;
         }
     }
+    // The -outdir of a multi-process run is analyzed as one trace holding the
+    // threads of all of its processes.
+    std::vector<std::string> manifest_paths;
+    if (!get_process_manifest_files(trace_path, &manifest_paths))
+        return false;
     if (parallel_ && directory_iterator_t::is_directory(trace_path)) {
-        directory_iterator_t end;
-        directory_iterator_t iter(trace_path);
-        if (!iter) {
-            ERRMSG("Failed to list directory %s: %s", trace_path.c_str(),
-                   iter.error_string().c_str());
-            return false;
+        std::vector<std::string> paths = manifest_paths;
+        if (paths.empty()) {
+            directory_iterator_t end;
+            directory_iterator_t iter(trace_path);
+            if (!iter) {
+                ERRMSG("Failed to list directory %s: %s", trace_path.c_str(),
+                       iter.error_string().c_str());
+                return false;
+            }
+            for (; iter != end; ++iter) {
+                const std::string fname = *iter;
+                if (fname == "." || fname == "..")
+                    continue;
+                paths.push_back(trace_path + DIRSEP + fname);
+            }
         }
-        for (; iter != end; ++iter) {
-            const std::string fname = *iter;
-            if (fname == "." || fname == "..")
-                continue;
-            const std::string path = trace_path + DIRSEP + fname;
+        for (const std::string &path : paths) {
             std::unique_ptr<reader_t> reader = get_reader(path, verbosity);
             if (!reader) {
                 return false;
@@ -149,7 +200,10 @@ analyzer_t::init_file_reader(const std::string &trace_path, int verbosity)
         }
     } else {
         parallel_ = false;
-        serial_trace_iter_ = get_reader(trace_path, verbosity);
+        if (!manifest_paths.empty())
+            serial_trace_iter_ = get_reader(manifest_paths, verbosity);
+        else
+            serial_trace_iter_ = get_reader(trace_path, verbosity);
         if (!serial_trace_iter_) {
             return false;
         }
@@ -295,6 +349,8 @@ analyzer_t::run()
     if (!parallel_) {
         if (!start_reading())
             return false;
+        if (skip_refs_ > 0)
+            serial_trace_iter_->skip_memrefs(skip_refs_);
         for (; *serial_trace_iter_ != *trace_end_; ++(*serial_trace_iter_)) {
             for (int i = 0; i < num_tools_; ++i) {
                 memref_t memref = **serial_trace_iter_;
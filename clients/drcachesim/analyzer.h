@@ -164,6 +164,9 @@ protected:
     std::vector<std::vector<analyzer_shard_data_t *>> worker_tasks_;
     int verbosity_ = 0;
     const char *output_prefix_ = "[analyzer]";
+    // The number of records a serial run skips before handing any to the tools,
+    // as for resuming a simulation from a checkpoint.
+    uint64_t skip_refs_ = 0;
 };
 
 #endif /* _ANALYZER_H_ */
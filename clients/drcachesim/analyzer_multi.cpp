@@ -35,6 +35,7 @@
 #include "analysis_tool_interface.h"
 #include "common/options.h"
 #include "common/utils.h"
+#include "common/process_manifest.h"
 #include "common/directory_iterator.h"
 #include "tracer/raw2trace_directory.h"
 #include "tracer/raw2trace.h"
@@ -43,6 +44,7 @@
 #    include "reader/compressed_file_reader.h"
 #endif
 #include "reader/ipc_reader.h"
+#include "simulator/checkpoint.h"
 #include "tools/invariant_checker.h"
 
 analyzer_multi_t::analyzer_multi_t()
@@ -61,6 +63,17 @@ analyzer_multi_t::analyzer_multi_t()
         error_string_ = "Failed to create analysis tool: " + error_string_;
         return;
     }
+    if (!op_restore_checkpoint.get_value().empty()) {
+        // The simulator resumes at the trace position the checkpoint records.
+        std::string error;
+        if (!checkpoint_read_position(op_restore_checkpoint.get_value(), skip_refs_,
+                                      error)) {
+            success_ = false;
+            error_string_ = error;
+            return;
+        }
+        parallel_ = false;
+    }
     // XXX: add a "required" flag to droption to avoid needing this here
     if (op_indir.get_value().empty() && op_infile.get_value().empty() &&
         op_ipc_name.get_value().empty()) {
@@ -70,7 +83,20 @@ analyzer_multi_t::analyzer_multi_t()
         success_ = false;
         return;
     }
-    if (!op_indir.get_value().empty()) {
+    std::vector<process_manifest_entry_t> processes;
+    if (!op_indir.get_value().empty() &&
+        read_process_manifest(op_indir.get_value(), &processes)) {
+        // A -process_manifest -outdir: convert any unconverted processes and then
+        // analyze all of them together.
+        std::string error = raw2trace_t::convert_process_manifest(
+            op_indir.get_value(), op_verbose.get_value(), op_jobs.get_value(),
+            op_alt_module_dir.get_value());
+        if (!error.empty()) {
+            success_ = false;
+            error_string_ = "raw2trace failed: " + error;
+        } else if (!init_file_reader(op_indir.get_value(), op_verbose.get_value()))
+            success_ = false;
+    } else if (!op_indir.get_value().empty()) {
         std::string tracedir =
             raw2trace_directory_t::tracedir_from_rawdir(op_indir.get_value());
         // We support the trace dir being empty if we haven't post-processed
@@ -108,6 +134,8 @@ analyzer_multi_t::analyzer_multi_t()
             raw2trace_t raw2trace(dir.modfile_bytes_, dir.in_files_, dir.out_files_,
                                   nullptr, op_verbose.get_value(), op_jobs.get_value(),
                                   op_alt_module_dir.get_value());
+            if (dir.gencode_bytes_ != nullptr)
+                raw2trace.set_gencode_snapshots(dir.gencode_bytes_, dir.gencode_size_);
             std::string error = raw2trace.do_conversion();
             if (!error.empty()) {
                 success_ = false;
@@ -65,6 +65,16 @@ droption_t<std::string> op_subdir_prefix(
     "The sub-directory is created inside -outdir and has the form "
     "'prefix.app-name.pid.id.dir'.");
 
+droption_t<bool> op_process_manifest(
+    DROPTION_SCOPE_CLIENT, "process_manifest", false,
+    "Register each traced process in a manifest in -outdir",
+    "For the offline analysis mode (when -offline is requested), each traced process, "
+    "including each child created by fork, appends its process id, its parent's "
+    "process id, and the name of its sub-directory to a manifest file named "
+    "drmemtrace.processes.log in -outdir, which is created if it does not exist.  "
+    "Passing -outdir itself as -indir to post-processing or analysis then converts "
+    "and analyzes every process in the manifest together as one multi-process trace.");
+
 droption_t<std::string> op_indir(
     DROPTION_SCOPE_ALL, "indir", "", "Input directory of offline trace files",
     "After a trace file is produced via -offline into -outdir, it can be passed to the "
@@ -90,7 +100,8 @@ droption_t<int> op_jobs(
 droption_t<std::string> op_module_file(
     DROPTION_SCOPE_ALL, "module_file", "", "Path to modules.log for opcode_mix tool",
     "The opcode_mix tool needs the modules.log file (generated by the offline "
-    "post-processing step in the raw/ subdirectory) in addition to the trace file. "
+    "post-processing step in the raw/ subdirectory) in addition to the trace file, "
+    "as does the cache simulator to name functions for -miss_attribution. "
     "If the file is named modules.log and is in the same directory as the trace file, "
     "or a raw/ subdirectory below the trace file, this parameter can be omitted.");
 
@@ -159,6 +170,18 @@ droption_t<std::string> op_LL_miss_file(
     "analysis be written to the specified file. Each hint is written in text format as a "
     "<program counter, stride, locality level> tuple.");
 
+droption_t<double> op_LL_sample_fraction(
+    DROPTION_SCOPE_FRONTEND, "LL_sample_fraction", 1.0, 0.0, 1.0,
+    "Fraction of last-level cache sets to simulate",
+    "When below 1, the cache simulator only simulates approximately this fraction of "
+    "the sets of the last-level cache, chosen by a hash of the set index, and drops "
+    "the accesses to the other sets.  The reported last-level hit and miss counts are "
+    "estimates scaled up to the whole cache, and are followed by the number of sets "
+    "sampled and 95% confidence intervals for the miss count and miss rate.  This "
+    "makes simulating very large last-level caches much faster, at a known cost in "
+    "accuracy.  Only the default two-level hierarchy supports this: it is not "
+    "available with -config_file.");
+
 droption_t<bool> op_L0_filter_deprecated(
     DROPTION_SCOPE_CLIENT, "L0_filter", false,
     "Filter out first-level instruction and data cache hits during tracing",
@@ -207,6 +230,75 @@ droption_t<bool> op_coherence(
     DROPTION_SCOPE_FRONTEND, "coherence", false, "Model coherence for private caches",
     "Writes to cache lines will invalidate other private caches that hold that line.");
 
+droption_t<bool> op_parallel_cores(
+    DROPTION_SCOPE_FRONTEND, "parallel_cores", false,
+    "Simulate each core's private caches on its own thread",
+    "By default, the cache simulator simulates all caches on a single thread.  When "
+    "this option is enabled, the L1 caches of each simulated core are simulated on a "
+    "separate host thread while the shared last-level cache is updated from the "
+    "accesses that miss in them.  References are handed to the core threads in "
+    "batches of -parallel_epoch references.  Any warmup phase is still simulated on a "
+    "single thread.  This option is only supported for the default two-level "
+    "hierarchy without -coherence or -timing and not with -config_file.");
+
+droption_t<bool> op_parallel_deterministic(
+    DROPTION_SCOPE_FRONTEND, "parallel_deterministic", true,
+    "Make -parallel_cores results match serial simulation",
+    "When -parallel_cores is enabled, the last-level cache accesses of each batch are "
+    "replayed in their original order, producing results identical to simulation on "
+    "a single thread.  Disabling this option lets each core thread update the "
+    "last-level cache directly as soon as it finishes its batch, which is faster but "
+    "may reorder last-level accesses by up to -parallel_epoch references.");
+
+droption_t<unsigned int> op_parallel_epoch(
+    DROPTION_SCOPE_FRONTEND, "parallel_epoch", 16384,
+    "Batch size for -parallel_cores",
+    "The number of references, summed across all cores, that are handed to the core "
+    "threads at once when -parallel_cores is enabled.");
+
+droption_t<bool> op_timing(
+    DROPTION_SCOPE_FRONTEND, "timing", false, "Estimate stall cycles for each core",
+    "Adds a timing model to the cache simulator, which then reports for each core the "
+    "estimated cycles, the cycles stalled on the cache hierarchy, and the average "
+    "memory access time.  Each access costs the hit latency of each cache it reaches "
+    "plus -memory_latency and any wait for memory bandwidth if it misses in the "
+    "last-level cache.  Each core issues one instruction per cycle and stalls on "
+    "instruction fetch and load misses, while store misses only stall it once all of "
+    "its -mshrs miss registers are busy.");
+
+droption_t<unsigned int> op_L1I_latency(
+    DROPTION_SCOPE_FRONTEND, "L1I_latency", 4,
+    "Instruction cache hit latency in cycles for -timing",
+    "Specifies the hit latency in cycles of each L1 instruction cache for -timing.");
+
+droption_t<unsigned int> op_L1D_latency(
+    DROPTION_SCOPE_FRONTEND, "L1D_latency", 4,
+    "Data cache hit latency in cycles for -timing",
+    "Specifies the hit latency in cycles of each L1 data cache for -timing.");
+
+droption_t<unsigned int> op_LL_latency(
+    DROPTION_SCOPE_FRONTEND, "LL_latency", 40,
+    "Last-level cache hit latency in cycles for -timing",
+    "Specifies the hit latency in cycles of the last-level cache for -timing.");
+
+droption_t<unsigned int> op_memory_latency(
+    DROPTION_SCOPE_FRONTEND, "memory_latency", 200, "Memory latency in cycles for -timing",
+    "Specifies the latency in cycles of a last-level cache miss for -timing, not "
+    "counting the line transfer time given by -memory_bandwidth.");
+
+droption_t<double> op_memory_bandwidth(
+    DROPTION_SCOPE_FRONTEND, "memory_bandwidth", 16.0, 0.0, 4096.0,
+    "Memory bandwidth in bytes per cycle for -timing",
+    "Specifies the bytes per cycle that memory can transfer for -timing.  Lines missing "
+    "in the last-level cache wait for the transfers ahead of them.  0 means unlimited "
+    "bandwidth.");
+
+droption_t<unsigned int> op_mshrs(
+    DROPTION_SCOPE_FRONTEND, "mshrs", 10,
+    "Outstanding misses per core for -timing",
+    "Specifies the number of miss status holding registers of each core for -timing, "
+    "which limits how many misses the core can have outstanding.");
+
 droption_t<bool> op_use_physical(
     DROPTION_SCOPE_CLIENT, "use_physical", false, "Use physical addresses if possible",
     "If available, the default virtual addresses will be translated to physical.  "
@@ -299,6 +391,27 @@ droption_t<bytesize_t> op_exit_after_tracing(
     "exited with an exit code of 0.  The reference count is approximate. "
     "Use -max_global_trace_refs instead to avoid terminating the process.");
 
+droption_t<bytesize_t> op_flight_recorder(
+    DROPTION_SCOPE_CLIENT, "flight_recorder", 0,
+    "Keep recent trace history in memory and write it only on a trigger",
+    "If non-zero, with -offline, nothing is written to the trace files as the "
+    "application runs.  Instead, each thread keeps roughly this many bytes of its most "
+    "recent raw trace data in an in-memory ring buffer, overwriting older data.  When "
+    "a trigger fires, each thread's history is written out: on its next buffer flush, "
+    "so it may include up to one buffer of activity after the trigger, or at its exit.  "
+    "A later trigger writes the history gathered since the prior one.  The triggers "
+    "are a nudge of the process, the signal given by -flight_recorder_signal, the "
+    "drmemtrace_flight_recorder_dump() routine, and an application annotation named "
+    "drmemtrace_flight_recorder_dump.  This is not supported with tracing windows, "
+    "-use_physical, or drmemtrace_buffer_handoff().");
+
+droption_t<int> op_flight_recorder_signal(
+    DROPTION_SCOPE_CLIENT, "flight_recorder_signal", 0,
+    "Signal number that triggers a -flight_recorder dump",
+    "If non-zero, for -flight_recorder on UNIX, the delivery of this signal to the "
+    "application triggers a dump of the recorded history.  The signal itself is "
+    "suppressed and not passed on to the application.");
+
 droption_t<std::string> op_raw_compress(
     DROPTION_SCOPE_CLIENT, "raw_compress",
 #if defined(HAS_LZ4) && !defined(DRMEMTRACE_STATIC)
@@ -326,20 +439,52 @@ droption_t<bool> op_online_instr_types(
     "branches in particular.  For online traces, this comes at a performance cost, so "
     "it is turned off by default.");
 
+droption_t<bool> op_record_gencode(
+    DROPTION_SCOPE_CLIENT, "record_gencode", false,
+    "Snapshot code outside of modules for offline decoding",
+    "By default, offline traces omit the instruction fetches for code that is not "
+    "inside any module, such as code generated by a JIT compiler, as the post-processor "
+    "has no copy of such code to decode.  When this option is enabled, the bytes of "
+    "each such basic block are copied when the block is built into the file gencode.log "
+    "next to the module list, with identical copies at the same address stored only "
+    "once.  The block's trace entries then refer into that file using the same compact "
+    "encoding as module code, allowing the post-processor to decode the code as it was "
+    "when it was executed.  Code that is modified in place without DynamoRIO rebuilding "
+    "the block is recorded as of the time the block was built.");
+
 droption_t<std::string> op_replace_policy(
     DROPTION_SCOPE_FRONTEND, "replace_policy", REPLACE_POLICY_LRU,
-    "Cache replacement policy (LRU, LFU, FIFO)",
+    "Cache replacement policy (LRU, LFU, FIFO, SRRIP, BRRIP, DRRIP, SHiP)",
     "Specifies the replacement policy for "
     "caches. Supported policies: LRU (Least Recently Used), LFU (Least Frequently Used), "
-    "FIFO (First-In-First-Out).");
+    "FIFO (First-In-First-Out), SRRIP (Static Re-Reference Interval Prediction), BRRIP "
+    "(Bimodal RRIP), DRRIP (Dynamic RRIP, which chooses between SRRIP and BRRIP by set "
+    "dueling), SHiP (Signature-based Hit Predictor, which uses SRRIP but inserts lines "
+    "brought in by PCs whose lines are rarely reused as if about to be evicted).");
 
 droption_t<std::string> op_data_prefetcher(
     DROPTION_SCOPE_FRONTEND, "data_prefetcher", PREFETCH_POLICY_NEXTLINE,
-    "Hardware data prefetcher policy (nextline, none)",
+    "Hardware data prefetcher policy (nextline, stride, stream, spatial, none)",
     "Specifies the hardware data "
     "prefetcher policy.  The currently supported policies are 'nextline' (fetch the "
-    "subsequent cache line) and 'none' (disables hardware prefetching).  The prefetcher "
-    "is located between the L1D and LL caches.");
+    "subsequent cache line on a miss), 'stride' (detect a constant stride in the lines "
+    "accessed by each instruction and fetch ahead along it), 'stream' (follow up to 16 "
+    "ascending or descending streams of line accesses and fetch ahead of each), "
+    "'spatial' (learn which lines of each 2KB region are used after the first access "
+    "by a given instruction and fetch them on the next such access), and 'none' "
+    "(disables hardware prefetching).  The prefetcher is located between the L1D and LL "
+    "caches.  Each L1D's statistics then include the number of prefetches issued, the "
+    "number that were useful (hit by a demand access), the number of those that were "
+    "late (see -prefetch_late_refs), and the number of demand misses on lines that "
+    "prefetches evicted.");
+
+droption_t<unsigned int> op_prefetch_late_refs(
+    DROPTION_SCOPE_FRONTEND, "prefetch_late_refs", 4,
+    "Demand accesses within which a prefetch counts as late",
+    "The cache simulator has no notion of time, so a prefetched line whose first "
+    "demand use comes within this many demand accesses to the cache after the "
+    "prefetch is counted as a late prefetch: one that would likely not have completed "
+    "before it was needed.  0 counts no prefetch as late.");
 
 droption_t<bytesize_t> op_page_size(DROPTION_SCOPE_FRONTEND, "page_size",
                                     bytesize_t(4 * 1024), "Virtual/physical page size",
@@ -376,15 +521,78 @@ droption_t<std::string>
                           "Specifies the replacement policy for TLBs. "
                           "Supported policies: LFU (Least Frequently Used).");
 
+droption_t<std::string> op_TLB_page_sizes(
+    DROPTION_SCOPE_FRONTEND, "TLB_page_sizes", "", "File listing huge page mappings",
+    "Specifies a file describing which virtual address ranges are backed by pages "
+    "larger than -page_size.  The file is either a copy of /proc/<pid>/smaps of the "
+    "traced process, where mappings with a larger KernelPageSize use that size and "
+    "the 2M-aligned interior of mappings with AnonHugePages uses 2M pages, or a list "
+    "of lines of the form \"<start>-<end> <size>\" with hexadecimal addresses and a "
+    "size such as 4K, 2M or 1G.  Later lines override earlier ones.  Each TLB "
+    "holds translations for all page sizes.");
+
+droption_t<unsigned int> op_TLB_PWC_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_PWC_entries", 32,
+    "Number of entries per level in the page walk cache",
+    "Specifies the number of entries the page walk cache of each core holds for each "
+    "non-leaf page table level.  A hit skips the references to that level and the "
+    "levels above it.  0 disables the page walk cache.");
+
+droption_t<bool> op_TLB_walk_caches(
+    DROPTION_SCOPE_FRONTEND, "TLB_walk_caches", false,
+    "Simulate the caches alongside the TLBs and feed them page walk references",
+    "Simulates the cache hierarchy described by the cache options alongside the TLBs "
+    "and feeds it both the trace and the page table references of each page walk, "
+    "whose costs then come from where each reference hits.  Without this option, "
+    "each page table reference is assumed to cost -L1D_latency plus -LL_latency.  "
+    "The cache results are printed after the TLB results.");
+
+droption_t<std::string> op_save_checkpoint(
+    DROPTION_SCOPE_FRONTEND, "save_checkpoint", "",
+    "Write the simulator state to this file after warmup",
+    "For the cache and TLB simulators, writes the state of every simulated cache or "
+    "TLB, including its replacement state and that of any prefetcher, page walk "
+    "cache, and snoop filter, along with the mapping of threads to cores, to the "
+    "given file once warmup completes.  Requires -warmup_refs, or -warmup_fraction "
+    "for the cache simulator.  The file also records how far into the trace warmup "
+    "ended, so that -restore_checkpoint can resume simulation from that point "
+    "without repeating the warmup.  Checkpoints are host- and version-specific.  "
+    "Not supported with -config_file.");
+
+droption_t<std::string> op_restore_checkpoint(
+    DROPTION_SCOPE_FRONTEND, "restore_checkpoint", "",
+    "Resume simulation from a checkpoint written by -save_checkpoint",
+    "Restores the simulator state from a file written by -save_checkpoint and "
+    "resumes simulation at the position in the trace where it was written, skipping "
+    "the records before that point without simulating them.  Options such as "
+    "-skip_refs, -warmup_refs and -warmup_fraction are ignored, while the simulated "
+    "hierarchy must match that of the run that wrote the checkpoint.  Options that "
+    "do not change the hierarchy, such as -sim_refs or the -timing options, may "
+    "differ.  Not supported with -config_file.");
+
+droption_t<unsigned int> op_miss_attribution(
+    DROPTION_SCOPE_FRONTEND, "miss_attribution", 0,
+    "Report the top N sources of misses per cache level",
+    "If non-zero, the cache simulator counts the misses of each cache per "
+    "instruction address and, at the end, prints for each level the given number of "
+    "instructions and of functions with the most misses, merging the private caches "
+    "of all cores.  Functions are named by looking up the symbols of the modules "
+    "listed in the file given by -module_file (found in the trace directory when "
+    "omitted), which requires an offline trace and access to the traced binaries "
+    "(see -alt_module_dir); otherwise only instruction addresses are listed.  Misses "
+    "during warmup are not counted, nor are misses of prefetches.  Not supported "
+    "with -config_file.");
+
 droption_t<std::string>
     op_simulator_type(DROPTION_SCOPE_FRONTEND, "simulator_type", CPU_CACHE,
                       "Simulator type (" CPU_CACHE ", " MISS_ANALYZER ", " TLB
-                      ", " REUSE_DIST ", " REUSE_TIME ", " HISTOGRAM ", " VIEW
-                      ", " FUNC_VIEW ", " BASIC_COUNTS ", or " INVARIANT_CHECKER ").",
+                      ", " REUSE_DIST ", " REUSE_TIME ", " MISS_RATIO_CURVE
+                      ", " HISTOGRAM ", " VIEW ", " FUNC_VIEW ", " BASIC_COUNTS
+                      ", or " INVARIANT_CHECKER ").",
                       "Specifies the type of the simulator. "
                       "Supported types: " CPU_CACHE ", " MISS_ANALYZER ", " TLB
-                      ", " REUSE_DIST ", " REUSE_TIME ", " HISTOGRAM ", " BASIC_COUNTS
-                      ", or " INVARIANT_CHECKER ".");
+                      ", " REUSE_DIST ", " REUSE_TIME ", " MISS_RATIO_CURVE
+                      ", " HISTOGRAM ", " BASIC_COUNTS ", or " INVARIANT_CHECKER ".");
 
 droption_t<unsigned int> op_verbose(DROPTION_SCOPE_ALL, "verbose", 0, 0, 64,
                                     "Verbosity level",
@@ -519,6 +727,25 @@ droption_t<bool> op_reuse_verify_skip(
     "This incurs significant additional overhead.  This option is only available "
     "in debug builds.");
 
+droption_t<bytesize_t> op_mrc_min_size(
+    DROPTION_SCOPE_FRONTEND, "mrc_min_size", 1024U,
+    "Smallest cache size for the " MISS_RATIO_CURVE " tool.",
+    "Specifies the smallest total cache size for which the " MISS_RATIO_CURVE
+    " tool reports miss ratios.  Must be a power of 2 no smaller than -line_size.");
+droption_t<bytesize_t> op_mrc_max_size(
+    DROPTION_SCOPE_FRONTEND, "mrc_max_size", 8 * 1024 * 1024U,
+    "Largest cache size for the " MISS_RATIO_CURVE " tool.",
+    "Specifies the largest total cache size for which the " MISS_RATIO_CURVE
+    " tool reports miss ratios.  Must be a power of 2.  The tool reports every "
+    "power-of-2 size from -mrc_min_size up to this size in a single pass, using "
+    "memory proportional to this size times the number of set counts involved.");
+droption_t<unsigned int> op_mrc_max_assoc(
+    DROPTION_SCOPE_FRONTEND, "mrc_max_assoc", 16,
+    "Largest associativity for the " MISS_RATIO_CURVE " tool.",
+    "Specifies the largest associativity for which the " MISS_RATIO_CURVE
+    " tool reports miss ratios, alongside every smaller power of 2 and fully "
+    "associative caches.  Must be a power of 2.");
+
 #define OP_RECORD_FUNC_ITEM_SEP "&"
 // XXX i#3048: replace function return address with function callstack
 droption_t<std::string> op_record_function(
@@ -612,6 +839,19 @@ droption_t<bool> op_record_replace_retaddr(
     "replacement, which has lower overhead, but runs the risk of breaking an "
     "application that examines or changes its own return addresses in the recorded "
     "functions.");
+droption_t<bool> op_record_inline_entry(
+    DROPTION_SCOPE_CLIENT, "record_inline_entry", false,
+    "Record function entries with inlined code for -record_function and -record_heap.",
+    "By default, the function id, return address, and arguments recorded at the entry "
+    "to each function requested by -record_function and -record_heap are gathered by a "
+    "callback from a clean call.  This option instead writes them directly into the "
+    "trace buffer with inlined instrumentation, which is much faster for frequently "
+    "called functions.  It applies only to -offline tracing on 64-bit platforms, to "
+    "functions whose recorded arguments are all passed in registers, and, unless the "
+    "function is marked noret, only in the absence of -record_replace_retaddr.  Other "
+    "functions continue to use callbacks.  The return value is always recorded with a "
+    "callback.  The inlined entry relies on the function entry starting a new "
+    "basic block, which is the case for regular calls.");
 droption_t<unsigned int> op_miss_count_threshold(
     DROPTION_SCOPE_FRONTEND, "miss_count_threshold", 50000,
     "For cache miss analysis: minimum LLC miss count for a load to be eligible for "
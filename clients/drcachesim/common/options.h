@@ -39,7 +39,14 @@
 #define REPLACE_POLICY_LRU "LRU"
 #define REPLACE_POLICY_LFU "LFU"
 #define REPLACE_POLICY_FIFO "FIFO"
+#define REPLACE_POLICY_SRRIP "SRRIP"
+#define REPLACE_POLICY_BRRIP "BRRIP"
+#define REPLACE_POLICY_DRRIP "DRRIP"
+#define REPLACE_POLICY_SHIP "SHiP"
 #define PREFETCH_POLICY_NEXTLINE "nextline"
+#define PREFETCH_POLICY_STRIDE "stride"
+#define PREFETCH_POLICY_STREAM "stream"
+#define PREFETCH_POLICY_SPATIAL "spatial"
 #define PREFETCH_POLICY_NONE "none"
 #define CPU_CACHE "cache"
 #define MISS_ANALYZER "miss_analyzer"
@@ -47,6 +54,7 @@
 #define HISTOGRAM "histogram"
 #define REUSE_DIST "reuse_distance"
 #define REUSE_TIME "reuse_time"
+#define MISS_RATIO_CURVE "miss_ratio_curve"
 #define BASIC_COUNTS "basic_counts"
 #define OPCODE_MIX "opcode_mix"
 #define VIEW "view"
@@ -64,6 +72,7 @@ extern droption_t<bool> op_offline;
 extern droption_t<std::string> op_ipc_name;
 extern droption_t<std::string> op_outdir;
 extern droption_t<std::string> op_subdir_prefix;
+extern droption_t<bool> op_process_manifest;
 extern droption_t<std::string> op_infile;
 extern droption_t<std::string> op_indir;
 extern droption_t<std::string> op_module_file;
@@ -78,6 +87,7 @@ extern droption_t<unsigned int> op_L1D_assoc;
 extern droption_t<bytesize_t> op_LL_size;
 extern droption_t<unsigned int> op_LL_assoc;
 extern droption_t<std::string> op_LL_miss_file;
+extern droption_t<double> op_LL_sample_fraction;
 extern droption_t<bytesize_t> op_L0I_size;
 extern droption_t<bool> op_L0_filter_deprecated;
 extern droption_t<bool> op_L0I_filter;
@@ -85,6 +95,16 @@ extern droption_t<bool> op_L0D_filter;
 extern droption_t<bytesize_t> op_L0D_size;
 extern droption_t<bool> op_instr_only_trace;
 extern droption_t<bool> op_coherence;
+extern droption_t<bool> op_parallel_cores;
+extern droption_t<bool> op_parallel_deterministic;
+extern droption_t<unsigned int> op_parallel_epoch;
+extern droption_t<bool> op_timing;
+extern droption_t<unsigned int> op_L1I_latency;
+extern droption_t<unsigned int> op_L1D_latency;
+extern droption_t<unsigned int> op_LL_latency;
+extern droption_t<unsigned int> op_memory_latency;
+extern droption_t<double> op_memory_bandwidth;
+extern droption_t<unsigned int> op_mshrs;
 extern droption_t<bool> op_use_physical;
 extern droption_t<unsigned int> op_virt2phys_freq;
 extern droption_t<bool> op_cpu_scheduling;
@@ -95,10 +115,14 @@ extern droption_t<bytesize_t> op_trace_for_instrs;
 extern droption_t<bytesize_t> op_retrace_every_instrs;
 extern droption_t<bool> op_split_windows;
 extern droption_t<bytesize_t> op_exit_after_tracing;
+extern droption_t<bytesize_t> op_flight_recorder;
+extern droption_t<int> op_flight_recorder_signal;
 extern droption_t<std::string> op_raw_compress;
 extern droption_t<bool> op_online_instr_types;
+extern droption_t<bool> op_record_gencode;
 extern droption_t<std::string> op_replace_policy;
 extern droption_t<std::string> op_data_prefetcher;
+extern droption_t<unsigned int> op_prefetch_late_refs;
 extern droption_t<bytesize_t> op_page_size;
 extern droption_t<unsigned int> op_TLB_L1I_entries;
 extern droption_t<unsigned int> op_TLB_L1D_entries;
@@ -107,6 +131,12 @@ extern droption_t<unsigned int> op_TLB_L1D_assoc;
 extern droption_t<unsigned int> op_TLB_L2_entries;
 extern droption_t<unsigned int> op_TLB_L2_assoc;
 extern droption_t<std::string> op_TLB_replace_policy;
+extern droption_t<std::string> op_TLB_page_sizes;
+extern droption_t<unsigned int> op_TLB_PWC_entries;
+extern droption_t<bool> op_TLB_walk_caches;
+extern droption_t<std::string> op_save_checkpoint;
+extern droption_t<std::string> op_restore_checkpoint;
+extern droption_t<unsigned int> op_miss_attribution;
 extern droption_t<std::string> op_simulator_type;
 extern droption_t<unsigned int> op_verbose;
 extern droption_t<bool> op_show_func_trace;
@@ -131,12 +161,16 @@ extern droption_t<unsigned int> op_reuse_distance_threshold;
 extern droption_t<bool> op_reuse_distance_histogram;
 extern droption_t<unsigned int> op_reuse_skip_dist;
 extern droption_t<bool> op_reuse_verify_skip;
+extern droption_t<bytesize_t> op_mrc_min_size;
+extern droption_t<bytesize_t> op_mrc_max_size;
+extern droption_t<unsigned int> op_mrc_max_assoc;
 extern droption_t<std::string> op_view_syntax;
 extern droption_t<std::string> op_record_function;
 extern droption_t<bool> op_record_heap;
 extern droption_t<std::string> op_record_heap_value;
 extern droption_t<bool> op_record_dynsym_only;
 extern droption_t<bool> op_record_replace_retaddr;
+extern droption_t<bool> op_record_inline_entry;
 extern droption_t<unsigned int> op_miss_count_threshold;
 extern droption_t<double> op_miss_frac_threshold;
 extern droption_t<double> op_confidence_threshold;
@@ -0,0 +1,86 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* process_manifest: reads the list of processes written by -process_manifest.
+ */
+
+#ifndef _PROCESS_MANIFEST_H_
+#define _PROCESS_MANIFEST_H_ 1
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "trace_entry.h"
+#include "utils.h"
+
+struct process_manifest_entry_t {
+    int64_t pid;
+    int64_t parent_pid;
+    // The name of the process's sub-directory of the -outdir holding the manifest.
+    std::string subdir;
+};
+
+// Reads the DRMEMTRACE_PROCESS_MANIFEST_FILENAME manifest in "outdir" and appends
+// its entries, in registration order, to "entries".  Returns false if "outdir"
+// has no manifest.  Malformed lines, such as a partial final line from a process
+// that was killed while registering, are skipped.
+static inline bool
+read_process_manifest(const std::string &outdir,
+                      std::vector<process_manifest_entry_t> *entries)
+{
+    std::ifstream stream(outdir + DIRSEP + DRMEMTRACE_PROCESS_MANIFEST_FILENAME);
+    if (!stream.good())
+        return false;
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream fields(line);
+        process_manifest_entry_t entry;
+        char sep1, sep2;
+        if (!(fields >> entry.pid >> sep1 >> entry.parent_pid >> sep2) || sep1 != ',' ||
+            sep2 != ',' || !std::getline(fields, entry.subdir) || entry.subdir.empty())
+            continue;
+        entries->push_back(entry);
+    }
+    return true;
+}
+
+// Returns the directory holding the final trace files of the process "entry" of
+// the manifest in "outdir": the TRACE_SUBDIR of raw2trace.h inside its sub-directory.
+static inline std::string
+process_manifest_trace_dir(const std::string &outdir,
+                           const process_manifest_entry_t &entry)
+{
+    return outdir + DIRSEP + entry.subdir + DIRSEP + "trace";
+}
+
+#endif /* _PROCESS_MANIFEST_H_ */
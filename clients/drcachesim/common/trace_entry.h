@@ -502,6 +502,11 @@ typedef enum {
 #define PC_INSTR_COUNT_BITS 12
 #define PC_TYPE_BITS 3
 
+// A PC entry whose modidx holds this value refers to a generated-code snapshot
+// rather than to a module: its modoffs is the offset of the instruction within
+// the DRMEMTRACE_GENCODE_FILENAME file.
+#define PC_MODIDX_GENCODE ((1 << PC_MODIDX_BITS) - 1)
+
 #define OFFLINE_FILE_VERSION_NO_ELISION 2
 #define OFFLINE_FILE_VERSION_OLDEST_SUPPORTED OFFLINE_FILE_VERSION_NO_ELISION
 #define OFFLINE_FILE_VERSION_ELIDE_UNMOD_BASE 3
@@ -627,4 +632,32 @@ typedef union {
  */
 #define DRMEMTRACE_FUNCTION_LIST_FILENAME "funclist.log"
 
+/**
+ * The name of the file in the -outdir directory where, with -process_manifest,
+ * each traced process records itself with a line of the form
+ * "pid,parent_pid,subdir", where subdir is the name of the process's
+ * sub-directory of -outdir.
+ */
+#define DRMEMTRACE_PROCESS_MANIFEST_FILENAME "drmemtrace.processes.log"
+
+/**
+ * The name of the file in -offline mode where snapshots of code that is not
+ * inside any module, such as JIT-generated code, are written when -record_gencode
+ * is enabled.  The file is a sequence of #gencode_snapshot_t headers each
+ * followed by the code bytes it describes.
+ */
+#define DRMEMTRACE_GENCODE_FILENAME "gencode.log"
+
+/**
+ * The header of each code snapshot in the #DRMEMTRACE_GENCODE_FILENAME file.
+ */
+START_PACKED_STRUCTURE
+struct _gencode_snapshot_t {
+    uint64_t orig_pc; /**< The application address of the first byte. */
+    uint64_t hash;    /**< A hash of the code bytes, used to deduplicate snapshots. */
+    uint64_t size;    /**< The number of code bytes following this header. */
+} END_PACKED_STRUCTURE;
+/** See #_gencode_snapshot_t. */
+typedef struct _gencode_snapshot_t gencode_snapshot_t;
+
 #endif /* _TRACE_ENTRY_H_ */
@@ -133,6 +133,49 @@ config_reader_t::configure(std::istream *config_file, cache_simulator_knobs_t &k
                 ERRMSG("Error reading verbose from the configuration file\n");
                 return false;
             }
+        } else if (param == "prefetch_late_refs") {
+            // Demand accesses within which a prefetch counts as late.
+            if (!(*fin_ >> knobs.prefetch_late_refs)) {
+                ERRMSG("Error reading prefetch_late_refs from "
+                       "the configuration file\n");
+                return false;
+            }
+        } else if (param == "timing") {
+            // Whether to model timing.
+            std::string bool_val;
+            if (!(*fin_ >> bool_val)) {
+                ERRMSG("Error reading timing from the configuration file\n");
+                return false;
+            }
+            if (is_true(bool_val)) {
+                knobs.model_timing = true;
+            } else {
+                knobs.model_timing = false;
+            }
+        } else if (param == "memory_latency") {
+            // Memory latency in cycles.
+            if (!(*fin_ >> knobs.memory_latency)) {
+                ERRMSG("Error reading memory_latency from "
+                       "the configuration file\n");
+                return false;
+            }
+        } else if (param == "memory_bandwidth") {
+            // Memory bandwidth in bytes per cycle.
+            if (!(*fin_ >> knobs.memory_bandwidth)) {
+                ERRMSG("Error reading memory_bandwidth from "
+                       "the configuration file\n");
+                return false;
+            }
+            if (knobs.memory_bandwidth < 0.0) {
+                ERRMSG("Memory bandwidth must be >=0\n");
+                return false;
+            }
+        } else if (param == "mshrs") {
+            // Outstanding misses per core.
+            if (!(*fin_ >> knobs.mshrs)) {
+                ERRMSG("Error reading mshrs from the configuration file\n");
+                return false;
+            }
         } else if (param == "coherence") {
             // Whether to simulate coherence
             std::string bool_val;
@@ -268,7 +311,8 @@ config_reader_t::configure_cache(cache_params_t &cache)
             }
         } else if (param == "replace_policy") {
             // Cache replacement policy: REPLACE_POLICY_LRU (default),
-            // REPLACE_POLICY_LFU or REPLACE_POLICY_FIFO.
+            // REPLACE_POLICY_LFU, REPLACE_POLICY_FIFO, REPLACE_POLICY_SRRIP,
+            // REPLACE_POLICY_BRRIP, REPLACE_POLICY_DRRIP or REPLACE_POLICY_SHIP.
             if (!(*fin_ >> cache.replace_policy)) {
                 ERRMSG("Error reading cache replace_policy from "
                        "the configuration file\n");
@@ -277,23 +321,37 @@ config_reader_t::configure_cache(cache_params_t &cache)
             if (cache.replace_policy != REPLACE_POLICY_NON_SPECIFIED &&
                 cache.replace_policy != REPLACE_POLICY_LRU &&
                 cache.replace_policy != REPLACE_POLICY_LFU &&
-                cache.replace_policy != REPLACE_POLICY_FIFO) {
+                cache.replace_policy != REPLACE_POLICY_FIFO &&
+                cache.replace_policy != REPLACE_POLICY_SRRIP &&
+                cache.replace_policy != REPLACE_POLICY_BRRIP &&
+                cache.replace_policy != REPLACE_POLICY_DRRIP &&
+                cache.replace_policy != REPLACE_POLICY_SHIP) {
                 ERRMSG("Unknown replacement policy: %s\n", cache.replace_policy.c_str());
                 return false;
             }
         } else if (param == "prefetcher") {
-            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE
-            // or PREFETCH_POLICY_NONE.
+            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE, PREFETCH_POLICY_STRIDE,
+            // PREFETCH_POLICY_STREAM, PREFETCH_POLICY_SPATIAL or PREFETCH_POLICY_NONE.
             if (!(*fin_ >> cache.prefetcher)) {
                 ERRMSG("Error reading cache prefetcher from "
                        "the configuration file\n");
                 return false;
             }
             if (cache.prefetcher != PREFETCH_POLICY_NEXTLINE &&
+                cache.prefetcher != PREFETCH_POLICY_STRIDE &&
+                cache.prefetcher != PREFETCH_POLICY_STREAM &&
+                cache.prefetcher != PREFETCH_POLICY_SPATIAL &&
                 cache.prefetcher != PREFETCH_POLICY_NONE) {
                 ERRMSG("Unknown prefetcher type: %s\n", cache.prefetcher.c_str());
                 return false;
             }
+        } else if (param == "latency") {
+            // Hit latency in cycles.
+            if (!(*fin_ >> cache.latency)) {
+                ERRMSG("Error reading cache latency from "
+                       "the configuration file\n");
+                return false;
+            }
         } else if (param == "miss_file") {
             // Name of the file to use to dump cache misses info.
             if (!(*fin_ >> cache.miss_file)) {
@@ -59,6 +59,7 @@ struct cache_params_t {
         , replace_policy(REPLACE_POLICY_LRU)
         , prefetcher(PREFETCH_POLICY_NONE)
         , miss_file("")
+        , latency(0)
     {
     }
     // Cache's name. Each cache must have a unique name.
@@ -88,6 +89,8 @@ struct cache_params_t {
     std::string prefetcher;
     // Name of the file to use to dump cache misses info.
     std::string miss_file;
+    // Hit latency in cycles when timing is modeled.
+    unsigned int latency;
 };
 
 class config_reader_t {
@@ -232,3 +232,11 @@ reader_t::operator++()
 
     return *this;
 }
+
+reader_t &
+reader_t::skip_memrefs(uint64_t count)
+{
+    for (; count > 0 && !at_eof_; --count)
+        ++(*this);
+    return *this;
+}
@@ -97,6 +97,12 @@ public:
     virtual reader_t &
     operator++();
 
+    // Advances past the next "count" records without returning them, stopping
+    // early at EOF.  The records are still decoded, as memref_t records do not
+    // map one-to-one onto trace entries, but no tool sees them.
+    virtual reader_t &
+    skip_memrefs(uint64_t count);
+
     // Supplied for subclasses that may fail in their constructors.
     virtual bool operator!()
     {
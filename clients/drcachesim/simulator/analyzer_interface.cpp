@@ -36,12 +36,14 @@
 #include "../common/utils.h"
 #include "cache_simulator_create.h"
 #include "tlb_simulator_create.h"
+#include "module_symbolizer.h"
 /* XXX i#2006: we include these here for now but it's undecided whether they
  * should be separated and this should only include
  * cache-simulation-based tools.
  */
 #include "../tools/histogram_create.h"
 #include "../tools/reuse_distance_create.h"
+#include "../tools/miss_ratio_curve_create.h"
 #include "../tools/reuse_time_create.h"
 #include "../tools/basic_counts_create.h"
 #include "../tools/opcode_mix_create.h"
@@ -51,6 +53,7 @@
 #include "../tracer/raw2trace.h"
 #include "../tracer/raw2trace_directory.h"
 #include <fstream>
+#include <memory>
 
 /* Get the path to an auxiliary file by examining
  * 1. The corresponding command line option
@@ -117,27 +120,86 @@ get_cache_simulator_knobs()
     knobs->LL_size = op_LL_size.get_value();
     knobs->LL_assoc = op_LL_assoc.get_value();
     knobs->LL_miss_file = op_LL_miss_file.get_value();
+    knobs->LL_sample_fraction = op_LL_sample_fraction.get_value();
     knobs->model_coherence = op_coherence.get_value();
+    knobs->parallel_cores = op_parallel_cores.get_value();
+    knobs->parallel_deterministic = op_parallel_deterministic.get_value();
+    knobs->parallel_epoch = op_parallel_epoch.get_value();
+    knobs->model_timing = op_timing.get_value();
+    knobs->L1I_latency = op_L1I_latency.get_value();
+    knobs->L1D_latency = op_L1D_latency.get_value();
+    knobs->LL_latency = op_LL_latency.get_value();
+    knobs->memory_latency = op_memory_latency.get_value();
+    knobs->memory_bandwidth = op_memory_bandwidth.get_value();
+    knobs->mshrs = op_mshrs.get_value();
     knobs->replace_policy = op_replace_policy.get_value();
     knobs->data_prefetcher = op_data_prefetcher.get_value();
+    knobs->prefetch_late_refs = op_prefetch_late_refs.get_value();
     knobs->skip_refs = op_skip_refs.get_value();
     knobs->warmup_refs = op_warmup_refs.get_value();
     knobs->warmup_fraction = op_warmup_fraction.get_value();
     knobs->sim_refs = op_sim_refs.get_value();
     knobs->verbose = op_verbose.get_value();
     knobs->cpu_scheduling = op_cpu_scheduling.get_value();
+    knobs->save_checkpoint = op_save_checkpoint.get_value();
+    knobs->restore_checkpoint = op_restore_checkpoint.get_value();
+    knobs->miss_attribution = op_miss_attribution.get_value();
     return knobs;
 }
 
 analysis_tool_t *
 drmemtrace_analysis_tool_create()
 {
+    if ((!op_save_checkpoint.get_value().empty() ||
+         !op_restore_checkpoint.get_value().empty()) &&
+        op_simulator_type.get_value() != CPU_CACHE &&
+        op_simulator_type.get_value() != MISS_ANALYZER &&
+        op_simulator_type.get_value() != TLB) {
+        ERRMSG("Usage error: checkpoints are only supported by the cache and TLB "
+               "simulators.\n");
+        return nullptr;
+    }
+    if (op_miss_attribution.get_value() > 0 &&
+        (op_simulator_type.get_value() != CPU_CACHE ||
+         !op_config_file.get_value().empty())) {
+        ERRMSG("Usage error: -miss_attribution is only supported by the cache "
+               "simulator without -config_file.\n");
+        return nullptr;
+    }
     if (op_simulator_type.get_value() == CPU_CACHE) {
         const std::string &config_file = op_config_file.get_value();
         if (!config_file.empty()) {
+            if (op_parallel_cores.get_value()) {
+                ERRMSG("Usage error: -parallel_cores is not supported with "
+                       "-config_file.\n");
+                return nullptr;
+            }
+            if (!op_save_checkpoint.get_value().empty() ||
+                !op_restore_checkpoint.get_value().empty()) {
+                ERRMSG("Usage error: checkpoints are not supported with "
+                       "-config_file.\n");
+                return nullptr;
+            }
             return cache_simulator_create(config_file);
         } else {
             cache_simulator_knobs_t *knobs = get_cache_simulator_knobs();
+            std::string module_file_path = get_module_file_path();
+            // Without a module list, as for online simulation, misses are
+            // attributed to bare instruction addresses.
+            if (knobs->miss_attribution > 0 && !module_file_path.empty() &&
+                (!op_module_file.get_value().empty() ||
+                 std::ifstream(module_file_path.c_str()).good())) {
+                auto symbolizer = std::make_shared<module_symbolizer_t>(
+                    module_file_path, op_alt_module_dir.get_value(),
+                    op_verbose.get_value());
+                std::string error = symbolizer->initialize();
+                if (!error.empty()) {
+                    ERRMSG("Usage error: failed to symbolize -miss_attribution: %s\n",
+                           error.c_str());
+                    return nullptr;
+                }
+                knobs->symbolizer = symbolizer;
+            }
             return cache_simulator_create(*knobs);
         }
     } else if (op_simulator_type.get_value() == MISS_ANALYZER) {
@@ -156,12 +218,19 @@ drmemtrace_analysis_tool_create()
         knobs.TLB_L2_entries = op_TLB_L2_entries.get_value();
         knobs.TLB_L2_assoc = op_TLB_L2_assoc.get_value();
         knobs.TLB_replace_policy = op_TLB_replace_policy.get_value();
+        knobs.page_size_file = op_TLB_page_sizes.get_value();
+        knobs.TLB_PWC_entries = op_TLB_PWC_entries.get_value();
+        knobs.TLB_walk_caches = op_TLB_walk_caches.get_value();
+        std::unique_ptr<cache_simulator_knobs_t> cache_knobs(get_cache_simulator_knobs());
+        knobs.cache_knobs = *cache_knobs;
         knobs.skip_refs = op_skip_refs.get_value();
         knobs.warmup_refs = op_warmup_refs.get_value();
         knobs.warmup_fraction = op_warmup_fraction.get_value();
         knobs.sim_refs = op_sim_refs.get_value();
         knobs.verbose = op_verbose.get_value();
         knobs.cpu_scheduling = op_cpu_scheduling.get_value();
+        knobs.save_checkpoint = op_save_checkpoint.get_value();
+        knobs.restore_checkpoint = op_restore_checkpoint.get_value();
         return tlb_simulator_create(knobs);
     } else if (op_simulator_type.get_value() == HISTOGRAM) {
         return histogram_tool_create(op_line_size.get_value(), op_report_top.get_value(),
@@ -176,6 +245,15 @@ drmemtrace_analysis_tool_create()
         knobs.verify_skip = op_reuse_verify_skip.get_value();
         knobs.verbose = op_verbose.get_value();
         return reuse_distance_tool_create(knobs);
+    } else if (op_simulator_type.get_value() == MISS_RATIO_CURVE) {
+        miss_ratio_curve_knobs_t knobs;
+        knobs.line_size = op_line_size.get_value();
+        knobs.min_size = op_mrc_min_size.get_value();
+        knobs.max_size = op_mrc_max_size.get_value();
+        knobs.max_assoc = op_mrc_max_assoc.get_value();
+        knobs.skip_list_distance = op_reuse_skip_dist.get_value();
+        knobs.verbose = op_verbose.get_value();
+        return miss_ratio_curve_tool_create(knobs);
     } else if (op_simulator_type.get_value() == REUSE_TIME) {
         return reuse_time_tool_create(op_line_size.get_value(), op_verbose.get_value());
     } else if (op_simulator_type.get_value() == BASIC_COUNTS) {
@@ -209,7 +287,8 @@ drmemtrace_analysis_tool_create()
     } else {
         ERRMSG("Usage error: unsupported analyzer type. "
                "Please choose " CPU_CACHE ", " MISS_ANALYZER ", " TLB ", " HISTOGRAM
-               ", " REUSE_DIST ", " BASIC_COUNTS ", " OPCODE_MIX ", " VIEW
+               ", " REUSE_DIST ", " MISS_RATIO_CURVE ", " BASIC_COUNTS ", " OPCODE_MIX
+               ", " VIEW
                " or " FUNC_VIEW ".\n");
         return nullptr;
     }
@@ -70,10 +70,10 @@ cache_t::flush(const memref_t &memref)
         compute_tag(memref.flush.addr + memref.flush.size - 1 /*no overflow*/);
     last_tag_ = TAG_INVALID;
     for (; tag <= final_tag; ++tag) {
-        auto block_way = find_caching_device_block(tag);
-        if (block_way.first == nullptr)
+        int way = find_caching_device_way(tag);
+        if (way < 0)
             continue;
-        invalidate_caching_device_block(block_way.first);
+        invalidate_caching_device_block(compute_block_idx(tag), way);
     }
     // We flush parent_'s code cache here.
     // XXX: should L1 data cache be flushed when L1 instr cache is flushed?
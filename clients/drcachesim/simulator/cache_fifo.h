@@ -48,6 +48,9 @@ public:
          const std::vector<caching_device_t *> &children = {}) override;
 
 protected:
+    // Allows caching_device_t's request path to call the hooks below non-virtually.
+    friend class caching_device_t;
+
     void
     access_update(int block_idx, int way) override;
     int
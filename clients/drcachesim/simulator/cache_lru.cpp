@@ -31,6 +31,7 @@
  */
 
 #include "cache_lru.h"
+#include "set_ops.h"
 
 // For LRU implementation, we use the cache line counter to represent
 // how recently a cache line is accessed.
@@ -56,7 +57,7 @@ cache_lru_t::init(int associativity, int block_size, int total_size,
     // Initialize line counters with 0, 1, 2, ..., associativity - 1.
     for (int i = 0; i < blocks_per_set_; i++) {
         for (int way = 0; way < associativity_; ++way) {
-            get_caching_device_block(i << assoc_bits_, way).counter_ = way;
+            get_counter(i << assoc_bits_, way) = way;
         }
     }
     return true;
@@ -65,17 +66,17 @@ cache_lru_t::init(int associativity, int block_size, int total_size,
 void
 cache_lru_t::access_update(int block_idx, int way)
 {
-    int cnt = get_caching_device_block(block_idx, way).counter_;
+    int *set_counters = &counters_[block_idx];
+    int cnt = set_counters[way];
     // Optimization: return early if it is a repeated access.
     if (cnt == 0)
         return;
     // We inc all the counters that are not larger than cnt for LRU.
-    for (int i = 0; i < associativity_; ++i) {
-        if (i != way && get_caching_device_block(block_idx, i).counter_ <= cnt)
-            get_caching_device_block(block_idx, i).counter_++;
-    }
+    // The accessed way itself is also incremented here and cleared below, which
+    // lets the whole set be updated with vector operations.
+    set_ops_->inc_counters_upto(set_counters, associativity_, cnt);
     // Clear the counter for LRU.
-    get_caching_device_block(block_idx, way).counter_ = 0;
+    set_counters[way] = 0;
 }
 
 int
@@ -87,18 +88,10 @@ cache_lru_t::replace_which_way(int block_idx)
 int
 cache_lru_t::get_next_way_to_replace(int block_idx) const
 {
-    // We implement LRU by picking the slot with the largest counter value.
-    int max_counter = 0;
-    int max_way = 0;
-    for (int way = 0; way < associativity_; ++way) {
-        if (get_caching_device_block(block_idx, way).tag_ == TAG_INVALID) {
-            max_way = way;
-            break;
-        }
-        if (get_caching_device_block(block_idx, way).counter_ > max_counter) {
-            max_counter = get_caching_device_block(block_idx, way).counter_;
-            max_way = way;
-        }
-    }
-    return max_way;
+    // We implement LRU by picking the slot with the largest counter value,
+    // unless there is an empty slot.
+    int invalid_way = set_ops_->find_tag(&tags_[block_idx], associativity_, TAG_INVALID);
+    if (invalid_way >= 0)
+        return invalid_way;
+    return set_ops_->find_max_counter(&counters_[block_idx], associativity_);
 }
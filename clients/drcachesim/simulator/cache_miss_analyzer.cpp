@@ -180,6 +180,7 @@ cache_miss_analyzer_t::generate_recommendations()
 bool
 cache_miss_analyzer_t::print_results()
 {
+    finish_parallel_simulation();
     std::vector<prefetching_recommendation_t *> recommendations =
         ll_stats_->generate_recommendations();
 
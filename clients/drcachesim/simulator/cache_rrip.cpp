@@ -0,0 +1,175 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "cache_rrip.h"
+#include "checkpoint.h"
+#include "set_ops.h"
+
+// For the RRIP implementations, we use the cache line counter to hold the
+// re-reference prediction value (RRPV) of the line: 0 predicts a near-immediate
+// re-reference and RRPV_MAX a distant one.  A hit sets the value to 0.  The victim
+// is the first way predicted to be re-referenced in the distant future; if there is
+// none, every line in the set is aged until there is.  A new line starts with
+// RRPV_MAX - 1 under SRRIP, which lets lines that are reused soon after insertion
+// survive scans, and mostly with RRPV_MAX under BRRIP, which keeps most of a
+// working set that is larger than the cache from thrashing.  DRRIP dedicates a few
+// leader sets to each of the two and lets the one with fewer misses there pick the
+// insertion for the remaining follower sets.
+
+cache_rrip_t::cache_rrip_t(rrip_mode_t mode)
+    : mode_(mode)
+{
+}
+
+bool
+cache_rrip_t::init(int associativity, int block_size, int total_size,
+                   caching_device_t *parent, caching_device_stats_t *stats,
+                   prefetcher_t *prefetcher, bool inclusive, bool coherent_cache, int id,
+                   snoop_filter_t *snoop_filter,
+                   const std::vector<caching_device_t *> &children)
+{
+    bool ret_val =
+        cache_t::init(associativity, block_size, total_size, parent, stats, prefetcher,
+                      inclusive, coherent_cache, id, snoop_filter, children);
+    if (ret_val == false)
+        return false;
+
+    insert_idx_ = -1;
+    bimodal_insertions_ = 0;
+    psel_ = (1 << PSEL_BITS) / 2 - 1;
+    set_roles_.clear();
+    if (mode_ == RRIP_DYNAMIC) {
+        // Spread the leader sets evenly over the index space, keeping the two kinds
+        // apart.  Caches with fewer than 4 sets are left with too few sets for any
+        // followers and so behave mostly like SRRIP.
+        int stride = blocks_per_set_ / NUM_LEADER_SETS;
+        if (stride < 4)
+            stride = 4;
+        set_roles_.resize(blocks_per_set_, SET_FOLLOWER);
+        for (int set = 0; set < blocks_per_set_; ++set) {
+            if (set % stride == 0)
+                set_roles_[set] = SET_LEADER_STATIC;
+            else if (set % stride == stride / 2)
+                set_roles_[set] = SET_LEADER_BIMODAL;
+        }
+    }
+    return true;
+}
+
+int
+cache_rrip_t::rrip_insertion_value(int block_idx)
+{
+    bool bimodal = mode_ == RRIP_BIMODAL;
+    if (mode_ == RRIP_DYNAMIC) {
+        const int psel_max = (1 << PSEL_BITS) - 1;
+        switch (set_roles_[block_idx >> assoc_bits_]) {
+        case SET_LEADER_STATIC:
+            if (psel_ < psel_max)
+                ++psel_;
+            bimodal = false;
+            break;
+        case SET_LEADER_BIMODAL:
+            if (psel_ > 0)
+                --psel_;
+            bimodal = true;
+            break;
+        default:
+            // A high selector means the SRRIP leaders are missing more.
+            bimodal = psel_ > psel_max / 2;
+            break;
+        }
+    }
+    if (bimodal && ++bimodal_insertions_ % BRRIP_LONG_INTERVAL != 0)
+        return RRPV_MAX;
+    return RRPV_MAX - 1;
+}
+
+void
+cache_rrip_t::access_update(int block_idx, int way)
+{
+    int idx = block_idx + way;
+    if (idx == insert_idx_) {
+        counters_[idx] = insert_rrpv_;
+        insert_idx_ = -1;
+    } else
+        counters_[idx] = 0;
+}
+
+int
+cache_rrip_t::replace_which_way(int block_idx)
+{
+    int victim_way = get_next_way_to_replace(block_idx);
+    if (get_tag(block_idx, victim_way) != TAG_INVALID) {
+        // Age the whole set until the victim is predicted to be distant.
+        int delta = RRPV_MAX - get_counter(block_idx, victim_way);
+        if (delta > 0) {
+            int *set_counters = &counters_[block_idx];
+            for (int way = 0; way < associativity_; ++way)
+                set_counters[way] += delta;
+        }
+    }
+    insert_idx_ = block_idx + victim_way;
+    insert_rrpv_ = rrip_insertion_value(block_idx);
+    return victim_way;
+}
+
+int
+cache_rrip_t::get_next_way_to_replace(const int block_idx) const
+{
+    int invalid_way = set_ops_->find_tag(&tags_[block_idx], associativity_, TAG_INVALID);
+    if (invalid_way >= 0)
+        return invalid_way;
+    // Aging preserves the order of the values, so the first way with the largest
+    // one is the first to reach RRPV_MAX.
+    return set_ops_->find_max_counter(&counters_[block_idx], associativity_);
+}
+
+void
+cache_rrip_t::save_state(checkpoint_writer_t &out) const
+{
+    cache_t::save_state(out);
+    out.write(mode_);
+    out.write(bimodal_insertions_);
+    out.write(psel_);
+}
+
+bool
+cache_rrip_t::restore_state(checkpoint_reader_t &in)
+{
+    if (!cache_t::restore_state(in))
+        return false;
+    in.expect(mode_);
+    in.read(bimodal_insertions_);
+    in.read(psel_);
+    insert_idx_ = -1;
+    return !!in;
+}
@@ -0,0 +1,107 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* cache_rrip: represents a single hardware cache with one of the re-reference
+ * interval prediction (RRIP) algos: SRRIP, BRRIP, or DRRIP.
+ */
+
+#ifndef _CACHE_RRIP_H_
+#define _CACHE_RRIP_H_ 1
+
+#include "cache.h"
+
+enum rrip_mode_t {
+    RRIP_STATIC,  // SRRIP: insert with a long re-reference interval.
+    RRIP_BIMODAL, // BRRIP: insert mostly with a distant re-reference interval.
+    RRIP_DYNAMIC, // DRRIP: choose between the two by set dueling.
+};
+
+class cache_rrip_t : public cache_t {
+public:
+    explicit cache_rrip_t(rrip_mode_t mode = RRIP_STATIC);
+    bool
+    init(int associativity, int line_size, int total_size, caching_device_t *parent,
+         caching_device_stats_t *stats, prefetcher_t *prefetcher, bool inclusive = false,
+         bool coherent_cache = false, int id_ = -1,
+         snoop_filter_t *snoop_filter_ = nullptr,
+         const std::vector<caching_device_t *> &children = {}) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // The re-reference prediction values are 2 bits wide.
+    static const int RRPV_MAX = 3;
+    // A bimodal insertion uses a long rather than a distant interval once every
+    // this many insertions.
+    static const int BRRIP_LONG_INTERVAL = 32;
+    // Set dueling uses up to this many leader sets for each of SRRIP and BRRIP,
+    // and a saturating policy selector of this many bits.
+    static const int NUM_LEADER_SETS = 32;
+    static const int PSEL_BITS = 10;
+
+protected:
+    // Allows caching_device_t's request path to call the hooks below non-virtually.
+    friend class caching_device_t;
+
+    void
+    access_update(int block_idx, int way) override;
+    int
+    replace_which_way(int block_idx) override;
+    int
+    get_next_way_to_replace(const int block_idx) const override;
+
+    // Returns the prediction value a block inserted into the set at block_idx
+    // receives under the configured mode, updating the dueling state for a miss.
+    int
+    rrip_insertion_value(int block_idx);
+
+    enum set_role_t {
+        SET_FOLLOWER,
+        SET_LEADER_STATIC,
+        SET_LEADER_BIMODAL,
+    };
+
+    rrip_mode_t mode_;
+    // The block that replace_which_way() picked for the current miss and the
+    // prediction value it is to receive when access_update() is called for it.
+    int insert_idx_ = -1;
+    int insert_rrpv_ = 0;
+    // Counts bimodal insertions.
+    unsigned int bimodal_insertions_ = 0;
+    // For DRRIP: the role of each set, indexed by block_idx >> assoc_bits_, and the
+    // policy selector, which leader-set misses move toward the other policy.
+    std::vector<char> set_roles_;
+    int psel_ = 0;
+};
+
+#endif /* _CACHE_RRIP_H_ */
@@ -0,0 +1,130 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "cache_ship.h"
+#include "checkpoint.h"
+#include "../common/trace_entry.h"
+
+// SHiP predicts whether a new line will be reused from the PC of the instruction
+// that brings it in.  Each line remembers a hash of that PC, its signature, and
+// whether it was hit.  A hit increments the signature's counter in the signature
+// history counter table (SHCT) and an eviction of a line that was never hit
+// decrements it.  A line whose signature's counter is 0 is predicted dead and is
+// inserted with a distant re-reference prediction value; all others are inserted
+// as under SRRIP.  The other RRIP behavior is inherited from cache_rrip_t.
+
+cache_ship_t::cache_ship_t()
+    : cache_rrip_t(RRIP_STATIC)
+{
+}
+
+bool
+cache_ship_t::init(int associativity, int block_size, int total_size,
+                   caching_device_t *parent, caching_device_stats_t *stats,
+                   prefetcher_t *prefetcher, bool inclusive, bool coherent_cache, int id,
+                   snoop_filter_t *snoop_filter,
+                   const std::vector<caching_device_t *> &children)
+{
+    bool ret_val =
+        cache_rrip_t::init(associativity, block_size, total_size, parent, stats,
+                           prefetcher, inclusive, coherent_cache, id, snoop_filter,
+                           children);
+    if (ret_val == false)
+        return false;
+    signatures_.assign(num_blocks_, 0);
+    reused_.assign(num_blocks_, 0);
+    // Start every signature one step above the dead prediction.
+    shct_.assign(1 << SIGNATURE_BITS, 1);
+    return true;
+}
+
+void
+cache_ship_t::request(const memref_t &memref)
+{
+    // Parent caches are passed the same memref and so see the same PC.
+    if (type_is_instr(memref.instr.type))
+        request_pc_ = memref.instr.addr;
+    else
+        request_pc_ = memref.data.pc;
+    cache_rrip_t::request(memref);
+}
+
+void
+cache_ship_t::access_update(int block_idx, int way)
+{
+    int idx = block_idx + way;
+    if (idx != insert_idx_) {
+        uint8_t &counter = shct_[signatures_[idx]];
+        if (counter < SHCT_MAX)
+            ++counter;
+        reused_[idx] = 1;
+    }
+    cache_rrip_t::access_update(block_idx, way);
+}
+
+int
+cache_ship_t::replace_which_way(int block_idx)
+{
+    int victim_way = cache_rrip_t::replace_which_way(block_idx);
+    int idx = block_idx + victim_way;
+    if (get_tag(block_idx, victim_way) != TAG_INVALID && !reused_[idx]) {
+        uint8_t &counter = shct_[signatures_[idx]];
+        if (counter > 0)
+            --counter;
+    }
+    uint16_t signature = compute_signature(request_pc_);
+    signatures_[idx] = signature;
+    reused_[idx] = 0;
+    if (shct_[signature] == 0)
+        insert_rrpv_ = RRPV_MAX;
+    return victim_way;
+}
+
+void
+cache_ship_t::save_state(checkpoint_writer_t &out) const
+{
+    cache_rrip_t::save_state(out);
+    out.write_vector(signatures_);
+    out.write_vector(reused_);
+    out.write_vector(shct_);
+}
+
+bool
+cache_ship_t::restore_state(checkpoint_reader_t &in)
+{
+    if (!cache_rrip_t::restore_state(in))
+        return false;
+    in.read_array(signatures_.data(), signatures_.size());
+    in.read_array(reused_.data(), reused_.size());
+    in.read_array(shct_.data(), shct_.size());
+    return !!in;
+}
@@ -0,0 +1,87 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* cache_ship: represents a single hardware cache with the signature-based hit
+ * predictor (SHiP) algo layered on SRRIP.
+ */
+
+#ifndef _CACHE_SHIP_H_
+#define _CACHE_SHIP_H_ 1
+
+#include <stdint.h>
+#include "cache_rrip.h"
+
+class cache_ship_t : public cache_rrip_t {
+public:
+    cache_ship_t();
+    bool
+    init(int associativity, int line_size, int total_size, caching_device_t *parent,
+         caching_device_stats_t *stats, prefetcher_t *prefetcher, bool inclusive = false,
+         bool coherent_cache = false, int id_ = -1,
+         snoop_filter_t *snoop_filter_ = nullptr,
+         const std::vector<caching_device_t *> &children = {}) override;
+    void
+    request(const memref_t &memref) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // The signature history counter table is indexed by a hash of the inserting
+    // PC of this many bits and holds saturating counters of up to SHCT_MAX.
+    static const int SIGNATURE_BITS = 14;
+    static const int SHCT_MAX = 7;
+
+protected:
+    void
+    access_update(int block_idx, int way) override;
+    int
+    replace_which_way(int block_idx) override;
+
+    inline uint16_t
+    compute_signature(addr_t pc) const
+    {
+        return static_cast<uint16_t>((pc ^ (pc >> SIGNATURE_BITS) ^
+                                      (pc >> (2 * SIGNATURE_BITS))) &
+                                     ((1 << SIGNATURE_BITS) - 1));
+    }
+
+    // The PC of the instruction behind the request being simulated.
+    addr_t request_pc_ = 0;
+    // Per-block signature of the inserting PC and whether the block has been hit
+    // since it was inserted, indexed by block_idx + way.
+    std::vector<uint16_t> signatures_;
+    std::vector<uint8_t> reused_;
+    std::vector<uint8_t> shct_;
+};
+
+#endif /* _CACHE_SHIP_H_ */
@@ -30,9 +30,15 @@
  * DAMAGE.
  */
 
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <assert.h>
 #include <limits.h>
 #include <stdint.h> /* for supporting 64-bit integers*/
@@ -46,6 +52,13 @@
 #include "cache.h"
 #include "cache_lru.h"
 #include "cache_fifo.h"
+#include "cache_rrip.h"
+#include "cache_ship.h"
+#include "checkpoint.h"
+#include "pc_symbolizer.h"
+#include "prefetcher_spatial.h"
+#include "prefetcher_stream.h"
+#include "prefetcher_stride.h"
 #include "cache_simulator.h"
 #include "droption.h"
 
@@ -71,6 +84,16 @@ cache_simulator_create(const std::string &config_file)
     return sim;
 }
 
+static const char *const CHECKPOINT_KIND = "cache";
+
+static bool
+is_prefetch_policy(const std::string &policy)
+{
+    return policy == PREFETCH_POLICY_NEXTLINE || policy == PREFETCH_POLICY_STRIDE ||
+        policy == PREFETCH_POLICY_STREAM || policy == PREFETCH_POLICY_SPATIAL ||
+        policy == PREFETCH_POLICY_NONE;
+}
+
 cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
     : simulator_t(knobs.num_cores, knobs.skip_refs, knobs.warmup_refs,
                   knobs.warmup_fraction, knobs.sim_refs, knobs.cpu_scheduling,
@@ -78,6 +101,7 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
     , knobs_(knobs)
     , l1_icaches_(NULL)
     , l1_dcaches_(NULL)
+    , snooped_caches_(NULL)
     , is_warmed_up_(false)
 {
     // XXX i#1703: get defaults from hardware being run on.
@@ -94,15 +118,41 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
     all_caches_[cache_name] = llc;
     llcaches_[cache_name] = llc;
 
-    if (knobs_.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs_.data_prefetcher != PREFETCH_POLICY_NONE) {
+    if (knobs_.parallel_cores && knobs_.model_coherence) {
+        error_string_ = "Usage error: -parallel_cores does not support -coherence";
+        success_ = false;
+        return;
+    }
+    if (knobs_.parallel_cores && knobs_.model_timing) {
+        error_string_ = "Usage error: -parallel_cores does not support -timing";
+        success_ = false;
+        return;
+    }
+
+    if (!is_prefetch_policy(knobs_.data_prefetcher)) {
         // Unknown value.
         error_string_ = " unknown data_prefetcher: '" + knobs_.data_prefetcher + "'";
         success_ = false;
         return;
     }
 
-    bool warmup_enabled_ = ((knobs_.warmup_refs > 0) || (knobs_.warmup_fraction > 0.0));
+    if (!knobs_.save_checkpoint.empty() && knobs_.warmup_refs == 0 &&
+        knobs_.warmup_fraction == 0.0) {
+        error_string_ = "Usage error: -save_checkpoint requires -warmup_refs or "
+                        "-warmup_fraction";
+        success_ = false;
+        return;
+    }
+    if (!knobs_.save_checkpoint.empty() && !knobs_.restore_checkpoint.empty()) {
+        error_string_ =
+            "Usage error: -save_checkpoint and -restore_checkpoint are exclusive";
+        success_ = false;
+        return;
+    }
+
+    // A restored checkpoint carries the warmup statistics.
+    bool warmup_enabled_ = ((knobs_.warmup_refs > 0) || (knobs_.warmup_fraction > 0.0) ||
+                            !knobs_.restore_checkpoint.empty());
 
     if (!llc->init(knobs_.LL_assoc, (int)knobs_.line_size, (int)knobs_.LL_size, NULL,
                    new cache_stats_t((int)knobs_.line_size, knobs_.LL_miss_file,
@@ -114,6 +164,8 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
         success_ = false;
         return;
     }
+    if (knobs_.LL_sample_fraction < 1.0)
+        llc->set_sampling(knobs_.LL_sample_fraction);
 
     l1_icaches_ = new cache_t *[knobs_.num_cores];
     l1_dcaches_ = new cache_t *[knobs_.num_cores];
@@ -149,9 +201,7 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
                 knobs_.L1D_assoc, (int)knobs_.line_size, (int)knobs_.L1D_size, llc,
                 new cache_stats_t((int)knobs_.line_size, "", warmup_enabled_,
                                   knobs_.model_coherence),
-                knobs_.data_prefetcher == PREFETCH_POLICY_NEXTLINE
-                    ? new prefetcher_t((int)knobs_.line_size)
-                    : nullptr,
+                create_prefetcher(knobs_.data_prefetcher),
                 false /*inclusive*/, knobs_.model_coherence, (2 * i) + 1,
                 snoop_filter_)) {
             error_string_ = "Usage error: failed to initialize L1 caches.  Ensure sizes "
@@ -173,6 +223,27 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs)
         success_ = false;
         return;
     }
+
+    if (knobs_.model_timing) {
+        timing_.reset(new timing_model_t(knobs_.num_cores, knobs_.mshrs,
+                                         knobs_.memory_latency, knobs_.memory_bandwidth,
+                                         knobs_.line_size));
+        llc->set_timing(timing_.get(), knobs_.LL_latency);
+        for (unsigned int i = 0; i < knobs_.num_cores; i++) {
+            l1_icaches_[i]->set_timing(timing_.get(), knobs_.L1I_latency);
+            l1_dcaches_[i]->set_timing(timing_.get(), knobs_.L1D_latency);
+        }
+    }
+
+    if (knobs_.miss_attribution > 0) {
+        for (auto &caches_it : all_caches_)
+            caches_it.second->get_stats()->enable_pc_attribution();
+    }
+
+    if (!knobs_.restore_checkpoint.empty() && !read_checkpoint(knobs_.restore_checkpoint)) {
+        success_ = false;
+        return;
+    }
 }
 
 cache_simulator_t::cache_simulator_t(std::istream *config_file)
@@ -194,9 +265,10 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file)
     init_knobs(knobs_.num_cores, knobs_.skip_refs, knobs_.warmup_refs,
                knobs_.warmup_fraction, knobs_.sim_refs, knobs_.cpu_scheduling,
                knobs_.verbose);
+    // Arbitrary hierarchies may share caches below the LLC.
+    knobs_.parallel_cores = false;
 
-    if (knobs_.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs_.data_prefetcher != PREFETCH_POLICY_NONE) {
+    if (!is_prefetch_policy(knobs_.data_prefetcher)) {
         // Unknown prefetcher type.
         success_ = false;
         return;
@@ -319,9 +391,7 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file)
                          (int)cache_config.size, parent_,
                          new cache_stats_t((int)knobs_.line_size, cache_config.miss_file,
                                            warmup_enabled_, is_coherent_),
-                         cache_config.prefetcher == PREFETCH_POLICY_NEXTLINE
-                             ? new prefetcher_t((int)knobs_.line_size)
-                             : nullptr,
+                         create_prefetcher(cache_config.prefetcher),
                          cache_config.inclusive, is_coherent_, is_snooped ? snoop_id : -1,
                          is_snooped ? snoop_filter_ : nullptr, children)) {
             error_string_ = "Usage error: failed to initialize the cache " + cache_name;
@@ -366,6 +436,15 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file)
         success_ = false;
         return;
     }
+    if (knobs_.model_timing) {
+        timing_.reset(new timing_model_t(knobs_.num_cores, knobs_.mshrs,
+                                         knobs_.memory_latency, knobs_.memory_bandwidth,
+                                         knobs_.line_size));
+        for (auto &cache_it : all_caches_) {
+            cache_it.second->set_timing(timing_.get(),
+                                        cache_params.find(cache_it.first)->second.latency);
+        }
+    }
     // For larger hierarchies, especially with coherence, using hashtables
     // for faster lookups provides performance wins as high as 15%.
     // However, hashtables can slow down smaller hierarchies, so we only
@@ -379,6 +458,8 @@ cache_simulator_t::cache_simulator_t(std::istream *config_file)
 
 cache_simulator_t::~cache_simulator_t()
 {
+    // Stop the core threads before deleting the caches they use.
+    parallel_sim_.reset();
     for (auto &caches_it : all_caches_) {
         cache_t *cache = caches_it.second;
         delete cache->get_stats();
@@ -409,6 +490,7 @@ cache_simulator_t::remaining_sim_refs() const
 bool
 cache_simulator_t::process_memref(const memref_t &memref)
 {
+    ++trace_position_;
     if (knobs_.skip_refs > 0) {
         knobs_.skip_refs--;
         return true;
@@ -452,6 +534,19 @@ cache_simulator_t::process_memref(const memref_t &memref)
         last_core_ = core;
     }
 
+    // Stats are reset at the end of warmup, so we only start the core threads once
+    // warmup has completed.
+    if (knobs_.parallel_cores && !parallel_sim_done_ && parallel_sim_ == nullptr &&
+        (is_warmed_up_ || (knobs_.warmup_refs == 0 && knobs_.warmup_fraction == 0.0))) {
+        parallel_sim_.reset(new parallel_cache_sim_t(knobs_.parallel_deterministic,
+                                                     knobs_.parallel_epoch));
+        if (!parallel_sim_->init(l1_icaches_, l1_dcaches_, knobs_.num_cores,
+                                 llcaches_["LL"], error_string_)) {
+            parallel_sim_.reset();
+            return false;
+        }
+    }
+
     if (type_is_instr(memref.instr.type) ||
         memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
         if (knobs_.verbose >= 3) {
@@ -459,7 +554,14 @@ cache_simulator_t::process_memref(const memref_t &memref)
                       << " @" << (void *)memref.instr.addr << " instr x"
                       << memref.instr.size << "\n";
         }
-        l1_icaches_[core]->request(memref);
+        if (parallel_sim_ != nullptr) {
+            parallel_sim_->add(core, parallel_cache_sim_t::WORK_ICACHE_REQUEST, memref);
+        } else if (timing_ != nullptr) {
+            timing_->start_access(core, l1_icaches_[core]->get_latency());
+            l1_icaches_[core]->request(memref);
+            timing_->finish_access(memref);
+        } else
+            l1_icaches_[core]->request(memref);
     } else if (memref.data.type == TRACE_TYPE_READ ||
                memref.data.type == TRACE_TYPE_WRITE ||
                // We may potentially handle prefetches differently.
@@ -471,21 +573,34 @@ cache_simulator_t::process_memref(const memref_t &memref)
                       << trace_type_names[memref.data.type] << " "
                       << (void *)memref.data.addr << " x" << memref.data.size << "\n";
         }
-        l1_dcaches_[core]->request(memref);
+        if (parallel_sim_ != nullptr) {
+            parallel_sim_->add(core, parallel_cache_sim_t::WORK_DCACHE_REQUEST, memref);
+        } else if (timing_ != nullptr) {
+            timing_->start_access(core, l1_dcaches_[core]->get_latency());
+            l1_dcaches_[core]->request(memref);
+            timing_->finish_access(memref);
+        } else
+            l1_dcaches_[core]->request(memref);
     } else if (memref.flush.type == TRACE_TYPE_INSTR_FLUSH) {
         if (knobs_.verbose >= 3) {
             std::cerr << "::" << memref.data.pid << "." << memref.data.tid << ":: "
                       << " @" << (void *)memref.data.pc << " iflush "
                       << (void *)memref.data.addr << " x" << memref.data.size << "\n";
         }
-        l1_icaches_[core]->flush(memref);
+        if (parallel_sim_ != nullptr) {
+            parallel_sim_->add(core, parallel_cache_sim_t::WORK_ICACHE_FLUSH, memref);
+        } else
+            l1_icaches_[core]->flush(memref);
     } else if (memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
         if (knobs_.verbose >= 3) {
             std::cerr << "::" << memref.data.pid << "." << memref.data.tid << ":: "
                       << " @" << (void *)memref.data.pc << " dflush "
                       << (void *)memref.data.addr << " x" << memref.data.size << "\n";
         }
-        l1_dcaches_[core]->flush(memref);
+        if (parallel_sim_ != nullptr) {
+            parallel_sim_->add(core, parallel_cache_sim_t::WORK_DCACHE_FLUSH, memref);
+        } else
+            l1_dcaches_[core]->flush(memref);
     } else if (memref.exit.type == TRACE_TYPE_THREAD_EXIT) {
         handle_thread_exit(memref.exit.tid);
         last_thread_ = 0;
@@ -503,13 +618,12 @@ cache_simulator_t::process_memref(const memref_t &memref)
 
     // reset cache stats when warming up is completed
     if (!is_warmed_up_ && check_warmed_up()) {
-        for (auto &cache_it : all_caches_) {
-            cache_t *cache = cache_it.second;
-            cache->get_stats()->reset();
-        }
+        reset_stats();
         if (knobs_.verbose >= 1) {
             std::cerr << "Cache simulation warmed up\n";
         }
+        if (!knobs_.save_checkpoint.empty() && !write_checkpoint(knobs_.save_checkpoint))
+            return false;
     } else {
         knobs_.sim_refs--;
     }
@@ -517,6 +631,105 @@ cache_simulator_t::process_memref(const memref_t &memref)
     return true;
 }
 
+void
+cache_simulator_t::reset_stats()
+{
+    for (auto &cache_it : all_caches_) {
+        cache_t *cache = cache_it.second;
+        cache->get_stats()->reset();
+    }
+    if (timing_ != nullptr)
+        timing_->reset();
+}
+
+void
+cache_simulator_t::save_state(checkpoint_writer_t &out) const
+{
+    save_schedule(out);
+    // Caches are written in name order so that equal states give equal files.
+    std::vector<std::string> names;
+    for (const auto &cache_it : all_caches_)
+        names.push_back(cache_it.first);
+    std::sort(names.begin(), names.end());
+    out.write<uint64_t>(names.size());
+    for (const std::string &name : names) {
+        out.write_string(name);
+        all_caches_.at(name)->save_state(out);
+    }
+    out.write(snoop_filter_ != nullptr);
+    if (snoop_filter_ != nullptr)
+        snoop_filter_->save_state(out);
+}
+
+bool
+cache_simulator_t::restore_state(checkpoint_reader_t &in)
+{
+    if (!restore_schedule(in))
+        return false;
+    uint64_t count;
+    in.read(count);
+    if (!in || count != all_caches_.size())
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        in.read_string(name);
+        auto cache_it = all_caches_.find(name);
+        if (!in || cache_it == all_caches_.end() || !cache_it->second->restore_state(in))
+            return false;
+    }
+    in.expect(snoop_filter_ != nullptr);
+    if (!in || (snoop_filter_ != nullptr && !snoop_filter_->restore_state(in)))
+        return false;
+    return true;
+}
+
+bool
+cache_simulator_t::write_checkpoint(const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    checkpoint_writer_t writer(out);
+    writer.write_header(CHECKPOINT_KIND, trace_position_);
+    save_state(writer);
+    out.flush();
+    if (!out.is_open() || !writer) {
+        error_string_ = "Failed to write checkpoint " + path;
+        return false;
+    }
+    if (knobs_.verbose >= 1)
+        std::cerr << "Wrote checkpoint " << path << " at record " << trace_position_
+                  << "\n";
+    return true;
+}
+
+bool
+cache_simulator_t::read_checkpoint(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        error_string_ = "Failed to open checkpoint " + path;
+        return false;
+    }
+    checkpoint_reader_t reader(in);
+    uint64_t position;
+    std::string error;
+    if (!reader.read_header(CHECKPOINT_KIND, position, error)) {
+        error_string_ = "Failed to read checkpoint " + path + ": " + error;
+        return false;
+    }
+    if (!restore_state(reader)) {
+        error_string_ = "Checkpoint " + path +
+            " does not match the simulated cache hierarchy or is truncated";
+        return false;
+    }
+    // The reader skips the records up to the checkpoint, including the warmup.
+    trace_position_ = position;
+    knobs_.skip_refs = 0;
+    knobs_.warmup_refs = 0;
+    knobs_.warmup_fraction = 0.0;
+    is_warmed_up_ = true;
+    return true;
+}
+
 // Return true if the number of warmup references have been executed or if
 // specified fraction of the llcaches_ has been loaded. Also return true if the
 // cache has already been warmed up. When there are multiple last level caches
@@ -558,9 +771,20 @@ cache_simulator_t::check_warmed_up()
     return false;
 }
 
+void
+cache_simulator_t::finish_parallel_simulation()
+{
+    if (parallel_sim_ == nullptr)
+        return;
+    parallel_sim_->finish();
+    parallel_sim_.reset();
+    parallel_sim_done_ = true;
+}
+
 bool
 cache_simulator_t::print_results()
 {
+    finish_parallel_simulation();
     std::cerr << "Cache simulation results:\n";
     // Print core and associated L1 cache stats first.
     for (unsigned int i = 0; i < knobs_.num_cores; i++) {
@@ -575,6 +799,10 @@ cache_simulator_t::print_results()
                 std::cerr << "  unified L1 stats:" << std::endl;
                 l1_icaches_[i]->get_stats()->print_stats("    ");
             }
+            if (timing_ != nullptr) {
+                std::cerr << "  Timing:" << std::endl;
+                timing_->print_results(i, "    ");
+            }
         }
     }
 
@@ -594,9 +822,100 @@ cache_simulator_t::print_results()
         snoop_filter_->print_stats();
     }
 
+    if (knobs_.miss_attribution > 0)
+        print_miss_attribution();
+
     return true;
 }
 
+void
+cache_simulator_t::print_miss_attribution()
+{
+    // We merge the private caches of each level across cores.
+    std::vector<std::pair<std::string, std::vector<cache_t *>>> levels;
+    if (l1_icaches_[0] != l1_dcaches_[0]) {
+        levels.emplace_back("L1I", std::vector<cache_t *>());
+        levels.emplace_back("L1D", std::vector<cache_t *>());
+        for (unsigned int i = 0; i < knobs_.num_cores; i++) {
+            levels[0].second.push_back(l1_icaches_[i]);
+            levels[1].second.push_back(l1_dcaches_[i]);
+        }
+    } else {
+        levels.emplace_back("L1", std::vector<cache_t *>(l1_icaches_,
+                                                         l1_icaches_ + knobs_.num_cores));
+    }
+    for (auto *caches : { &other_caches_, &llcaches_ }) {
+        std::map<std::string, cache_t *> sorted(caches->begin(), caches->end());
+        for (auto &caches_it : sorted)
+            levels.emplace_back(caches_it.first, std::vector<cache_t *>(1, caches_it.second));
+    }
+    // Each instruction is symbolized once, however many levels it misses in.
+    std::unordered_map<addr_t, std::string> names;
+    auto name_of = [&](addr_t pc) -> const std::string & {
+        auto it = names.find(pc);
+        if (it != names.end())
+            return it->second;
+        std::string module, function;
+        if (knobs_.symbolizer != nullptr)
+            knobs_.symbolizer->lookup(pc, module, function);
+        std::string name;
+        if (!module.empty())
+            name = module + "!" + (function.empty() ? "<unknown>" : function);
+        return names.emplace(pc, name).first->second;
+    };
+    auto by_count = [](const std::pair<std::string, int_least64_t> &a,
+                       const std::pair<std::string, int_least64_t> &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    };
+
+    std::cerr.imbue(std::locale(""));
+    std::cerr << "Miss attribution:" << std::endl;
+    for (auto &level : levels) {
+        std::unordered_map<addr_t, int_least64_t> pc_counts;
+        int_least64_t total = 0;
+        for (cache_t *cache : level.second) {
+            cache->get_stats()->get_pc_misses()->for_each(
+                [&](addr_t pc, int_least64_t count) {
+                    pc_counts[pc] += count;
+                    total += count;
+                });
+        }
+        if (total == 0)
+            continue;
+        std::vector<std::pair<std::string, int_least64_t>> pcs;
+        std::unordered_map<std::string, int_least64_t> function_counts;
+        for (auto &pc_it : pc_counts) {
+            std::ostringstream pc_str;
+            pc_str << "0x" << std::hex << std::setfill('0') << std::setw(16)
+                   << pc_it.first;
+            const std::string &name = name_of(pc_it.first);
+            if (!name.empty()) {
+                pc_str << " " << name;
+                function_counts[name] += pc_it.second;
+            }
+            pcs.emplace_back(pc_str.str(), pc_it.second);
+        }
+        std::vector<std::pair<std::string, int_least64_t>> functions(
+            function_counts.begin(), function_counts.end());
+        for (auto *list : { &pcs, &functions }) {
+            if (list->empty())
+                continue;
+            size_t top = std::min<size_t>(knobs_.miss_attribution, list->size());
+            std::partial_sort(list->begin(), list->begin() + top, list->end(),
+                              by_count);
+            std::cerr << "  " << level.first << " misses by "
+                      << (list == &pcs ? "instruction" : "function") << ":" << std::endl;
+            for (size_t i = 0; i < top; ++i) {
+                std::cerr << "    " << std::setw(12) << std::right << (*list)[i].second
+                          << std::setw(8) << std::fixed << std::setprecision(2)
+                          << ((float)(*list)[i].second * 100 / total) << "%  "
+                          << (*list)[i].first << std::endl;
+            }
+        }
+    }
+    std::cerr.imbue(std::locale("C"));
+}
+
 // All valid metrics are returned as a positive number.
 // Negative return value is an error and is of type stats_error_t.
 int_least64_t
@@ -648,9 +967,35 @@ cache_simulator_t::create_cache(const std::string &policy)
         return new cache_t;
     if (policy == REPLACE_POLICY_FIFO) // set to FIFO
         return new cache_fifo_t;
+    if (policy == REPLACE_POLICY_SRRIP)
+        return new cache_rrip_t(RRIP_STATIC);
+    if (policy == REPLACE_POLICY_BRRIP)
+        return new cache_rrip_t(RRIP_BIMODAL);
+    if (policy == REPLACE_POLICY_DRRIP)
+        return new cache_rrip_t(RRIP_DYNAMIC);
+    if (policy == REPLACE_POLICY_SHIP)
+        return new cache_ship_t;
 
     // undefined replacement policy
     ERRMSG("Usage error: undefined replacement policy. "
-           "Please choose " REPLACE_POLICY_LRU " or " REPLACE_POLICY_LFU ".\n");
+           "Please choose " REPLACE_POLICY_LRU ", " REPLACE_POLICY_LFU
+           ", " REPLACE_POLICY_FIFO ", " REPLACE_POLICY_SRRIP ", " REPLACE_POLICY_BRRIP
+           ", " REPLACE_POLICY_DRRIP " or " REPLACE_POLICY_SHIP ".\n");
     return NULL;
 }
+
+prefetcher_t *
+cache_simulator_t::create_prefetcher(const std::string &policy)
+{
+    int line_size = (int)knobs_.line_size;
+    int late_refs = (int)knobs_.prefetch_late_refs;
+    if (policy == PREFETCH_POLICY_NEXTLINE)
+        return new prefetcher_t(line_size, late_refs);
+    if (policy == PREFETCH_POLICY_STRIDE)
+        return new prefetcher_stride_t(line_size, late_refs);
+    if (policy == PREFETCH_POLICY_STREAM)
+        return new prefetcher_stream_t(line_size, late_refs);
+    if (policy == PREFETCH_POLICY_SPATIAL)
+        return new prefetcher_spatial_t(line_size, late_refs);
+    return nullptr;
+}
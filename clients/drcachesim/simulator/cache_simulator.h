@@ -42,7 +42,10 @@
 #include "cache_stats.h"
 #include "cache.h"
 #include "snoop_filter.h"
+#include "parallel_cache_sim.h"
+#include "timing_model.h"
 #include <limits.h>
+#include <memory>
 
 enum class cache_split_t { DATA, INSTRUCTION };
 
@@ -74,10 +77,32 @@ public:
     bool
     print_results() override;
 
+    // With -parallel_cores, this only includes references whose simulation has
+    // completed: see finish_parallel_simulation().
     int_least64_t
     get_cache_metric(metric_name_t metric, unsigned level, unsigned core = 0,
                      cache_split_t split = cache_split_t::DATA) const;
 
+    // Completes the simulation of all references handed to the core threads with
+    // -parallel_cores and stops those threads.  Further references are simulated
+    // on the calling thread.  This is called by print_results().
+    void
+    finish_parallel_simulation();
+
+    // Resets the statistics of every cache and of the timing model.
+    void
+    reset_stats();
+
+    // Writes the contents and replacement state of every cache, along with the
+    // state of the prefetchers, the snoop filter and the mapping of threads to
+    // cores, for a checkpoint.
+    void
+    save_state(checkpoint_writer_t &out) const;
+    // Restores the state written by save_state() into a simulator with the same
+    // hierarchy.  Returns false on a mismatch or a truncated checkpoint.
+    bool
+    restore_state(checkpoint_reader_t &in);
+
     // Exposed to make it easy to test
     bool
     check_warmed_up();
@@ -87,10 +112,30 @@ public:
     const cache_simulator_knobs_t &
     get_knobs() const;
 
+    // Returns nullptr unless timing is modeled.
+    const timing_model_t *
+    get_timing_model() const
+    {
+        return timing_.get();
+    }
+
 protected:
     // Create a cache_t object with a specific replacement policy.
     virtual cache_t *
     create_cache(const std::string &policy);
+    // Create a prefetcher_t object with a specific policy, or return nullptr for
+    // PREFETCH_POLICY_NONE or an unknown policy.
+    virtual prefetcher_t *
+    create_prefetcher(const std::string &policy);
+    // Writes a checkpoint of the simulator state at the current trace position.
+    bool
+    write_checkpoint(const std::string &path);
+    // Restores a checkpoint, after which simulation resumes without warmup.
+    bool
+    read_checkpoint(const std::string &path);
+    // Prints the instructions and functions with the most misses at each level.
+    void
+    print_miss_attribution();
 
     cache_simulator_knobs_t knobs_;
 
@@ -112,6 +157,14 @@ protected:
     // Snoop filter tracks ownership of cache lines across private caches.
     snoop_filter_t *snoop_filter_ = nullptr;
 
+    // Runs the L1 caches on per-core threads with -parallel_cores once any warmup
+    // has completed.
+    std::unique_ptr<parallel_cache_sim_t> parallel_sim_;
+    bool parallel_sim_done_ = false;
+
+    // Estimates the cycles of each core with -timing.
+    std::unique_ptr<timing_model_t> timing_;
+
 private:
     bool is_warmed_up_;
 };
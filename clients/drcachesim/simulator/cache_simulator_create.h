@@ -35,9 +35,12 @@
 #ifndef _CACHE_SIMULATOR_CREATE_H_
 #define _CACHE_SIMULATOR_CREATE_H_ 1
 
+#include <memory>
 #include <string>
 #include "analysis_tool.h"
 
+class pc_symbolizer_t;
+
 /**
  * @file drmemtrace/cache_simulator_create.h
  * @brief DrMemtrace cache simulator creation.
@@ -59,15 +62,30 @@ struct cache_simulator_knobs_t {
         , LL_size(8 * 1024 * 1024)
         , LL_assoc(16)
         , LL_miss_file("")
+        , LL_sample_fraction(1.0)
         , model_coherence(false)
+        , parallel_cores(false)
+        , parallel_deterministic(true)
+        , parallel_epoch(16384)
+        , model_timing(false)
+        , L1I_latency(4)
+        , L1D_latency(4)
+        , LL_latency(40)
+        , memory_latency(200)
+        , memory_bandwidth(16.0)
+        , mshrs(10)
         , replace_policy("LRU")
         , data_prefetcher("nextline")
+        , prefetch_late_refs(4)
         , skip_refs(0)
         , warmup_refs(0)
         , warmup_fraction(0.0)
         , sim_refs(1ULL << 63)
         , cpu_scheduling(false)
         , verbose(0)
+        , save_checkpoint("")
+        , restore_checkpoint("")
+        , miss_attribution(0)
     {
     }
     unsigned int num_cores;
@@ -79,15 +97,33 @@ struct cache_simulator_knobs_t {
     uint64_t LL_size;
     unsigned int LL_assoc;
     std::string LL_miss_file;
+    double LL_sample_fraction;
     bool model_coherence;
+    bool parallel_cores;
+    bool parallel_deterministic;
+    unsigned int parallel_epoch;
+    bool model_timing;
+    unsigned int L1I_latency;
+    unsigned int L1D_latency;
+    unsigned int LL_latency;
+    unsigned int memory_latency;
+    double memory_bandwidth;
+    unsigned int mshrs;
     std::string replace_policy;
     std::string data_prefetcher;
+    unsigned int prefetch_late_refs;
     uint64_t skip_refs;
     uint64_t warmup_refs;
     double warmup_fraction;
     uint64_t sim_refs;
     bool cpu_scheduling;
     unsigned int verbose;
+    std::string save_checkpoint;
+    std::string restore_checkpoint;
+    unsigned int miss_attribution;
+    // Names the functions and modules in the miss_attribution report, which
+    // lists bare instruction addresses when this is null.
+    std::shared_ptr<pc_symbolizer_t> symbolizer;
 };
 
 /** Creates an instance of a cache simulator with a 2-level hierarchy. */
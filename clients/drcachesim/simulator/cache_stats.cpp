@@ -82,11 +82,11 @@ cache_stats_t::print_counts(std::string prefix)
     }
     if (num_prefetch_hits_ + num_prefetch_misses_ != 0) {
         std::cerr << prefix << std::setw(18) << std::left
-                  << "Prefetch hits:" << std::setw(20) << std::right << num_prefetch_hits_
-                  << std::endl;
+                  << "Prefetch hits:" << std::setw(20) << std::right
+                  << scale_sampled(num_prefetch_hits_) << std::endl;
         std::cerr << prefix << std::setw(18) << std::left
                   << "Prefetch misses:" << std::setw(20) << std::right
-                  << num_prefetch_misses_ << std::endl;
+                  << scale_sampled(num_prefetch_misses_) << std::endl;
     }
 }
 
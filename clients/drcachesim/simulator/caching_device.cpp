@@ -33,19 +33,44 @@
 #include "caching_device.h"
 #include "caching_device_block.h"
 #include "caching_device_stats.h"
+#include "checkpoint.h"
+#include "cache_fifo.h"
+#include "cache_lru.h"
+#include "cache_rrip.h"
+#include "cache_stats.h"
 #include "prefetcher.h"
+#include "set_ops.h"
 #include "snoop_filter.h"
+#include "timing_model.h"
 #include "../common/utils.h"
 #include <assert.h>
+#include <stdint.h>
+#include <type_traits>
+#include <typeinfo>
+
+// Per-set tag arrays are aligned to this size so that a set of up to 8 ways
+// (for 64-bit tags) is probed with a single host cache line access.
+static const int HOST_CACHE_LINE_SIZE = 64;
+
+template <typename T>
+static T *
+allocate_cache_line_aligned(std::vector<T> &storage, int count, const T &value)
+{
+    storage.assign(count + HOST_CACHE_LINE_SIZE / sizeof(T), value);
+    uintptr_t start = reinterpret_cast<uintptr_t>(storage.data());
+    start = (start + HOST_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(HOST_CACHE_LINE_SIZE - 1);
+    return reinterpret_cast<T *>(start);
+}
 
 caching_device_t::caching_device_t()
     : blocks_(NULL)
+    , tags_(NULL)
+    , counters_(NULL)
+    , set_ops_(set_ops_get(set_ops_best_kind()))
     , stats_(NULL)
     , prefetcher_(NULL)
-    // The tag being hashed is already right-shifted to the cache line and
-    // an identity hash is plenty good enough and nice and fast.
-    // We set the size and load factor only if being used, in set_hashtable_use().
-    , tag2block(0, [](addr_t key) { return static_cast<unsigned long>(key); })
+    , request_path_(&caching_device_t::request_template<caching_device_t,
+                                                        caching_device_stats_t>)
 {
 }
 
@@ -82,6 +107,8 @@ caching_device_t::init(int associativity, int block_size, int num_blocks,
     assoc_bits_ = compute_log2(associativity_);
     block_size_bits_ = compute_log2(block_size);
     blocks_per_set_mask_ = blocks_per_set_ - 1;
+    num_sampled_sets_ = blocks_per_set_;
+    sampled_sets_.clear();
     if (assoc_bits_ == -1 || block_size_bits_ == -1 || !IS_POWER_OF_2(blocks_per_set_))
         return false;
     parent_ = parent;
@@ -91,38 +118,232 @@ caching_device_t::init(int associativity, int block_size, int num_blocks,
     snoop_filter_ = snoop_filter;
     coherent_cache_ = coherent_cache;
 
+    // Initializing counters to 0 is just to be safe and to make it easier to write
+    // new replacement algorithms without errors (and we expect negligible perf cost),
+    // as we expect any use of a counter to only occur *after* a valid tag is put in
+    // place, where for the current replacement code we also set the counter then.
+    tags_ = allocate_cache_line_aligned(tags_storage_, num_blocks_, TAG_INVALID);
+    counters_ = allocate_cache_line_aligned(counters_storage_, num_blocks_, 0);
     blocks_ = new caching_device_block_t *[num_blocks_];
     init_blocks();
 
     last_tag_ = TAG_INVALID; // sentinel
 
+    prefetch_fill_time_.clear();
+    prefetch_victims_.clear();
+    prefetch_victim_next_.clear();
+    demand_accesses_ = 0;
+    if (prefetcher_ != nullptr) {
+        prefetch_fill_time_.resize(num_blocks_, 0);
+        prefetch_victims_.resize(num_blocks_, TAG_INVALID);
+        prefetch_victim_next_.resize(blocks_per_set_, 0);
+        prefetch_late_refs_ = prefetcher_->get_late_refs();
+    }
+
     inclusive_ = inclusive;
     children_ = children;
 
+    select_request_path();
+
     return true;
 }
 
-std::pair<caching_device_block_t *, int>
-caching_device_t::find_caching_device_block(addr_t tag)
+void
+caching_device_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write(associativity_);
+    out.write(block_size_);
+    out.write(num_blocks_);
+    out.write(loaded_blocks_);
+    out.write_array(tags_, num_blocks_);
+    out.write_array(counters_, num_blocks_);
+    out.write(demand_accesses_);
+    out.write_vector(prefetch_fill_time_);
+    out.write_vector(prefetch_victims_);
+    out.write_vector(prefetch_victim_next_);
+    out.write(prefetcher_ != nullptr);
+    if (prefetcher_ != nullptr)
+        prefetcher_->save_state(out);
+    stats_->save_state(out);
+}
+
+bool
+caching_device_t::restore_state(checkpoint_reader_t &in)
 {
+    in.expect(associativity_);
+    in.expect(block_size_);
+    in.expect(num_blocks_);
+    in.read(loaded_blocks_);
+    in.read_array(tags_, num_blocks_);
+    in.read_array(counters_, num_blocks_);
+    in.read(demand_accesses_);
+    // These are either empty or sized by our geometry.
+    in.read_array(prefetch_fill_time_.data(), prefetch_fill_time_.size());
+    in.read_array(prefetch_victims_.data(), prefetch_victims_.size());
+    in.read_array(prefetch_victim_next_.data(), prefetch_victim_next_.size());
+    in.expect(prefetcher_ != nullptr);
+    if (!in || (prefetcher_ != nullptr && !prefetcher_->restore_state(in)) ||
+        !stats_->restore_state(in))
+        return false;
+    last_tag_ = TAG_INVALID;
     if (use_tag2block_table_) {
-        auto it = tag2block.find(tag);
-        if (it == tag2block.end())
-            return std::make_pair(nullptr, 0);
-        assert(it->second.first->tag_ == tag);
-        return it->second;
+        tag2block.clear();
+        for (int block_idx = 0; block_idx < num_blocks_; block_idx += associativity_) {
+            for (int way = 0; way < associativity_; ++way) {
+                addr_t tag = get_tag(block_idx, way);
+                if (tag != TAG_INVALID && tag2block.find(tag) == nullptr)
+                    tag2block[tag] = way;
+            }
+        }
     }
+    return true;
+}
+
+void
+caching_device_t::set_sampling(double fraction)
+{
+    sampled_sets_.clear();
+    num_sampled_sets_ = blocks_per_set_;
+    if (fraction < 1.0) {
+        sampled_sets_.resize(blocks_per_set_);
+        num_sampled_sets_ = 0;
+        // A multiplicative hash spreads the sample over the index space while
+        // avoiding the strides that regular access patterns map to.
+        const uint32_t threshold = static_cast<uint32_t>(fraction * 4294967296.0);
+        for (int set = 0; set < blocks_per_set_; ++set) {
+            uint32_t hash = static_cast<uint32_t>(set) * 2654435761U;
+            hash ^= hash >> 16;
+            if (hash < threshold) {
+                sampled_sets_[set] = 1;
+                ++num_sampled_sets_;
+            }
+        }
+        // Always simulate at least one set.
+        if (num_sampled_sets_ == 0) {
+            sampled_sets_[0] = 1;
+            num_sampled_sets_ = 1;
+        }
+    }
+    apply_sampling_to_stats();
+}
+
+void
+caching_device_t::apply_sampling_to_stats()
+{
+    if (stats_ == nullptr)
+        return;
+    std::vector<int> sets;
+    for (int set = 0; set < static_cast<int>(sampled_sets_.size()); ++set) {
+        if (sampled_sets_[set])
+            sets.push_back(set);
+    }
+    stats_->set_sampling(sets, blocks_per_set_, block_size_bits_);
+}
+
+void
+caching_device_t::select_request_path()
+{
+    // We require exact type matches: a further subclass may override any hook.
+    bool stats_exact = stats_ != nullptr && typeid(*stats_) == typeid(cache_stats_t);
+    const std::type_info &type = typeid(*this);
+    if (type == typeid(cache_lru_t)) {
+        request_path_ = stats_exact
+            ? &caching_device_t::request_template<cache_lru_t, cache_stats_t>
+            : &caching_device_t::request_template<cache_lru_t, caching_device_stats_t>;
+    } else if (type == typeid(cache_fifo_t)) {
+        request_path_ = stats_exact
+            ? &caching_device_t::request_template<cache_fifo_t, cache_stats_t>
+            : &caching_device_t::request_template<cache_fifo_t, caching_device_stats_t>;
+    } else if (type == typeid(cache_rrip_t)) {
+        request_path_ = stats_exact
+            ? &caching_device_t::request_template<cache_rrip_t, cache_stats_t>
+            : &caching_device_t::request_template<cache_rrip_t, caching_device_stats_t>;
+    } else if (type == typeid(cache_t)) {
+        request_path_ = stats_exact
+            ? &caching_device_t::request_template<cache_t, cache_stats_t>
+            : &caching_device_t::request_template<cache_t, caching_device_stats_t>;
+    } else {
+        request_path_ =
+            &caching_device_t::request_template<caching_device_t, caching_device_stats_t>;
+    }
+}
+
+int
+caching_device_t::find_caching_device_way(addr_t tag)
+{
     int block_idx = compute_block_idx(tag);
-    for (int way = 0; way < associativity_; ++way) {
-        caching_device_block_t &block = get_caching_device_block(block_idx, way);
-        if (block.tag_ == tag)
-            return std::make_pair(&block, way);
+    if (use_tag2block_table_) {
+        int *way = tag2block.find(tag);
+        if (way == nullptr)
+            return -1;
+        assert(get_tag(block_idx, *way) == tag);
+        return *way;
     }
-    return std::make_pair(nullptr, 0);
+    return set_ops_->find_tag(&tags_[block_idx], associativity_, tag);
+}
+
+void
+caching_device_t::unmap_tag(int block_idx, int way, addr_t old_tag)
+{
+    if (!duplicate_tags_) {
+        tag2block.erase(old_tag);
+        return;
+    }
+    int *mapped = tag2block.find(old_tag);
+    if (mapped == nullptr || *mapped != way)
+        return;
+    int other = set_ops_->find_tag(&tags_[block_idx], associativity_, old_tag);
+    if (other < 0)
+        tag2block.erase(old_tag);
+    else
+        *mapped = other;
+}
+
+template <typename Device>
+inline void
+caching_device_t::device_access_update(int block_idx, int way)
+{
+    if (std::is_same<Device, caching_device_t>::value)
+        access_update(block_idx, way);
+    else
+        static_cast<Device *>(this)->Device::access_update(block_idx, way);
+}
+
+template <typename Device>
+inline int
+caching_device_t::device_replace_which_way(int block_idx)
+{
+    if (std::is_same<Device, caching_device_t>::value)
+        return replace_which_way(block_idx);
+    return static_cast<Device *>(this)->Device::replace_which_way(block_idx);
+}
+
+template <typename Device, typename Stats>
+inline void
+caching_device_t::device_record_access_stats(const memref_t &memref, bool hit,
+                                             caching_device_block_t *cache_block)
+{
+    if (std::is_same<Device, caching_device_t>::value) {
+        record_access_stats(memref, hit, cache_block);
+        return;
+    }
+    if (std::is_same<Stats, caching_device_stats_t>::value)
+        stats_->access(memref, hit, cache_block);
+    else
+        static_cast<Stats *>(stats_)->Stats::access(memref, hit, cache_block);
+    if (parent_ != nullptr)
+        parent_->record_child_access(memref, hit, cache_block);
 }
 
 void
 caching_device_t::request(const memref_t &memref_in)
+{
+    (this->*request_path_)(memref_in);
+}
+
+template <typename Device, typename Stats>
+void
+caching_device_t::request_template(const memref_t &memref_in)
 {
     // Unfortunately we need to make a copy for our loop so we can pass
     // the right data struct to the parent and stats collectors.
@@ -134,14 +355,20 @@ caching_device_t::request(const memref_t &memref_in)
     addr_t final_tag = compute_tag(final_addr);
     addr_t tag = compute_tag(memref_in.data.addr);
 
+    bool track_prefetches = !prefetch_fill_time_.empty();
+    if (track_prefetches && !type_is_prefetch(memref_in.data.type))
+        ++demand_accesses_;
+
     // Optimization: check last tag if single-block
     if (tag == final_tag && tag == last_tag_ && memref_in.data.type != TRACE_TYPE_WRITE) {
         // Make sure last_tag_ is properly in sync.
-        caching_device_block_t *cache_block =
-            &get_caching_device_block(last_block_idx_, last_way_);
-        assert(tag != TAG_INVALID && tag == cache_block->tag_);
-        record_access_stats(memref_in, true /*hit*/, cache_block);
-        access_update(last_block_idx_, last_way_);
+        assert(tag != TAG_INVALID && tag == get_tag(last_block_idx_, last_way_));
+        if (track_prefetches)
+            record_prefetch_hit(memref_in, last_block_idx_ + last_way_);
+        device_record_access_stats<Device, Stats>(
+            memref_in, true /*hit*/,
+            &get_caching_device_block(last_block_idx_, last_way_));
+        device_access_update<Device>(last_block_idx_, last_way_);
         return;
     }
 
@@ -154,12 +381,19 @@ caching_device_t::request(const memref_t &memref_in)
         if (tag + 1 <= final_tag)
             memref.data.size = ((tag + 1) << block_size_bits_) - memref.data.addr;
 
-        auto block_way = find_caching_device_block(tag);
-        if (block_way.first != nullptr) {
+        if (!sampled_sets_.empty() && !sampled_sets_[block_idx >> assoc_bits_]) {
+            advance_to_next_block(memref, tag, final_tag, final_addr);
+            continue;
+        }
+
+        int found_way = find_caching_device_way(tag);
+        if (found_way >= 0) {
             // Access is a hit.
-            caching_device_block_t *cache_block = block_way.first;
-            way = block_way.second;
-            record_access_stats(memref, true /*hit*/, cache_block);
+            way = found_way;
+            device_record_access_stats<Device, Stats>(
+                memref, true /*hit*/, &get_caching_device_block(block_idx, way));
+            if (track_prefetches)
+                record_prefetch_hit(memref, block_idx + way);
             if (coherent_cache_ && memref.data.type == TRACE_TYPE_WRITE) {
                 // On a hit, we must notify the snoop filter of the write or propagate
                 // the write to a snooped cache.
@@ -173,12 +407,17 @@ caching_device_t::request(const memref_t &memref_in)
             }
         } else {
             // Access is a miss.
-            way = replace_which_way(block_idx);
+            way = device_replace_which_way<Device>(block_idx);
             caching_device_block_t *cache_block =
                 &get_caching_device_block(block_idx, way);
 
-            record_access_stats(memref, false /*miss*/, cache_block);
+            device_record_access_stats<Device, Stats>(memref, false /*miss*/,
+                                                      cache_block);
             missed = true;
+            if (timing_ != nullptr) {
+                timing_->add_miss(memref, parent_ == nullptr ? 0 : parent_->latency_,
+                                  parent_ == nullptr);
+            }
             // If no parent we assume we get the data from main memory
             if (parent_ != NULL)
                 parent_->request(memref);
@@ -187,7 +426,9 @@ caching_device_t::request(const memref_t &memref_in)
                 snoop_filter_->snoop(tag, id_, (memref.data.type == TRACE_TYPE_WRITE));
             }
 
-            addr_t victim_tag = cache_block->tag_;
+            addr_t victim_tag = get_tag(block_idx, way);
+            if (track_prefetches)
+                record_prefetch_fill(memref, tag, block_idx, way, victim_tag);
             // Check if we are inserting a new block, if we are then increment
             // the block loaded count.
             if (victim_tag == TAG_INVALID) {
@@ -224,22 +465,22 @@ caching_device_t::request(const memref_t &memref_in)
                     }
                 }
             }
-            update_tag(cache_block, way, tag);
+            update_tag(block_idx, way, tag);
         }
 
-        access_update(block_idx, way);
+        device_access_update<Device>(block_idx, way);
 
         // Issue a hardware prefetch, if any, before we remember the last tag,
         // so we remember this line and not the prefetched line.
-        if (missed && !type_is_prefetch(memref.data.type) && prefetcher_ != nullptr)
+        if (prefetcher_ != nullptr && !type_is_prefetch(memref.data.type) &&
+            (missed || prefetcher_->trains_on_hits())) {
+            issuing_prefetch_ = true;
             prefetcher_->prefetch(this, memref);
-
-        if (tag + 1 <= final_tag) {
-            addr_t next_addr = (tag + 1) << block_size_bits_;
-            memref.data.addr = next_addr;
-            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
+            issuing_prefetch_ = false;
         }
 
+        advance_to_next_block(memref, tag, final_tag, final_addr);
+
         // Optimization: remember last tag
         last_tag_ = tag;
         last_way_ = way;
@@ -247,11 +488,40 @@ caching_device_t::request(const memref_t &memref_in)
     }
 }
 
+void
+caching_device_t::record_prefetch_fill(const memref_t &memref, addr_t tag, int block_idx,
+                                       int way, addr_t victim_tag)
+{
+    // Hardware prefetches from a child's prefetcher are not ours.
+    bool own_prefetch =
+        issuing_prefetch_ && memref.data.type == TRACE_TYPE_HARDWARE_PREFETCH;
+    if (!own_prefetch) {
+        prefetch_fill_time_[block_idx + way] = 0;
+        if (type_is_prefetch(memref.data.type))
+            return;
+        for (int i = 0; i < associativity_; ++i) {
+            if (prefetch_victims_[block_idx + i] == tag) {
+                prefetch_victims_[block_idx + i] = TAG_INVALID;
+                stats_->prefetch_polluted();
+                break;
+            }
+        }
+        return;
+    }
+    prefetch_fill_time_[block_idx + way] = demand_accesses_ + 1;
+    stats_->prefetch_issued();
+    if (victim_tag != TAG_INVALID) {
+        int &next = prefetch_victim_next_[block_idx >> assoc_bits_];
+        prefetch_victims_[block_idx + next] = victim_tag;
+        next = (next + 1) & (associativity_ - 1);
+    }
+}
+
 void
 caching_device_t::access_update(int block_idx, int way)
 {
     // We just inc the counter for LFU.  We live with any blip on overflow.
-    get_caching_device_block(block_idx, way).counter_++;
+    get_counter(block_idx, way)++;
 }
 
 int
@@ -259,7 +529,7 @@ caching_device_t::replace_which_way(int block_idx)
 {
     int min_way = get_next_way_to_replace(block_idx);
     // Clear the counter for LFU.
-    get_caching_device_block(block_idx, min_way).counter_ = 0;
+    get_counter(block_idx, min_way) = 0;
     return min_way;
 }
 
@@ -272,12 +542,12 @@ caching_device_t::get_next_way_to_replace(const int block_idx) const
     int min_counter = 0; /* avoid "may be used uninitialized" with GCC 4.4.7 */
     int min_way = 0;
     for (int way = 0; way < associativity_; ++way) {
-        if (get_caching_device_block(block_idx, way).tag_ == TAG_INVALID) {
+        if (get_tag(block_idx, way) == TAG_INVALID) {
             min_way = way;
             break;
         }
-        if (way == 0 || get_caching_device_block(block_idx, way).counter_ < min_counter) {
-            min_counter = get_caching_device_block(block_idx, way).counter_;
+        if (way == 0 || get_counter(block_idx, way) < min_counter) {
+            min_counter = get_counter(block_idx, way);
             min_way = way;
         }
     }
@@ -287,9 +557,9 @@ caching_device_t::get_next_way_to_replace(const int block_idx) const
 void
 caching_device_t::invalidate(addr_t tag, invalidation_type_t invalidation_type)
 {
-    auto block_way = find_caching_device_block(tag);
-    if (block_way.first != nullptr) {
-        invalidate_caching_device_block(block_way.first);
+    int way = find_caching_device_way(tag);
+    if (way >= 0) {
+        invalidate_caching_device_block(compute_block_idx(tag), way);
         stats_->invalidate(invalidation_type);
         // Invalidate last_tag_ if it was this tag.
         if (last_tag_ == tag) {
@@ -315,8 +585,7 @@ caching_device_t::invalidate(addr_t tag, invalidation_type_t invalidation_type)
 bool
 caching_device_t::contains_tag(addr_t tag)
 {
-    auto block_way = find_caching_device_block(tag);
-    if (block_way.first != nullptr)
+    if (find_caching_device_way(tag) >= 0)
         return true;
     if (children_.empty()) {
         return false;
@@ -335,8 +604,7 @@ void
 caching_device_t::propagate_eviction(addr_t tag, const caching_device_t *requester)
 {
     // Check our own cache for this line.
-    auto block_way = find_caching_device_block(tag);
-    if (block_way.first != nullptr)
+    if (find_caching_device_way(tag) >= 0)
         return;
 
     // Check if other children contain this line.
@@ -385,11 +653,19 @@ caching_device_t::record_access_stats(const memref_t &memref, bool hit,
                                       caching_device_block_t *cache_block)
 {
     stats_->access(memref, hit, cache_block);
+    if (parent_ != nullptr)
+        parent_->record_child_access(memref, hit, cache_block);
+}
+
+void
+caching_device_t::record_child_access(const memref_t &memref, bool hit,
+                                      caching_device_block_t *cache_block)
+{
     // We propagate hits all the way up the hierachy.
     // But to avoid over-counting we only propagate misses one level up.
     if (hit) {
-        for (caching_device_t *up = parent_; up != nullptr; up = up->parent_)
+        for (caching_device_t *up = this; up != nullptr; up = up->parent_)
             up->stats_->child_access(memref, hit, cache_block);
-    } else if (parent_ != nullptr)
-        parent_->stats_->child_access(memref, hit, cache_block);
+    } else
+        stats_->child_access(memref, hit, cache_block);
 }
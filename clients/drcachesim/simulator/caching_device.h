@@ -36,7 +36,6 @@
 #ifndef _CACHING_DEVICE_H_
 #define _CACHING_DEVICE_H_ 1
 
-#include <functional>
 #include <unordered_map>
 #include <vector>
 
@@ -44,6 +43,8 @@
 #include "caching_device_stats.h"
 #include "memref.h"
 #include "prefetcher.h"
+#include "set_ops.h"
+#include "tag_table.h"
 
 // Statistics collection is abstracted out into the caching_device_stats_t class.
 
@@ -54,6 +55,10 @@
 // not need to synchronize data access.
 
 class snoop_filter_t;
+class prefetcher_t;
+class timing_model_t;
+class checkpoint_reader_t;
+class checkpoint_writer_t;
 
 class caching_device_t {
 public:
@@ -85,6 +90,8 @@ public:
     set_stats(caching_device_stats_t *stats)
     {
         stats_ = stats;
+        select_request_path();
+        apply_sampling_to_stats();
     }
     prefetcher_t *
     get_prefetcher() const
@@ -96,23 +103,93 @@ public:
     {
         return parent_;
     }
+    void
+    set_parent(caching_device_t *parent)
+    {
+        parent_ = parent;
+    }
+    // Charges each access that reaches this device "latency" cycles in "timing",
+    // or disables timing if "timing" is nullptr.  Every device in a hierarchy must
+    // use the same timing model.
+    void
+    set_timing(timing_model_t *timing, int latency)
+    {
+        timing_ = timing;
+        latency_ = timing == nullptr ? 0 : latency;
+    }
+    int
+    get_latency() const
+    {
+        return latency_;
+    }
+    bool
+    is_inclusive() const
+    {
+        return inclusive_;
+    }
+    bool
+    is_coherent() const
+    {
+        return coherent_cache_;
+    }
+    int
+    get_block_size() const
+    {
+        return block_size_;
+    }
+    int
+    get_associativity() const
+    {
+        return associativity_;
+    }
     inline double
     get_loaded_fraction() const
     {
-        return double(loaded_blocks_) / num_blocks_;
+        // With set sampling only the sampled sets can be loaded.
+        return double(loaded_blocks_) / (num_sampled_sets_ << assoc_bits_);
+    }
+    // Restricts simulation to roughly the given fraction of the sets, chosen by a
+    // hash of the set index, for estimating the behavior of large caches.  Accesses
+    // to the other sets are dropped: they update no statistics and are not passed
+    // to the parent, so this is meant for a device with no parent.  The stats
+    // scale their counts to the whole device and report confidence intervals.
+    // Must be called after init() and prior to any call to request().
+    void
+    set_sampling(double fraction);
+    // Records an access by a child device in the stats of this device and, for a
+    // hit, in those of all of its ancestors.
+    void
+    record_child_access(const memref_t &memref, bool hit,
+                        caching_device_block_t *cache_block);
+    // Writes the blocks and replacement state of this device, along with the
+    // state of its prefetcher and the statistics state that outlives a reset.
+    virtual void
+    save_state(checkpoint_writer_t &out) const;
+    // Restores the state written by save_state() for a device of the same type
+    // and geometry.  Returns false on a mismatch or a truncated checkpoint.
+    virtual bool
+    restore_state(checkpoint_reader_t &in);
+    // Switches the per-set operations to the given implementation, which by
+    // default is the best one the host supports.  Returns false and leaves the
+    // current one in place if the host or the build does not support "kind".
+    // Must be called prior to any call to request().
+    bool
+    use_set_ops(set_ops_kind_t kind)
+    {
+        const set_ops_t *ops = set_ops_get(kind);
+        if (ops == nullptr)
+            return false;
+        set_ops_ = ops;
+        return true;
     }
     // Must be called prior to any call to request().
     virtual inline void
     set_hashtable_use(bool use_hashtable)
     {
-        if (!use_tag2block_table_ && use_hashtable) {
-            // Resizing from an initial small table causes noticeable overhead, so we
-            // start with a relatively large table.
-            tag2block.reserve(1 << 16);
-            // Even with the large initial size, for large caches we want to keep the
-            // load factor small.
-            tag2block.max_load_factor(0.5);
-        }
+        // The table never holds more tags than we have blocks, so sizing it for
+        // them up front means updates never rehash.
+        if (!use_tag2block_table_ && use_hashtable)
+            tag2block.reserve(num_blocks_);
         use_tag2block_table_ = use_hashtable;
     }
     int
@@ -144,37 +221,71 @@ protected:
     {
         return (tag & blocks_per_set_mask_) << assoc_bits_;
     }
+    // Updates a copy of a multi-block memref used by request() to cover the rest
+    // of the original reference after the block "tag".
+    inline void
+    advance_to_next_block(memref_t &memref, addr_t tag, addr_t final_tag,
+                          addr_t final_addr) const
+    {
+        if (tag + 1 <= final_tag) {
+            addr_t next_addr = (tag + 1) << block_size_bits_;
+            memref.data.addr = next_addr;
+            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
+        }
+    }
     inline caching_device_block_t &
     get_caching_device_block(int block_idx, int way) const
     {
         return *(blocks_[block_idx + way]);
     }
+    // The tag and replacement counter of each block live in the flat tags_ and
+    // counters_ arrays rather than in the caching_device_block_t objects, so a
+    // set's tags are contiguous and a way probe or replacement update touches no
+    // heap objects.
+    inline addr_t &
+    get_tag(int block_idx, int way) const
+    {
+        return tags_[block_idx + way];
+    }
+    inline int &
+    get_counter(int block_idx, int way) const
+    {
+        return counters_[block_idx + way];
+    }
 
     inline void
-    invalidate_caching_device_block(caching_device_block_t *block)
+    invalidate_caching_device_block(int block_idx, int way)
     {
-        if (use_tag2block_table_)
-            tag2block.erase(block->tag_);
-        block->tag_ = TAG_INVALID;
-        // Xref cache_block_t constructor about why we set counter to 0.
-        block->counter_ = 0;
+        addr_t &tag = get_tag(block_idx, way);
+        addr_t old_tag = tag;
+        tag = TAG_INVALID;
+        if (use_tag2block_table_ && old_tag != TAG_INVALID)
+            unmap_tag(block_idx, way, old_tag);
+        // Xref caching_device_t::init() about why we set counter to 0.
+        get_counter(block_idx, way) = 0;
     }
 
     inline void
-    update_tag(caching_device_block_t *block, int way, addr_t new_tag)
+    update_tag(int block_idx, int way, addr_t new_tag)
     {
+        addr_t &tag = get_tag(block_idx, way);
+        addr_t old_tag = tag;
+        tag = new_tag;
         if (use_tag2block_table_) {
-            if (block->tag_ != TAG_INVALID)
-                tag2block.erase(block->tag_);
-            tag2block[new_tag] = std::make_pair(block, way);
+            if (old_tag != TAG_INVALID)
+                unmap_tag(block_idx, way, old_tag);
+            tag2block[new_tag] = way;
         }
-        block->tag_ = new_tag;
     }
 
-    // Returns the block (and its way) whose tag equals `tag`.
-    // Returns <nullptr,0> if there is no such block.
-    std::pair<caching_device_block_t *, int>
-    find_caching_device_block(addr_t tag);
+    // Removes the tag2block entry for old_tag, which "way" no longer holds.
+    void
+    unmap_tag(int block_idx, int way, addr_t old_tag);
+
+    // Returns the way of the block whose tag equals `tag` within the set given
+    // by compute_block_idx(tag), or -1 if there is no such block.
+    int
+    find_caching_device_way(addr_t tag);
 
     // a pure virtual function for subclasses to initialize their own block array
     virtual void
@@ -203,6 +314,16 @@ protected:
     // an extended block class which has its own member variables cannot be indexed
     // correctly by base class pointers.
     caching_device_block_t **blocks_;
+    // Structure-of-arrays per-block state indexed by block_idx + way, with each
+    // array aligned to a host cache line.
+    addr_t *tags_;
+    // XXX: using int_least64_t here results in a ~4% slowdown for 32-bit apps.
+    // A 32-bit counter should be sufficient but we may want to revisit.
+    int *counters_; // for use by replacement policies
+    // The per-set operations on tags_ and counters_.
+    const set_ops_t *set_ops_;
+    std::vector<addr_t> tags_storage_;
+    std::vector<int> counters_storage_;
     int blocks_per_set_;
     // Optimization fields for fast bit operations
     int blocks_per_set_mask_;
@@ -216,16 +337,85 @@ protected:
     addr_t last_tag_;
     int last_way_;
     int last_block_idx_;
-    // Optimization: keep a hashtable for quick lookup of {block,way}
+    // Optimization: keep a hashtable for quick lookup of the way
     // given a tag, if using a large cache hierarchy where serial
     // walks over the associativity end up as bottlenecks.
     // We can't easily remove the blocks_ array and replace with just
     // the hashtable as replace_which_way(), etc. want quick access to
     // every way for a given line index.
-    std::unordered_map<addr_t, std::pair<caching_device_block_t *, int>,
-                       std::function<unsigned long(addr_t)>>
-        tag2block;
+    tag_table_t<int> tag2block;
     bool use_tag2block_table_ = false;
+    // Whether several ways of a set may hold the same tag, as TLB entries for
+    // different processes do.  tag2block then maps the tag to any one of them.
+    bool duplicate_tags_ = false;
+
+    // Hardware prefetcher effectiveness tracking, only for a device with a
+    // prefetcher.  For each block holding a line our prefetcher brought in that has
+    // not had a demand hit yet, the demand access count when it was brought in plus
+    // one; otherwise 0.  Indexed by block_idx + way.
+    std::vector<int_least64_t> prefetch_fill_time_;
+    // The number of demand requests to this device.
+    int_least64_t demand_accesses_ = 0;
+    // The prefetcher's get_late_refs(), cached so the hit path need not call it.
+    int prefetch_late_refs_ = 0;
+    // Lines evicted by our prefetches that have not been requested since, with
+    // associativity_ slots per set, indexed like tags_.  A set's slots are reused
+    // round-robin, so a victim is forgotten once that many later prefetches have
+    // evicted lines from its set: the polluting count is thus the number of
+    // victims requested again before that happens.
+    std::vector<addr_t> prefetch_victims_;
+    // For each set, the next slot in prefetch_victims_ to overwrite.
+    std::vector<int> prefetch_victim_next_;
+    // Whether the request being processed comes from our prefetcher.
+    bool issuing_prefetch_ = false;
+
+    // The optional timing model and this device's hit latency in cycles.
+    timing_model_t *timing_ = nullptr;
+    int latency_ = 0;
+
+    // For set sampling: whether each set, indexed by block_idx >> assoc_bits_, is
+    // simulated.  Empty if all sets are.
+    std::vector<char> sampled_sets_;
+    int num_sampled_sets_ = 0;
+
+private:
+    // The body of request() is a template over the concrete device and statistics
+    // classes.  select_request_path() picks the instantiation matching the exact
+    // dynamic types of this device and its stats, in which the replacement policy
+    // and statistics hooks are called non-virtually and can be inlined.  Any other
+    // subclass uses the <caching_device_t, caching_device_stats_t> instantiation,
+    // which calls the hooks virtually.
+    template <typename Device, typename Stats>
+    void
+    request_template(const memref_t &memref);
+    template <typename Device>
+    void
+    device_access_update(int block_idx, int way);
+    template <typename Device>
+    int
+    device_replace_which_way(int block_idx);
+    template <typename Device, typename Stats>
+    void
+    device_record_access_stats(const memref_t &memref, bool hit,
+                               caching_device_block_t *cache_block);
+    void
+    record_prefetch_fill(const memref_t &memref, addr_t tag, int block_idx, int way,
+                         addr_t victim_tag);
+    inline void
+    record_prefetch_hit(const memref_t &memref, int way_idx)
+    {
+        int_least64_t fill_time = prefetch_fill_time_[way_idx];
+        if (fill_time == 0 || type_is_prefetch(memref.data.type))
+            return;
+        prefetch_fill_time_[way_idx] = 0;
+        stats_->prefetch_used(demand_accesses_ - fill_time < prefetch_late_refs_);
+    }
+    void
+    select_request_path();
+    void
+    apply_sampling_to_stats();
+
+    void (caching_device_t::*request_path_)(const memref_t &memref);
 };
 
 #endif /* _CACHING_DEVICE_H_ */
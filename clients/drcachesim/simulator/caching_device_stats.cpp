@@ -30,9 +30,12 @@
  * DAMAGE.
  */
 
+#include <algorithm>
 #include <assert.h>
+#include <math.h>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include "../common/options.h"
 #include "caching_device_stats.h"
 
@@ -46,6 +49,10 @@ caching_device_stats_t::caching_device_stats_t(const std::string &miss_file,
     , num_child_hits_(0)
     , num_inclusive_invalidates_(0)
     , num_coherence_invalidates_(0)
+    , num_prefetches_issued_(0)
+    , num_prefetches_useful_(0)
+    , num_prefetches_late_(0)
+    , num_prefetches_polluting_(0)
     , num_hits_at_reset_(0)
     , num_misses_at_reset_(0)
     , num_child_hits_at_reset_(0)
@@ -78,6 +85,10 @@ caching_device_stats_t::caching_device_stats_t(const std::string &miss_file,
     stats_map_.emplace(metric_name_t::CHILD_HITS, num_child_hits_);
     stats_map_.emplace(metric_name_t::INCLUSIVE_INVALIDATES, num_inclusive_invalidates_);
     stats_map_.emplace(metric_name_t::COHERENCE_INVALIDATES, num_coherence_invalidates_);
+    stats_map_.emplace(metric_name_t::PREFETCHES_ISSUED, num_prefetches_issued_);
+    stats_map_.emplace(metric_name_t::PREFETCHES_USEFUL, num_prefetches_useful_);
+    stats_map_.emplace(metric_name_t::PREFETCHES_LATE, num_prefetches_late_);
+    stats_map_.emplace(metric_name_t::PREFETCHES_POLLUTING, num_prefetches_polluting_);
 }
 
 caching_device_stats_t::~caching_device_stats_t()
@@ -103,9 +114,40 @@ caching_device_stats_t::access(const memref_t &memref, bool hit,
         num_misses_++;
         if (dump_misses_)
             dump_miss(memref);
+        if (pc_misses_ != nullptr) {
+            ++(*pc_misses_)[type_is_instr(memref.instr.type) ? memref.instr.addr
+                                                             : memref.data.pc];
+        }
 
         check_compulsory_miss(memref.data.addr);
     }
+    if (sampling_) {
+        int set = static_cast<int>((memref.data.addr >> block_size_bits_) & set_mask_);
+        if (hit)
+            set_hits_[set]++;
+        else
+            set_misses_[set]++;
+    }
+}
+
+void
+caching_device_stats_t::set_sampling(const std::vector<int> &sampled_sets, int num_sets,
+                                     int block_size_bits)
+{
+    sampled_sets_ = sampled_sets;
+    sampling_ = !sampled_sets_.empty();
+    set_hits_.clear();
+    set_misses_.clear();
+    if (!sampling_) {
+        sampling_scale_ = 1.0;
+        return;
+    }
+    num_sets_ = num_sets;
+    set_mask_ = num_sets - 1;
+    block_size_bits_ = block_size_bits;
+    sampling_scale_ = double(num_sets) / sampled_sets_.size();
+    set_hits_.resize(num_sets);
+    set_misses_.resize(num_sets);
 }
 
 void
@@ -154,21 +196,21 @@ void
 caching_device_stats_t::print_warmup(std::string prefix)
 {
     std::cerr << prefix << std::setw(18) << std::left << "Warmup hits:" << std::setw(20)
-              << std::right << num_hits_at_reset_ << std::endl;
+              << std::right << scale_sampled(num_hits_at_reset_) << std::endl;
     std::cerr << prefix << std::setw(18) << std::left << "Warmup misses:" << std::setw(20)
-              << std::right << num_misses_at_reset_ << std::endl;
+              << std::right << scale_sampled(num_misses_at_reset_) << std::endl;
 }
 
 void
 caching_device_stats_t::print_counts(std::string prefix)
 {
     std::cerr << prefix << std::setw(18) << std::left << "Hits:" << std::setw(20)
-              << std::right << num_hits_ << std::endl;
+              << std::right << scale_sampled(num_hits_) << std::endl;
     std::cerr << prefix << std::setw(18) << std::left << "Misses:" << std::setw(20)
-              << std::right << num_misses_ << std::endl;
+              << std::right << scale_sampled(num_misses_) << std::endl;
     std::cerr << prefix << std::setw(18) << std::left
               << "Compulsory misses:" << std::setw(20) << std::right
-              << num_compulsory_misses_ << std::endl;
+              << scale_sampled(num_compulsory_misses_) << std::endl;
     if (is_coherent_) {
         std::cerr << prefix << std::setw(21) << std::left
                   << "Parent invalidations:" << std::setw(17) << std::right
@@ -183,6 +225,31 @@ caching_device_stats_t::print_counts(std::string prefix)
     }
 }
 
+void
+caching_device_stats_t::print_prefetcher_counts(std::string prefix)
+{
+    // Only a device with a hardware prefetcher counts these.
+    if (num_prefetches_issued_ == 0)
+        return;
+    std::cerr << prefix << std::setw(18) << std::left
+              << "Prefetches issued:" << std::setw(20) << std::right
+              << num_prefetches_issued_ << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left
+              << "Useful prefetches:" << std::setw(20) << std::right
+              << num_prefetches_useful_ << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left
+              << "Late prefetches:" << std::setw(20) << std::right
+              << num_prefetches_late_ << std::endl;
+    std::cerr << prefix << std::setw(21) << std::left
+              << "Polluting prefetches:" << std::setw(17) << std::right
+              << num_prefetches_polluting_ << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left
+              << "Prefetch accuracy:" << std::setw(20) << std::fixed
+              << std::setprecision(2) << std::right
+              << ((float)num_prefetches_useful_ * 100 / num_prefetches_issued_) << "%"
+              << std::endl;
+}
+
 void
 caching_device_stats_t::print_rates(std::string prefix)
 {
@@ -197,6 +264,49 @@ caching_device_stats_t::print_rates(std::string prefix)
     }
 }
 
+void
+caching_device_stats_t::print_sampling(std::string prefix)
+{
+    int n = static_cast<int>(sampled_sets_.size());
+    std::cerr << prefix << std::setw(18) << std::left << "Sampled sets:" << std::setw(20)
+              << std::right << n << " of " << num_sets_ << std::endl;
+    if (n < 2 || num_hits_ + num_misses_ == 0)
+        return;
+    // We treat each set as a cluster drawn without replacement from all sets.
+    // The miss count is estimated from the mean per-set misses and the miss rate
+    // is a ratio estimator, with the usual linearized variance.
+    double sum_misses = 0, sum_accesses = 0;
+    for (int set : sampled_sets_) {
+        sum_misses += set_misses_[set];
+        sum_accesses += set_hits_[set] + set_misses_[set];
+    }
+    double mean_misses = sum_misses / n;
+    double rate = sum_misses / sum_accesses;
+    double var_misses = 0, var_rate_resid = 0;
+    for (int set : sampled_sets_) {
+        double misses = static_cast<double>(set_misses_[set]);
+        double accesses = static_cast<double>(set_hits_[set] + set_misses_[set]);
+        var_misses += (misses - mean_misses) * (misses - mean_misses);
+        var_rate_resid += (misses - rate * accesses) * (misses - rate * accesses);
+    }
+    var_misses /= n - 1;
+    var_rate_resid /= n - 1;
+    double fpc = 1.0 - double(n) / num_sets_;
+    const double z_95 = 1.96;
+    double misses_ci = z_95 * num_sets_ * sqrt(fpc * var_misses / n);
+    double mean_accesses = sum_accesses / n;
+    double rate_ci = z_95 * sqrt(fpc * var_rate_resid / n) / mean_accesses;
+    std::ostringstream misses_str;
+    misses_str.imbue(std::cerr.getloc());
+    misses_str << "+/-" << static_cast<int_least64_t>(misses_ci + 0.5);
+    std::cerr << prefix << std::setw(18) << std::left << "Misses 95% CI:"
+              << std::setw(20) << std::right << misses_str.str() << std::endl;
+    std::ostringstream rate_str;
+    rate_str << "+/-" << std::fixed << std::setprecision(2) << rate_ci * 100;
+    std::cerr << prefix << std::setw(18) << std::left << "Miss rate 95% CI:"
+              << std::setw(20) << std::right << rate_str.str() << "%" << std::endl;
+}
+
 void
 caching_device_stats_t::print_child_stats(std::string prefix)
 {
@@ -207,8 +317,9 @@ caching_device_stats_t::print_child_stats(std::string prefix)
         std::cerr << prefix << std::setw(18) << std::left
                   << "Total miss rate:" << std::setw(20) << std::fixed
                   << std::setprecision(2) << std::right
-                  << ((float)num_misses_ * 100 /
-                      (num_hits_ + num_child_hits_ + num_misses_))
+                  << ((float)scale_sampled(num_misses_) * 100 /
+                      (scale_sampled(num_hits_) + num_child_hits_ +
+                       scale_sampled(num_misses_)))
                   << "%" << std::endl;
     }
 }
@@ -221,7 +332,10 @@ caching_device_stats_t::print_stats(std::string prefix)
         print_warmup(prefix);
     }
     print_counts(prefix);
+    print_prefetcher_counts(prefix);
     print_rates(prefix);
+    if (sampling_)
+        print_sampling(prefix);
     print_child_stats(prefix);
     std::cerr.imbue(std::locale("C")); // Reset to avoid affecting later prints.
 }
@@ -238,6 +352,32 @@ caching_device_stats_t::reset()
     num_child_hits_ = 0;
     num_inclusive_invalidates_ = 0;
     num_coherence_invalidates_ = 0;
+    num_prefetches_issued_ = 0;
+    num_prefetches_useful_ = 0;
+    num_prefetches_late_ = 0;
+    num_prefetches_polluting_ = 0;
+    std::fill(set_hits_.begin(), set_hits_.end(), 0);
+    std::fill(set_misses_.begin(), set_misses_.end(), 0);
+    if (pc_misses_ != nullptr)
+        pc_misses_->clear();
+}
+
+void
+caching_device_stats_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write(num_hits_at_reset_);
+    out.write(num_misses_at_reset_);
+    out.write(num_child_hits_at_reset_);
+    access_count_.save_state(out);
+}
+
+bool
+caching_device_stats_t::restore_state(checkpoint_reader_t &in)
+{
+    in.read(num_hits_at_reset_);
+    in.read(num_misses_at_reset_);
+    in.read(num_child_hits_at_reset_);
+    return access_count_.restore_state(in);
 }
 
 void
@@ -37,10 +37,14 @@
 #define _CACHING_DEVICE_STATS_H_ 1
 
 #include "caching_device_block.h"
+#include "checkpoint.h"
+#include "tag_table.h"
+#include <memory>
 #include <string>
 #include <map>
 #include <stdint.h>
 #include <limits>
+#include <vector>
 #ifdef HAS_ZLIB
 #    include <zlib.h>
 #endif
@@ -63,7 +67,11 @@ enum class metric_name_t {
     COHERENCE_INVALIDATES,
     PREFETCH_HITS,
     PREFETCH_MISSES,
-    FLUSHES
+    FLUSHES,
+    PREFETCHES_ISSUED,
+    PREFETCHES_USEFUL,
+    PREFETCHES_LATE,
+    PREFETCHES_POLLUTING
 };
 
 struct bound {
@@ -141,6 +149,31 @@ public:
         }
     }
 
+    void
+    save_state(checkpoint_writer_t &out) const
+    {
+        out.write<uint64_t>(bounds.size());
+        for (const auto &bound : bounds) {
+            out.write(bound.first);
+            out.write(bound.second);
+        }
+    }
+
+    bool
+    restore_state(checkpoint_reader_t &in)
+    {
+        uint64_t count;
+        in.read(count);
+        bounds.clear();
+        for (uint64_t i = 0; i < count && !!in; ++i) {
+            addr_t beg, end;
+            in.read(beg);
+            in.read(end);
+            bounds.emplace_hint(bounds.end(), beg, end);
+        }
+        return !!in;
+    }
+
 private:
     // Bounds are members of the std::map. The beginning of the bound is stored
     // as a key and the end as a value.
@@ -172,6 +205,13 @@ public:
     virtual void
     reset();
 
+    // Writes the state that reset() keeps: the counts at the last reset and the
+    // blocks ever accessed, from which compulsory misses are derived.
+    virtual void
+    save_state(checkpoint_writer_t &out) const;
+    virtual bool
+    restore_state(checkpoint_reader_t &in);
+
     virtual bool operator!()
     {
         return !success_;
@@ -181,11 +221,69 @@ public:
     virtual void
     invalidate(invalidation_type_t invalidation_type);
 
+    // Called by a caching device with a prefetcher for each line its prefetcher
+    // brings in.
+    void
+    prefetch_issued()
+    {
+        num_prefetches_issued_++;
+    }
+    // Called by a caching device with a prefetcher for the first demand hit on a
+    // line its prefetcher brought in.  A late use is one that came too soon after
+    // the prefetch for the line to have arrived.
+    void
+    prefetch_used(bool late)
+    {
+        num_prefetches_useful_++;
+        if (late)
+            num_prefetches_late_++;
+    }
+    // Called by a caching device with a prefetcher for a demand miss on a line
+    // that was evicted to make room for a prefetched line.
+    void
+    prefetch_polluted()
+    {
+        num_prefetches_polluting_++;
+    }
+
+    // Starts counting misses per instruction address, for reporting which
+    // instructions cause the most misses.  The counts are cleared by reset().
+    void
+    enable_pc_attribution()
+    {
+        if (pc_misses_ == nullptr)
+            pc_misses_.reset(new tag_table_t<int_least64_t>);
+    }
+    // Returns nullptr unless enable_pc_attribution() was called.
+    const tag_table_t<int_least64_t> *
+    get_pc_misses() const
+    {
+        return pc_misses_.get();
+    }
+
+    // Called by a caching device that only simulates the given subset of its
+    // num_sets sets.  Hit and miss counts are then scaled to estimates for the whole
+    // device, both when printed and in get_metric(), and the printed statistics
+    // include 95% confidence intervals computed from the per-set variation.  An
+    // empty set list disables sampling.
+    virtual void
+    set_sampling(const std::vector<int> &sampled_sets, int num_sets,
+                 int block_size_bits);
+
     int_least64_t
     get_metric(metric_name_t metric) const
     {
         if (stats_map_.find(metric) != stats_map_.end()) {
-            return stats_map_.at(metric);
+            int_least64_t value = stats_map_.at(metric);
+            // Child hits come from unsampled children and invalidations are rare
+            // enough that we leave them unscaled.
+            if (sampling_ &&
+                (metric == metric_name_t::HITS || metric == metric_name_t::MISSES ||
+                 metric == metric_name_t::HITS_AT_RESET ||
+                 metric == metric_name_t::MISSES_AT_RESET ||
+                 metric == metric_name_t::COMPULSORY_MISSES))
+                value = scale_sampled(value);
+            return value;
         } else {
             ERRMSG("Wrong metric name.\n");
             return 0;
@@ -204,10 +302,22 @@ protected:
     print_rates(std::string prefix); // hit/miss rates
     virtual void
     print_child_stats(std::string prefix); // child/total info
+    virtual void
+    print_prefetcher_counts(std::string prefix); // prefetcher effectiveness
 
     virtual void
     dump_miss(const memref_t &memref);
 
+    int_least64_t
+    scale_sampled(int_least64_t count) const
+    {
+        return static_cast<int_least64_t>(count * sampling_scale_ + 0.5);
+    }
+    // Prints the sample size and the confidence intervals for the estimated miss
+    // count and miss rate.
+    void
+    print_sampling(std::string prefix);
+
     void
     check_compulsory_miss(addr_t addr);
 
@@ -219,6 +329,12 @@ protected:
     int_least64_t num_inclusive_invalidates_;
     int_least64_t num_coherence_invalidates_;
 
+    // Hardware prefetcher effectiveness: see prefetch_issued() and friends.
+    int_least64_t num_prefetches_issued_;
+    int_least64_t num_prefetches_useful_;
+    int_least64_t num_prefetches_late_;
+    int_least64_t num_prefetches_polluting_;
+
     // Stats saved when the last reset was called. This helps us get insight
     // into what the stats were when the cache was warmed up.
     int_least64_t num_hits_at_reset_;
@@ -238,6 +354,20 @@ protected:
     bool dump_misses_;
 
     access_count_t access_count_;
+
+    // Misses per instruction address: see enable_pc_attribution().
+    std::unique_ptr<tag_table_t<int_least64_t>> pc_misses_;
+
+    // Set sampling state: see set_sampling().
+    bool sampling_ = false;
+    double sampling_scale_ = 1.0;
+    int num_sets_ = 0;
+    addr_t set_mask_ = 0;
+    int block_size_bits_ = 0;
+    std::vector<int> sampled_sets_;
+    // Per-set counts since the last reset, indexed by set.
+    std::vector<int_least64_t> set_hits_;
+    std::vector<int_least64_t> set_misses_;
 #ifdef HAS_ZLIB
     gzFile file_;
 #else
@@ -0,0 +1,114 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "checkpoint.h"
+#include <fstream>
+
+static const uint64_t CHECKPOINT_MAGIC = 0x54504b434d495344ULL; // "DSIMCKPT"
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+void
+checkpoint_writer_t::write_header(const std::string &kind, uint64_t position)
+{
+    write(CHECKPOINT_MAGIC);
+    write(CHECKPOINT_VERSION);
+    write_string(kind);
+    write(position);
+}
+
+bool
+checkpoint_reader_t::read_header(const std::string &kind, uint64_t &position,
+                                 std::string &error)
+{
+    uint64_t magic;
+    uint32_t version;
+    std::string stored_kind;
+    read(magic);
+    if (failed_ || magic != CHECKPOINT_MAGIC) {
+        error = "not a simulator checkpoint";
+        return false;
+    }
+    read(version);
+    if (failed_ || version != CHECKPOINT_VERSION) {
+        error = "unsupported checkpoint version";
+        return false;
+    }
+    read_string(stored_kind);
+    read(position);
+    if (failed_) {
+        error = "truncated checkpoint";
+        return false;
+    }
+    if (!kind.empty() && stored_kind != kind) {
+        error = "checkpoint was written by the " + stored_kind + " simulator";
+        return false;
+    }
+    return true;
+}
+
+void
+checkpoint_reader_t::read_string(std::string &value)
+{
+    std::vector<char> chars;
+    read_vector(chars);
+    value.assign(chars.begin(), chars.end());
+}
+
+uint64_t
+checkpoint_reader_t::remaining()
+{
+    std::streampos cur = in_.tellg();
+    if (cur == std::streampos(-1))
+        return 0;
+    in_.seekg(0, std::ios::end);
+    std::streampos end = in_.tellg();
+    in_.seekg(cur);
+    return end > cur ? static_cast<uint64_t>(end - cur) : 0;
+}
+
+bool
+checkpoint_read_position(const std::string &path, uint64_t &position,
+                         std::string &error)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        error = "failed to open checkpoint " + path;
+        return false;
+    }
+    checkpoint_reader_t reader(in);
+    if (!reader.read_header("", position, error)) {
+        error = "failed to read checkpoint " + path + ": " + error;
+        return false;
+    }
+    return true;
+}
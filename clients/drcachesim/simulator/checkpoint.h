@@ -0,0 +1,196 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* checkpoint: reads and writes binary checkpoints of simulator state.
+ */
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_ 1
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// A checkpoint starts with a header holding a magic number, a format version, the
+// kind of simulator that wrote it, and the number of trace records the simulator
+// had been handed, which is where a restored simulation resumes reading the
+// trace.  The simulator state follows, written field by field in host byte order:
+// a checkpoint is only meant to be restored on the host that wrote it by a build
+// of the same version.
+
+// Writes a checkpoint to a binary stream.  Failures are sticky and reported by
+// operator!.
+class checkpoint_writer_t {
+public:
+    explicit checkpoint_writer_t(std::ostream &out)
+        : out_(out)
+    {
+    }
+
+    void
+    write_header(const std::string &kind, uint64_t position);
+
+    template <typename T>
+    void
+    write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "must be a plain value");
+        out_.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    template <typename T>
+    void
+    write_array(const T *values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "must be a plain value");
+        write<uint64_t>(count);
+        out_.write(reinterpret_cast<const char *>(values), count * sizeof(T));
+    }
+    template <typename T>
+    void
+    write_vector(const std::vector<T> &values)
+    {
+        write_array(values.data(), values.size());
+    }
+    void
+    write_string(const std::string &value)
+    {
+        write_array(value.data(), value.size());
+    }
+
+    bool operator!()
+    {
+        return !out_;
+    }
+
+private:
+    std::ostream &out_;
+};
+
+// Reads a checkpoint written by checkpoint_writer_t.  Failures, including reading
+// past the end and mismatches found by expect(), are sticky and reported by
+// operator!, after which the values read are unspecified.
+class checkpoint_reader_t {
+public:
+    explicit checkpoint_reader_t(std::istream &in)
+        : in_(in)
+    {
+    }
+
+    // Reads the header, checking that it was written by a simulator of the
+    // given kind, and returns the position it records.
+    bool
+    read_header(const std::string &kind, uint64_t &position, std::string &error);
+
+    template <typename T>
+    void
+    read(T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "must be a plain value");
+        if (!in_.read(reinterpret_cast<char *>(&value), sizeof(value)))
+            failed_ = true;
+    }
+    // Reads an array that must hold exactly "count" values, as for the blocks of
+    // a device of known geometry.
+    template <typename T>
+    void
+    read_array(T *values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "must be a plain value");
+        uint64_t stored;
+        read(stored);
+        if (failed_ || stored != count) {
+            failed_ = true;
+            return;
+        }
+        if (!in_.read(reinterpret_cast<char *>(values), count * sizeof(T)))
+            failed_ = true;
+    }
+    template <typename T>
+    void
+    read_vector(std::vector<T> &values)
+    {
+        uint64_t count;
+        read(count);
+        // Reject sizes beyond what remains rather than allocating them.
+        if (failed_ || count > remaining() / sizeof(T)) {
+            failed_ = true;
+            return;
+        }
+        values.resize(static_cast<size_t>(count));
+        if (!in_.read(reinterpret_cast<char *>(values.data()), count * sizeof(T)))
+            failed_ = true;
+    }
+    void
+    read_string(std::string &value);
+    // Reads a value and fails unless it equals "expected", as for the geometry
+    // of the device being restored.
+    template <typename T>
+    void
+    expect(const T &expected)
+    {
+        T value;
+        read(value);
+        if (value != expected)
+            failed_ = true;
+    }
+
+    // Records a mismatch found by the caller.
+    void
+    fail()
+    {
+        failed_ = true;
+    }
+
+    bool operator!()
+    {
+        return failed_;
+    }
+
+private:
+    uint64_t
+    remaining();
+
+    std::istream &in_;
+    bool failed_ = false;
+};
+
+// Returns in "position" the trace position recorded in the checkpoint at
+// "path", which a reader skips to before a restored simulation resumes.
+bool
+checkpoint_read_position(const std::string &path, uint64_t &position,
+                         std::string &error);
+
+#endif /* _CHECKPOINT_H_ */
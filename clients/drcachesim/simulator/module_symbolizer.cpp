@@ -0,0 +1,141 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "module_symbolizer.h"
+#include "drsyms.h"
+#include "../common/utils.h"
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+module_symbolizer_t::module_symbolizer_t(const std::string &module_file_path,
+                                         const std::string &alt_module_dir,
+                                         unsigned int verbose)
+    : module_file_path_(module_file_path)
+    , alt_module_dir_(alt_module_dir)
+    , verbose_(verbose)
+{
+}
+
+module_symbolizer_t::~module_symbolizer_t()
+{
+    if (drsyms_initialized_)
+        drsym_exit();
+}
+
+std::string
+module_symbolizer_t::initialize()
+{
+    if (module_file_path_.empty())
+        return "Module file path is missing";
+    dr_standalone_init();
+    std::string error = directory_.initialize_module_file(module_file_path_);
+    if (!error.empty())
+        return "Failed to initialize directory: " + error;
+    module_mapper_ = module_mapper_t::create(directory_.modfile_bytes_, nullptr, nullptr,
+                                             nullptr, nullptr, verbose_, alt_module_dir_);
+    const std::vector<module_t> &modules = module_mapper_->get_loaded_modules();
+    error = module_mapper_->get_last_error();
+    if (!error.empty())
+        return "Failed to load binaries: " + error;
+    if (drsym_init(IF_WINDOWS_ELSE(NULL, 0)) != DRSYM_SUCCESS)
+        return "Failed to initialize symbol lookup";
+    drsyms_initialized_ = true;
+    // The later segments of a module follow its first one, whose load address is
+    // the base for symbol offsets.
+    std::unordered_map<std::string, addr_t> module_bases;
+    for (const module_t &module : modules) {
+        addr_t start = reinterpret_cast<addr_t>(module.orig_seg_base);
+        addr_t base = module_bases.emplace(module.path, start).first->second;
+        if (module.seg_size == 0)
+            continue;
+        segments_.push_back({ start, start + module.seg_size, base, module.path });
+    }
+    std::sort(segments_.begin(), segments_.end(),
+              [](const segment_t &a, const segment_t &b) { return a.start < b.start; });
+    return "";
+}
+
+std::string
+module_symbolizer_t::find_symbol_file(const std::string &path)
+{
+    auto it = symbol_files_.find(path);
+    if (it != symbol_files_.end())
+        return it->second;
+    // Like module_mapper_t, we prefer a copy in the alternate directory.
+    std::string file = path;
+    if (!alt_module_dir_.empty()) {
+        std::string basename = path;
+        size_t sep_index = basename.find_last_of(DIRSEP ALT_DIRSEP);
+        if (sep_index != std::string::npos)
+            basename = basename.substr(sep_index + 1);
+        std::string alt_path = alt_module_dir_ + DIRSEP + basename;
+        if (std::ifstream(alt_path.c_str()).good())
+            file = alt_path;
+    }
+    symbol_files_[path] = file;
+    return file;
+}
+
+void
+module_symbolizer_t::lookup(addr_t pc, std::string &module, std::string &function)
+{
+    module.clear();
+    function.clear();
+    auto it = std::upper_bound(
+        segments_.begin(), segments_.end(), pc,
+        [](addr_t value, const segment_t &segment) { return value < segment.start; });
+    if (it == segments_.begin())
+        return;
+    --it;
+    if (pc >= it->end)
+        return;
+    module = it->path;
+    size_t sep_index = module.find_last_of(DIRSEP ALT_DIRSEP);
+    if (sep_index != std::string::npos)
+        module = module.substr(sep_index + 1);
+    // Pseudo-modules such as "<unknown>", "<gencode>" and "[vdso]" have no file.
+    if (it->path.empty() || it->path[0] == '<' || it->path[0] == '[')
+        return;
+    char name[256];
+    drsym_info_t sym;
+    memset(&sym, 0, sizeof(sym));
+    sym.struct_size = sizeof(sym);
+    sym.name = name;
+    sym.name_size = sizeof(name);
+    drsym_error_t res =
+        drsym_lookup_address(find_symbol_file(it->path).c_str(), pc - it->module_base,
+                             &sym, DRSYM_DEMANGLE);
+    if (res == DRSYM_SUCCESS || res == DRSYM_ERROR_LINE_NOT_AVAILABLE)
+        function = name;
+}
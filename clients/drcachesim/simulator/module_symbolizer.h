@@ -0,0 +1,87 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* module_symbolizer: a pc_symbolizer_t for offline traces that uses the module
+ * list of the trace and the symbols of the modules it names.
+ */
+
+#ifndef _MODULE_SYMBOLIZER_H_
+#define _MODULE_SYMBOLIZER_H_ 1
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pc_symbolizer.h"
+#include "raw2trace.h"
+#include "raw2trace_directory.h"
+
+class module_symbolizer_t : public pc_symbolizer_t {
+public:
+    module_symbolizer_t(const std::string &module_file_path,
+                        const std::string &alt_module_dir, unsigned int verbose);
+    virtual ~module_symbolizer_t();
+    // Reads the module list and maps the modules it names.  Returns an empty
+    // string on success or the error otherwise.
+    std::string
+    initialize();
+    void
+    lookup(addr_t pc, std::string &module, std::string &function) override;
+
+protected:
+    struct segment_t {
+        addr_t start;
+        addr_t end;
+        // The load address of the first segment of the module, from which
+        // symbol offsets are measured.
+        addr_t module_base;
+        std::string path;
+    };
+
+    // Returns the path to read symbols from for the module recorded at "path".
+    std::string
+    find_symbol_file(const std::string &path);
+
+    std::string module_file_path_;
+    std::string alt_module_dir_;
+    unsigned int verbose_;
+    raw2trace_directory_t directory_;
+    std::unique_ptr<module_mapper_t> module_mapper_;
+    // Sorted by start address.
+    std::vector<segment_t> segments_;
+    std::unordered_map<std::string, std::string> symbol_files_;
+    bool drsyms_initialized_ = false;
+};
+
+#endif /* _MODULE_SYMBOLIZER_H_ */
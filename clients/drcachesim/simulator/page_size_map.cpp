@@ -0,0 +1,181 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "page_size_map.h"
+#include <algorithm>
+#include <sstream>
+
+static int
+log2_exact(uint64_t size)
+{
+    int bits = 0;
+    while ((uint64_t(1) << bits) < size && bits < 63)
+        ++bits;
+    return (uint64_t(1) << bits) == size ? bits : -1;
+}
+
+// Parses sizes such as "2M", "1G", "4096" or "2048 kB".
+static bool
+parse_size(std::istringstream &line, uint64_t &size)
+{
+    std::string value;
+    if (!(line >> value) || value.empty())
+        return false;
+    size_t digits = 0;
+    while (digits < value.size() && isdigit(static_cast<unsigned char>(value[digits])))
+        ++digits;
+    if (digits == 0)
+        return false;
+    size = std::stoull(value.substr(0, digits));
+    std::string unit = value.substr(digits);
+    if (unit.empty())
+        line >> unit;
+    if (unit.empty() || unit == "B")
+        return true;
+    switch (toupper(static_cast<unsigned char>(unit[0]))) {
+    case 'K': size <<= 10; break;
+    case 'M': size <<= 20; break;
+    case 'G': size <<= 30; break;
+    default: return false;
+    }
+    return true;
+}
+
+bool
+page_size_map_t::read(std::istream &in, std::string &error)
+{
+    std::string text;
+    int line_num = 0;
+    // The smaps mapping whose attributes are being read.
+    addr_t map_start = 0, map_end = 0;
+    bool in_mapping = false;
+    while (std::getline(in, text)) {
+        ++line_num;
+        std::istringstream line(text);
+        std::string first;
+        if (!(line >> first) || first[0] == '#')
+            continue;
+        size_t dash = first.find('-');
+        if (dash != std::string::npos) {
+            addr_t start, end;
+            std::istringstream start_in(first.substr(0, dash));
+            std::istringstream end_in(first.substr(dash + 1));
+            if (!(start_in >> std::hex >> start) || !(end_in >> std::hex >> end) ||
+                end <= start) {
+                error = "invalid address range on line " + std::to_string(line_num);
+                return false;
+            }
+            // An smaps mapping header is followed by its permissions.
+            std::istringstream peek(text.substr(text.find(first) + first.size()));
+            std::string next;
+            peek >> next;
+            if (next.size() == 4 && (next[0] == 'r' || next[0] == '-')) {
+                map_start = start;
+                map_end = end;
+                in_mapping = true;
+                continue;
+            }
+            uint64_t size;
+            int bits;
+            if (!parse_size(line, size) || (bits = log2_exact(size)) < 0) {
+                error = "invalid page size on line " + std::to_string(line_num);
+                return false;
+            }
+            add_range(start, end, bits);
+            in_mapping = false;
+        } else if (in_mapping &&
+                   (first == "KernelPageSize:" || first == "AnonHugePages:")) {
+            uint64_t size;
+            if (!parse_size(line, size)) {
+                error = "invalid size on line " + std::to_string(line_num);
+                return false;
+            }
+            int bits = log2_exact(size);
+            if (first == "KernelPageSize:" && bits > base_page_bits_)
+                add_range(map_start, map_end, bits);
+            else if (first == "AnonHugePages:" && size > 0)
+                add_range(map_start, map_end, 21);
+        }
+    }
+    return true;
+}
+
+void
+page_size_map_t::add_range(addr_t start, addr_t end, int page_bits)
+{
+    addr_t page_mask = (addr_t(1) << page_bits) - 1;
+    start = (start + page_mask) & ~page_mask;
+    end &= ~page_mask;
+    if (start >= end)
+        return;
+    std::vector<range_t> merged;
+    merged.reserve(ranges_.size() + 2);
+    for (const range_t &range : ranges_) {
+        // Keep the parts of older ranges outside of the new one.
+        if (range.end <= start || range.start >= end) {
+            merged.push_back(range);
+            continue;
+        }
+        if (range.start < start)
+            merged.push_back({ range.start, start, range.page_bits });
+        if (range.end > end)
+            merged.push_back({ end, range.end, range.page_bits });
+    }
+    // Base pages are implied outside of all ranges.
+    if (page_bits != base_page_bits_)
+        merged.push_back({ start, end, page_bits });
+    std::sort(merged.begin(), merged.end(),
+              [](const range_t &a, const range_t &b) { return a.start < b.start; });
+    ranges_.swap(merged);
+    last_size_ = 0;
+}
+
+int
+page_size_map_t::lookup_slow(addr_t addr)
+{
+    auto it = std::upper_bound(
+        ranges_.begin(), ranges_.end(), addr,
+        [](addr_t value, const range_t &range) { return value < range.start; });
+    // "it" is the first range starting after addr.
+    if (it != ranges_.begin() && addr < (it - 1)->end) {
+        --it;
+        last_start_ = it->start;
+        last_size_ = it->end - it->start;
+        last_bits_ = it->page_bits;
+    } else {
+        last_start_ = it == ranges_.begin() ? 0 : (it - 1)->end;
+        last_size_ = (it == ranges_.end() ? ~addr_t(0) : it->start) - last_start_;
+        last_bits_ = base_page_bits_;
+    }
+    return last_bits_;
+}
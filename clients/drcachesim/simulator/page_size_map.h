@@ -0,0 +1,105 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* page_size_map: maps virtual address ranges to the size of the pages backing them.
+ */
+
+#ifndef _PAGE_SIZE_MAP_H_
+#define _PAGE_SIZE_MAP_H_ 1
+
+#include <istream>
+#include <string>
+#include <vector>
+#include "memref.h"
+
+// Records which virtual address ranges are backed by pages larger than the base
+// page size.  Addresses outside of all ranges use base pages.
+class page_size_map_t {
+public:
+    explicit page_size_map_t(int base_page_bits)
+        : base_page_bits_(base_page_bits)
+    {
+    }
+
+    // Reads page size hints in either of two formats, which may be mixed:
+    // + Lines of the form "<start>-<end> <size>" with hexadecimal addresses and a
+    //   size such as 2M or 1G.
+    // + The contents of /proc/<pid>/smaps.  A mapping whose KernelPageSize is
+    //   larger than the base page size is backed by such pages, as for hugetlbfs.
+    //   A mapping with AnonHugePages is assumed to use transparent huge pages of
+    //   2M for all of its 2M-aligned range.
+    // Lines starting with '#' are ignored.  Returns false with an error message
+    // on a malformed line.
+    bool
+    read(std::istream &in, std::string &error);
+
+    // Backs [start, end) with pages of 2^page_bits bytes, shrunk to the aligned
+    // pages it fully contains.  Later ranges override earlier ones.
+    void
+    add_range(addr_t start, addr_t end, int page_bits);
+
+    bool
+    empty() const
+    {
+        return ranges_.empty();
+    }
+
+    // Returns log2 of the size of the page holding "addr".
+    inline int
+    lookup(addr_t addr)
+    {
+        if (addr - last_start_ < last_size_)
+            return last_bits_;
+        return lookup_slow(addr);
+    }
+
+protected:
+    struct range_t {
+        addr_t start;
+        addr_t end;
+        int page_bits;
+    };
+
+    int
+    lookup_slow(addr_t addr);
+
+    int base_page_bits_;
+    // Sorted and non-overlapping.
+    std::vector<range_t> ranges_;
+    // The last range or gap between ranges looked up, as [start, start + size).
+    addr_t last_start_ = 0;
+    addr_t last_size_ = 0;
+    int last_bits_ = 0;
+};
+
+#endif /* _PAGE_SIZE_MAP_H_ */
@@ -0,0 +1,280 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "page_walker.h"
+#include <iomanip>
+#include <iostream>
+#include "cache_simulator.h"
+
+// The virtual address bits translated by the page tables.
+static const int VIRTUAL_ADDRESS_BITS = 48;
+// The page tables are placed in the upper half of the address space, which
+// user-mode addresses in traces never reach.
+static const addr_t PAGE_TABLE_BASE = 0xffff800000000000ULL;
+
+// Returns a label such as "2M" for pages of 2^bits bytes.
+static std::string
+size_label(int bits)
+{
+    static const char units[] = { 'K', 'M', 'G', 'T' };
+    int unit = bits / 10 - 1;
+    if (unit < 0)
+        return std::to_string(uint64_t(1) << bits);
+    if (unit > 3)
+        unit = 3;
+    return std::to_string(uint64_t(1) << (bits - 10 * (unit + 1))) + units[unit];
+}
+
+page_walker_t::page_walker_t(unsigned int num_cores, int base_page_bits,
+                             unsigned int pwc_entries, unsigned int L1D_latency,
+                             unsigned int LL_latency, unsigned int memory_latency)
+    : cores_(num_cores)
+    , base_page_bits_(base_page_bits)
+    // Each page table is one base page of 8-byte entries.
+    , level_bits_(base_page_bits - 3)
+    , pwc_entries_(pwc_entries)
+    , L1D_latency_(L1D_latency)
+    , LL_latency_(LL_latency)
+    , memory_latency_(memory_latency)
+{
+    num_levels_ =
+        (VIRTUAL_ADDRESS_BITS - base_page_bits_ + level_bits_ - 1) / level_bits_;
+    if (num_levels_ < 1)
+        num_levels_ = 1;
+    for (core_t &core : cores_)
+        core.levels.resize(num_levels_);
+}
+
+bool
+page_walker_t::pwc_lookup(core_t &core, int level, memref_pid_t pid, addr_t key)
+{
+    for (pwc_entry_t &entry : core.levels[level].pwc) {
+        if (entry.key == key && entry.pid == pid) {
+            entry.last_use = ++core.pwc_clock;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+page_walker_t::pwc_insert(core_t &core, int level, memref_pid_t pid, addr_t key)
+{
+    std::vector<pwc_entry_t> &pwc = core.levels[level].pwc;
+    if (pwc.size() < pwc_entries_) {
+        pwc.push_back({ pid, key, ++core.pwc_clock });
+        return;
+    }
+    if (pwc.empty())
+        return;
+    pwc_entry_t *victim = &pwc[0];
+    for (pwc_entry_t &entry : pwc) {
+        if (entry.last_use < victim->last_use)
+            victim = &entry;
+    }
+    *victim = { pid, key, ++core.pwc_clock };
+}
+
+addr_t
+page_walker_t::entry_address(memref_pid_t pid, int level, addr_t vaddr)
+{
+    // The table holding this entry is the one the entry at the next level up
+    // points to, so it is identified by that entry's part of the address.
+    addr_t prefix = level + 1 < num_levels_ ? vaddr >> entry_shift(level + 1) : 0;
+    auto it = tables_.find({ pid, level, prefix });
+    if (it == tables_.end()) {
+        addr_t table = PAGE_TABLE_BASE + (addr_t(tables_.size()) << base_page_bits_);
+        it = tables_.insert({ { pid, level, prefix }, table }).first;
+    }
+    addr_t index = (vaddr >> entry_shift(level)) & ((addr_t(1) << level_bits_) - 1);
+    return it->second + index * sizeof(uint64_t);
+}
+
+int_least64_t
+page_walker_t::reference(const memref_t &memref, addr_t pte)
+{
+    if (caches_ == nullptr)
+        return L1D_latency_ + LL_latency_;
+    int_least64_t l1_misses = caches_->get_cache_metric(metric_name_t::MISSES, 1, core_);
+    int_least64_t ll_misses = caches_->get_cache_metric(metric_name_t::MISSES, 2, core_);
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.pid = memref.data.pid;
+    ref.data.tid = memref.data.tid;
+    ref.data.addr = pte;
+    ref.data.size = sizeof(uint64_t);
+    ref.data.pc = memref.data.pc;
+    caches_->process_memref(ref);
+    if (caches_->get_cache_metric(metric_name_t::MISSES, 1, core_) == l1_misses)
+        return L1D_latency_;
+    if (caches_->get_cache_metric(metric_name_t::MISSES, 2, core_) == ll_misses)
+        return L1D_latency_ + LL_latency_;
+    return L1D_latency_ + LL_latency_ + memory_latency_;
+}
+
+void
+page_walker_t::walk(const memref_t &memref, int page_bits)
+{
+    core_t &core = cores_[core_];
+    addr_t vaddr = memref.data.addr;
+    memref_pid_t pid = memref.data.pid;
+    int leaf = (page_bits - base_page_bits_) / level_bits_;
+    if (leaf >= num_levels_)
+        leaf = num_levels_ - 1;
+    ++core.levels[leaf].walks;
+    // Start below the lowest level whose entry the PWC holds.
+    int start = num_levels_ - 1;
+    for (int level = leaf + 1; level < num_levels_; ++level) {
+        if (pwc_lookup(core, level, pid, vaddr >> entry_shift(level))) {
+            ++core.levels[level].pwc_hits;
+            start = level - 1;
+            break;
+        }
+    }
+    for (int level = start; level >= leaf; --level) {
+        level_t &stats = core.levels[level];
+        ++stats.references;
+        stats.cycles += reference(memref, entry_address(pid, level, vaddr));
+        if (level > leaf)
+            pwc_insert(core, level, pid, vaddr >> entry_shift(level));
+    }
+}
+
+void
+page_walker_t::reset()
+{
+    for (core_t &core : cores_) {
+        for (level_t &level : core.levels) {
+            level.walks = 0;
+            level.references = 0;
+            level.pwc_hits = 0;
+            level.cycles = 0;
+        }
+    }
+}
+
+void
+page_walker_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write<uint64_t>(cores_.size());
+    out.write(num_levels_);
+    for (const core_t &core : cores_) {
+        out.write(core.pwc_clock);
+        for (const level_t &level : core.levels)
+            out.write_vector(level.pwc);
+    }
+    out.write<uint64_t>(tables_.size());
+    for (const auto &table : tables_) {
+        out.write(table.first.pid);
+        out.write(table.first.level);
+        out.write(table.first.prefix);
+        out.write(table.second);
+    }
+}
+
+bool
+page_walker_t::restore_state(checkpoint_reader_t &in)
+{
+    in.expect<uint64_t>(cores_.size());
+    in.expect(num_levels_);
+    for (core_t &core : cores_) {
+        in.read(core.pwc_clock);
+        for (level_t &level : core.levels) {
+            in.read_vector(level.pwc);
+            if (level.pwc.size() > pwc_entries_)
+                in.fail();
+        }
+    }
+    uint64_t count;
+    in.read(count);
+    tables_.clear();
+    for (uint64_t i = 0; i < count && !!in; ++i) {
+        table_key_t key;
+        addr_t table;
+        in.read(key.pid);
+        in.read(key.level);
+        in.read(key.prefix);
+        in.read(table);
+        tables_[key] = table;
+    }
+    return !!in;
+}
+
+int_least64_t
+page_walker_t::get_walks(int core) const
+{
+    int_least64_t walks = 0;
+    for (const level_t &level : cores_[core].levels)
+        walks += level.walks;
+    return walks;
+}
+
+void
+page_walker_t::print_results(int core, const std::string &prefix) const
+{
+    const std::vector<level_t> &levels = cores_[core].levels;
+    int_least64_t walks = get_walks(core);
+    int_least64_t cycles = 0;
+    for (const level_t &level : levels)
+        cycles += level.cycles;
+    std::cerr << prefix << std::setw(18) << std::left << "Walks:" << std::setw(20)
+              << std::right << walks << std::endl;
+    for (int i = 1; i < num_levels_; ++i) {
+        if (levels[i].walks == 0)
+            continue;
+        std::string label = size_label(entry_shift(i)) + " page walks:";
+        std::cerr << prefix << std::setw(18) << std::left << label << std::setw(20)
+                  << std::right << levels[i].walks << std::endl;
+    }
+    std::cerr << prefix << std::setw(18) << std::left << "Walk cycles:" << std::setw(20)
+              << std::right << cycles << std::endl;
+    if (walks > 0) {
+        std::cerr << prefix << std::setw(18) << std::left
+                  << "Avg walk cycles:" << std::setw(20) << std::fixed
+                  << std::setprecision(2) << std::right << double(cycles) / walks
+                  << std::endl;
+    }
+    // Levels are numbered from 1 for the leaf level of base pages, as the x86
+    // PML4 table is level 4.
+    for (int i = num_levels_ - 1; i >= 0; --i) {
+        std::string level = "Level " + std::to_string(i + 1) + " ";
+        std::cerr << prefix << std::setw(18) << std::left << level + "refs:"
+                  << std::setw(20) << std::right << levels[i].references << std::endl;
+        if (i > 0) {
+            std::cerr << prefix << std::setw(18) << std::left << level + "PWC hits:"
+                      << std::setw(20) << std::right << levels[i].pwc_hits << std::endl;
+        }
+        std::cerr << prefix << std::setw(18) << std::left << level + "cycles:"
+                  << std::setw(20) << std::right << levels[i].cycles << std::endl;
+    }
+}
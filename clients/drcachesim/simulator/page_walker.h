@@ -0,0 +1,189 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* page_walker: models the page table walks that follow last-level TLB misses.
+ */
+
+#ifndef _PAGE_WALKER_H_
+#define _PAGE_WALKER_H_ 1
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "checkpoint.h"
+#include "memref.h"
+
+class cache_simulator_t;
+
+// Walks radix page tables whose pages are base pages of 8-byte entries, as for
+// the x86-64 four-level tables and the AArch64 4K, 16K and 64K granules with
+// 48-bit virtual addresses.  Level 0 holds the entries of base pages, level 1
+// those of the next larger pages (2M with 4K base pages), and so on.  Each core
+// has a page walk cache (PWC) per non-leaf level, a small fully associative LRU
+// cache of the entries of that level, and a walk starts below the lowest level
+// whose entry it finds there.  Each page table is given a distinct synthetic
+// address when first walked.
+//
+// Each page table reference costs the L1 data cache latency plus the last-level
+// cache latency, unless a cache simulator is supplied, in which case the
+// reference is simulated there and costs the latency of the level that hits.
+class page_walker_t {
+public:
+    page_walker_t(unsigned int num_cores, int base_page_bits, unsigned int pwc_entries,
+                  unsigned int L1D_latency, unsigned int LL_latency,
+                  unsigned int memory_latency);
+
+    // Feeds page table references to "caches", which must simulate the same
+    // cores and threads, or to no simulator if nullptr.
+    void
+    set_caches(cache_simulator_t *caches)
+    {
+        caches_ = caches;
+    }
+
+    // Sets the core whose walks follow.
+    void
+    set_core(int core)
+    {
+        core_ = core;
+    }
+
+    // Walks the page tables for the access in "memref" to a page of
+    // 2^page_bits bytes.
+    void
+    walk(const memref_t &memref, int page_bits);
+
+    void
+    reset();
+
+    // Writes and restores the page walk caches and the page table addresses.
+    void
+    save_state(checkpoint_writer_t &out) const;
+    bool
+    restore_state(checkpoint_reader_t &in);
+
+    void
+    print_results(int core, const std::string &prefix) const;
+
+    int
+    get_num_levels() const
+    {
+        return num_levels_;
+    }
+    int_least64_t
+    get_walks(int core) const;
+    int_least64_t
+    get_references(int core, int level) const
+    {
+        return cores_[core].levels[level].references;
+    }
+    int_least64_t
+    get_pwc_hits(int core, int level) const
+    {
+        return cores_[core].levels[level].pwc_hits;
+    }
+    int_least64_t
+    get_cycles(int core, int level) const
+    {
+        return cores_[core].levels[level].cycles;
+    }
+
+protected:
+    struct pwc_entry_t {
+        memref_pid_t pid;
+        addr_t key;
+        uint64_t last_use;
+    };
+    struct level_t {
+        // Walks that end at this level.
+        int_least64_t walks = 0;
+        int_least64_t references = 0;
+        int_least64_t pwc_hits = 0;
+        int_least64_t cycles = 0;
+        std::vector<pwc_entry_t> pwc;
+    };
+    struct core_t {
+        std::vector<level_t> levels;
+        uint64_t pwc_clock = 0;
+    };
+    struct table_key_t {
+        memref_pid_t pid;
+        int level;
+        addr_t prefix;
+        bool
+        operator==(const table_key_t &other) const
+        {
+            return pid == other.pid && level == other.level && prefix == other.prefix;
+        }
+    };
+    struct table_key_hash_t {
+        size_t
+        operator()(const table_key_t &key) const
+        {
+            return std::hash<addr_t>()(key.prefix * 31 + key.level) ^
+                std::hash<memref_pid_t>()(key.pid);
+        }
+    };
+
+    // Returns log2 of the bytes mapped by one entry at "level".
+    inline int
+    entry_shift(int level) const
+    {
+        return base_page_bits_ + level * level_bits_;
+    }
+    bool
+    pwc_lookup(core_t &core, int level, memref_pid_t pid, addr_t key);
+    void
+    pwc_insert(core_t &core, int level, memref_pid_t pid, addr_t key);
+    addr_t
+    entry_address(memref_pid_t pid, int level, addr_t vaddr);
+    // Returns the cycles taken by a reference to "pte" for the access in "memref".
+    int_least64_t
+    reference(const memref_t &memref, addr_t pte);
+
+    std::vector<core_t> cores_;
+    int base_page_bits_;
+    int level_bits_;
+    int num_levels_;
+    unsigned int pwc_entries_;
+    unsigned int L1D_latency_;
+    unsigned int LL_latency_;
+    unsigned int memory_latency_;
+    std::unordered_map<table_key_t, addr_t, table_key_hash_t> tables_;
+    cache_simulator_t *caches_ = nullptr;
+    int core_ = 0;
+};
+
+#endif /* _PAGE_WALKER_H_ */
@@ -0,0 +1,274 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "parallel_cache_sim.h"
+#include <assert.h>
+#include "cache_stats.h"
+
+// Stands in for the shared parent of one core's L1 caches, recording the operations
+// that reach it from the core thread.  It has no parent of its own, so hits in the
+// L1 caches propagate child statistics no further.
+class parallel_cache_sim_t::deferred_parent_t : public cache_t {
+public:
+    explicit deferred_parent_t(int line_size)
+        : stats_recorder_(this, line_size)
+    {
+        parent_ = nullptr;
+        set_stats(&stats_recorder_);
+    }
+    ~deferred_parent_t() override
+    {
+    }
+    void
+    request(const memref_t &memref) override
+    {
+        record(PARENT_REQUEST, false, memref, nullptr);
+    }
+    void
+    flush(const memref_t &memref) override
+    {
+        record(PARENT_FLUSH, false, memref, nullptr);
+    }
+
+    std::vector<parent_event_t> *events_ = nullptr;
+    uint64_t seq_ = 0;
+
+private:
+    class stats_recorder_t : public cache_stats_t {
+    public:
+        stats_recorder_t(deferred_parent_t *parent, int line_size)
+            : cache_stats_t(line_size)
+            , parent_(parent)
+        {
+        }
+        void
+        child_access(const memref_t &memref, bool hit,
+                     caching_device_block_t *cache_block) override
+        {
+            parent_->record(PARENT_CHILD_ACCESS, hit, memref, cache_block);
+        }
+
+    private:
+        deferred_parent_t *parent_;
+    };
+
+    void
+    record(parent_op_t op, bool hit, const memref_t &memref,
+           caching_device_block_t *cache_block)
+    {
+        events_->push_back({ seq_, op, hit, memref, cache_block });
+    }
+
+    stats_recorder_t stats_recorder_;
+};
+
+parallel_cache_sim_t::parallel_cache_sim_t(bool deterministic, unsigned int epoch_size)
+    : deterministic_(deterministic)
+    , epoch_size_(epoch_size == 0 ? 1 : epoch_size)
+{
+}
+
+parallel_cache_sim_t::~parallel_cache_sim_t()
+{
+    finish();
+}
+
+bool
+parallel_cache_sim_t::init(cache_t **l1_icaches, cache_t **l1_dcaches,
+                           unsigned int num_cores, cache_t *llc, std::string &error)
+{
+    if (llc->is_inclusive()) {
+        error = "parallel simulation does not support an inclusive last-level cache";
+        return false;
+    }
+    for (unsigned int i = 0; i < num_cores; i++) {
+        if (l1_icaches[i]->get_parent() != llc || l1_dcaches[i]->get_parent() != llc) {
+            error = "parallel simulation requires all L1 caches to share one parent";
+            return false;
+        }
+        if (l1_icaches[i]->is_coherent() || l1_dcaches[i]->is_coherent()) {
+            error = "parallel simulation does not support coherent L1 caches";
+            return false;
+        }
+    }
+    llc_ = llc;
+    finished_ = false;
+    for (unsigned int i = 0; i < num_cores; i++) {
+        cores_.emplace_back(new core_t);
+        core_t *core = cores_.back().get();
+        core->icache = l1_icaches[i];
+        core->dcache = l1_dcaches[i];
+        core->parent.reset(new deferred_parent_t(llc->get_block_size()));
+        core->icache->set_parent(core->parent.get());
+        core->dcache->set_parent(core->parent.get());
+        core->work[0].reserve(epoch_size_);
+        core->work[1].reserve(epoch_size_);
+    }
+    // The first dispatch waits for all cores to be done with a prior epoch.
+    cores_done_ = num_cores;
+    for (auto &core : cores_)
+        core->thread = std::thread(&parallel_cache_sim_t::core_thread, this, core.get());
+    return true;
+}
+
+void
+parallel_cache_sim_t::add(int core, work_type_t type, const memref_t &memref)
+{
+    cores_[core]->work[fill_parity_].push_back({ next_seq_++, type, memref });
+    if (++queued_ >= epoch_size_)
+        dispatch();
+}
+
+void
+parallel_cache_sim_t::wait_for_cores(std::unique_lock<std::mutex> &lock)
+{
+    epoch_done_.wait(lock, [this] { return cores_done_ == cores_.size(); });
+}
+
+void
+parallel_cache_sim_t::dispatch()
+{
+    int parity = fill_parity_;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        wait_for_cores(lock);
+        cores_done_ = 0;
+        run_parity_ = parity;
+        ++epoch_;
+    }
+    epoch_start_.notify_all();
+    fill_parity_ = 1 - parity;
+    queued_ = 0;
+    // The cores are done with the other parity: replay the parent operations of
+    // the prior epoch while they simulate this one.
+    if (deterministic_)
+        replay_in_order(fill_parity_);
+}
+
+void
+parallel_cache_sim_t::core_thread(core_t *core)
+{
+    uint64_t seen_epoch = 0;
+    while (true) {
+        int parity;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            epoch_start_.wait(lock, [&] { return exiting_ || epoch_ != seen_epoch; });
+            if (exiting_)
+                return;
+            seen_epoch = epoch_;
+            parity = run_parity_;
+        }
+        core->parent->events_ = &core->events[parity];
+        for (const work_t &work : core->work[parity]) {
+            core->parent->seq_ = work.seq;
+            switch (work.type) {
+            case WORK_ICACHE_REQUEST: core->icache->request(work.memref); break;
+            case WORK_DCACHE_REQUEST: core->dcache->request(work.memref); break;
+            case WORK_ICACHE_FLUSH: core->icache->flush(work.memref); break;
+            case WORK_DCACHE_FLUSH: core->dcache->flush(work.memref); break;
+            }
+        }
+        core->work[parity].clear();
+        if (!deterministic_) {
+            std::lock_guard<std::mutex> guard(llc_lock_);
+            for (const parent_event_t &event : core->events[parity])
+                replay(event);
+            core->events[parity].clear();
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            ++cores_done_;
+        }
+        epoch_done_.notify_one();
+    }
+}
+
+void
+parallel_cache_sim_t::replay(const parent_event_t &event)
+{
+    switch (event.op) {
+    case PARENT_REQUEST: llc_->request(event.memref); break;
+    case PARENT_FLUSH: llc_->flush(event.memref); break;
+    case PARENT_CHILD_ACCESS:
+        llc_->record_child_access(event.memref, event.hit, event.cache_block);
+        break;
+    }
+}
+
+void
+parallel_cache_sim_t::replay_in_order(int parity)
+{
+    // Merge the per-core event lists, each of which is already in sequence order.
+    std::vector<size_t> next(cores_.size(), 0);
+    while (true) {
+        core_t *min_core = nullptr;
+        size_t min_idx = 0;
+        for (size_t i = 0; i < cores_.size(); ++i) {
+            std::vector<parent_event_t> &events = cores_[i]->events[parity];
+            if (next[i] < events.size() &&
+                (min_core == nullptr ||
+                 events[next[i]].seq < min_core->events[parity][next[min_idx]].seq)) {
+                min_core = cores_[i].get();
+                min_idx = i;
+            }
+        }
+        if (min_core == nullptr)
+            break;
+        replay(min_core->events[parity][next[min_idx]++]);
+    }
+    for (auto &core : cores_)
+        core->events[parity].clear();
+}
+
+void
+parallel_cache_sim_t::finish()
+{
+    if (finished_)
+        return;
+    finished_ = true;
+    dispatch();
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        wait_for_cores(lock);
+        exiting_ = true;
+    }
+    epoch_start_.notify_all();
+    for (auto &core : cores_)
+        core->thread.join();
+    if (deterministic_)
+        replay_in_order(1 - fill_parity_);
+    for (auto &core : cores_) {
+        core->icache->set_parent(llc_);
+        core->dcache->set_parent(llc_);
+    }
+}
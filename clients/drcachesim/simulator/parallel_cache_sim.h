@@ -0,0 +1,155 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* parallel_cache_sim: simulates each core's private caches on its own thread.
+ */
+
+#ifndef _PARALLEL_CACHE_SIM_H_
+#define _PARALLEL_CACHE_SIM_H_ 1
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache.h"
+#include "memref.h"
+
+// Drives the per-core L1 caches of a two-level hierarchy, where all L1 caches share
+// one parent, from one host thread per simulated core.  References are queued per
+// core by the caller and handed to the core threads in epochs of a fixed total size.
+// While a core thread simulates its L1 caches, each request, flush, or child
+// statistics update that would reach the shared parent is recorded instead, along
+// with the global sequence number of the reference that caused it.
+//
+// In deterministic mode the recorded parent operations of an epoch are replayed on
+// the caller's thread in sequence order while the core threads simulate the next
+// epoch, which reproduces the single-threaded results exactly.  Otherwise each core
+// thread replays its own operations under a lock at the end of its share of the
+// epoch, so that parent operations from different cores are reordered by at most one
+// epoch.
+//
+// The L1 caches must not be coherent or have children, and the parent must not be
+// inclusive, as otherwise the private caches would depend on the shared state;
+// init() rejects such hierarchies.
+class parallel_cache_sim_t {
+public:
+    enum work_type_t {
+        WORK_ICACHE_REQUEST,
+        WORK_DCACHE_REQUEST,
+        WORK_ICACHE_FLUSH,
+        WORK_DCACHE_FLUSH,
+    };
+
+    parallel_cache_sim_t(bool deterministic, unsigned int epoch_size);
+    ~parallel_cache_sim_t();
+
+    // Takes over the given L1 caches, whose parent must be "llc", and starts the
+    // core threads.  Returns false with an error message on failure.
+    bool
+    init(cache_t **l1_icaches, cache_t **l1_dcaches, unsigned int num_cores,
+         cache_t *llc, std::string &error);
+
+    // Queues "memref" for the given core.
+    void
+    add(int core, work_type_t type, const memref_t &memref);
+
+    // Completes the simulation of all queued references, stops the core threads,
+    // and gives the L1 caches back their parent.  It is safe to call this twice.
+    void
+    finish();
+
+private:
+    struct work_t {
+        uint64_t seq;
+        work_type_t type;
+        memref_t memref;
+    };
+    enum parent_op_t {
+        PARENT_REQUEST,
+        PARENT_FLUSH,
+        PARENT_CHILD_ACCESS,
+    };
+    struct parent_event_t {
+        uint64_t seq;
+        parent_op_t op;
+        bool hit;
+        memref_t memref;
+        // The block of the L1 cache that was accessed, for PARENT_CHILD_ACCESS.
+        caching_device_block_t *cache_block;
+    };
+    class deferred_parent_t;
+    struct core_t {
+        cache_t *icache;
+        cache_t *dcache;
+        std::unique_ptr<deferred_parent_t> parent;
+        // Double-buffered by epoch parity.
+        std::vector<work_t> work[2];
+        std::vector<parent_event_t> events[2];
+        std::thread thread;
+    };
+
+    void
+    core_thread(core_t *core);
+    void
+    wait_for_cores(std::unique_lock<std::mutex> &lock);
+    void
+    dispatch();
+    void
+    replay(const parent_event_t &event);
+    void
+    replay_in_order(int parity);
+
+    bool deterministic_;
+    unsigned int epoch_size_;
+    unsigned int queued_ = 0;
+    uint64_t next_seq_ = 0;
+    cache_t *llc_ = nullptr;
+    std::vector<std::unique_ptr<core_t>> cores_;
+    // The parity whose work vectors are currently being filled by add().
+    int fill_parity_ = 0;
+    bool finished_ = true;
+
+    // Guards the following fields, which coordinate the core threads.
+    std::mutex lock_;
+    std::condition_variable epoch_start_;
+    std::condition_variable epoch_done_;
+    uint64_t epoch_ = 0;
+    int run_parity_ = 0;
+    unsigned int cores_done_ = 0;
+    bool exiting_ = false;
+    // Serializes replay into the parent in non-deterministic mode.
+    std::mutex llc_lock_;
+};
+
+#endif /* _PARALLEL_CACHE_SIM_H_ */
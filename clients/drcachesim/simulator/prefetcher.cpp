@@ -35,9 +35,12 @@
 
 #include "caching_device.h"
 #include "../common/memref.h"
+#include "../common/utils.h"
 
-prefetcher_t::prefetcher_t(int block_size)
+prefetcher_t::prefetcher_t(int block_size, int late_refs)
     : block_size_(block_size)
+    , block_size_bits_(compute_log2(block_size))
+    , late_refs_(late_refs)
 {
     // Nothing else to do.
 }
@@ -51,3 +54,13 @@ prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref_in)
     memref.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
     cache->request(memref);
 }
+
+void
+prefetcher_t::issue(caching_device_t *cache, const memref_t &memref_in, addr_t addr)
+{
+    memref_t memref = memref_in;
+    memref.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
+    memref.data.addr = addr;
+    memref.data.size = 1;
+    cache->request(memref);
+}
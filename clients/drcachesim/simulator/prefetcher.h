@@ -40,18 +40,67 @@
 #include "memref.h"
 
 class caching_device_t;
+class checkpoint_reader_t;
+class checkpoint_writer_t;
 
+// Like hardware prefetchers, which see physical addresses, ours do not cross
+// pages of this size (in bits).
+static const int PREFETCH_PAGE_BITS = 12;
+
+// The base class implements a next-line prefetcher.  Subclasses implement other
+// algorithms by overriding prefetch().
 class prefetcher_t {
 public:
-    prefetcher_t(int block_size);
+    // A prefetched line whose first demand use comes within late_refs demand
+    // accesses to the cache after the prefetch is counted as late: see
+    // caching_device_stats_t::prefetch_used().
+    prefetcher_t(int block_size, int late_refs = 0);
     virtual ~prefetcher_t()
     {
     }
+    // Called by the cache owning this prefetcher on each demand miss, and also on
+    // each demand hit if trains_on_hits() is true.
     virtual void
     prefetch(caching_device_t *cache, const memref_t &memref);
 
-private:
+    // Writes and restores the training state of the prefetcher, of which the
+    // next-line prefetcher has none.
+    virtual void
+    save_state(checkpoint_writer_t &out) const
+    {
+    }
+    virtual bool
+    restore_state(checkpoint_reader_t &in)
+    {
+        return true;
+    }
+
+    bool
+    trains_on_hits() const
+    {
+        return trains_on_hits_;
+    }
+    int
+    get_late_refs() const
+    {
+        return late_refs_;
+    }
+
+protected:
+    // Requests the line holding addr from cache as a hardware prefetch.
+    void
+    issue(caching_device_t *cache, const memref_t &memref, addr_t addr);
+    // Returns the PC of the instruction behind memref.
+    static inline addr_t
+    memref_pc(const memref_t &memref)
+    {
+        return type_is_instr(memref.instr.type) ? memref.instr.addr : memref.data.pc;
+    }
+
     int block_size_;
+    int block_size_bits_;
+    int late_refs_;
+    bool trains_on_hits_ = false;
 };
 
 #endif /* _PREFETCHER_H_ */
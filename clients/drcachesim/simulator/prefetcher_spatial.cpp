@@ -0,0 +1,117 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "prefetcher_spatial.h"
+#include "caching_device.h"
+#include "checkpoint.h"
+#include "../common/utils.h"
+
+// This follows spatial memory streaming: while a region is active we record a
+// bitmap of the lines accessed in it.  When it leaves the active table its bitmap
+// is stored under its trigger, the PC and offset of the access that started it.
+// A later access that starts a new active region with the same trigger fetches
+// the other lines of the stored bitmap.  Hardware ends a region's generation when
+// one of its lines leaves the cache; we approximate that by the active table's
+// replacement.
+
+prefetcher_spatial_t::prefetcher_spatial_t(int block_size, int late_refs)
+    : prefetcher_t(block_size, late_refs)
+    , active_(NUM_ACTIVE_REGIONS)
+    , patterns_(PATTERN_TABLE_SIZE)
+{
+    // Every access has to be recorded in the region bitmaps.
+    trains_on_hits_ = true;
+    region_bits_ = compute_log2(REGION_SIZE);
+    if (region_bits_ - block_size_bits_ > 6)
+        region_bits_ = block_size_bits_ + 6;
+    else if (region_bits_ < block_size_bits_)
+        region_bits_ = block_size_bits_;
+    region_lines_ = 1 << (region_bits_ - block_size_bits_);
+}
+
+void
+prefetcher_spatial_t::prefetch(caching_device_t *cache, const memref_t &memref)
+{
+    addr_t addr = memref.data.addr;
+    // Index active entries from 1 so that the zero-initialized entries are free.
+    addr_t region = (addr >> region_bits_) + 1;
+    int offset = static_cast<int>((addr >> block_size_bits_) & (region_lines_ - 1));
+    ++use_count_;
+    region_t *lru = &active_[0];
+    for (region_t &entry : active_) {
+        if (entry.region == region) {
+            entry.bitmap |= 1ULL << offset;
+            entry.last_use = use_count_;
+            return;
+        }
+        if (entry.last_use < lru->last_use)
+            lru = &entry;
+    }
+    // Store the pattern of the region we replace, unless it never went beyond
+    // its trigger.
+    if (lru->region != 0 && (lru->bitmap & (lru->bitmap - 1)) != 0) {
+        pattern_t &pattern = get_pattern(lru->trigger);
+        pattern.trigger = lru->trigger;
+        pattern.bitmap = lru->bitmap;
+    }
+    addr_t trigger = compute_trigger(memref_pc(memref), offset);
+    lru->region = region;
+    lru->trigger = trigger;
+    lru->bitmap = 1ULL << offset;
+    lru->last_use = use_count_;
+
+    pattern_t &pattern = get_pattern(trigger);
+    if (pattern.trigger != trigger || pattern.bitmap == 0)
+        return;
+    addr_t base = (region - 1) << region_bits_;
+    for (int line = 0; line < region_lines_; ++line) {
+        if (line != offset && (pattern.bitmap & (1ULL << line)) != 0)
+            issue(cache, memref, base + (static_cast<addr_t>(line) << block_size_bits_));
+    }
+}
+
+void
+prefetcher_spatial_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write_vector(active_);
+    out.write_vector(patterns_);
+    out.write(use_count_);
+}
+
+bool
+prefetcher_spatial_t::restore_state(checkpoint_reader_t &in)
+{
+    in.read_array(active_.data(), active_.size());
+    in.read_array(patterns_.data(), patterns_.size());
+    in.read(use_count_);
+    return !!in;
+}
@@ -0,0 +1,94 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_spatial: a hardware prefetcher that learns which lines of a memory
+ * region are used together and fetches them all when the region is next touched.
+ */
+
+#ifndef _PREFETCHER_SPATIAL_H_
+#define _PREFETCHER_SPATIAL_H_ 1
+
+#include <stdint.h>
+#include <vector>
+#include "prefetcher.h"
+
+class prefetcher_spatial_t : public prefetcher_t {
+public:
+    prefetcher_spatial_t(int block_size, int late_refs = 0);
+    void
+    prefetch(caching_device_t *cache, const memref_t &memref) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // Regions are this many bytes, or 64 lines if that is smaller, so that a
+    // region's lines fit in a 64-bit bitmap.
+    static const int REGION_SIZE = 2048;
+    // The number of regions whose accesses are being recorded at once, with
+    // least-recently-used replacement.
+    static const int NUM_ACTIVE_REGIONS = 64;
+    // The pattern table is direct-mapped by the PC and region offset of the
+    // access that first touched a region.
+    static const int PATTERN_TABLE_SIZE = 2048;
+
+protected:
+    struct region_t {
+        addr_t region = 0;
+        addr_t trigger = 0;
+        uint64_t bitmap = 0;
+        uint64_t last_use = 0;
+    };
+    struct pattern_t {
+        addr_t trigger = 0;
+        uint64_t bitmap = 0;
+    };
+    inline addr_t
+    compute_trigger(addr_t pc, int offset) const
+    {
+        // Offsets take at most 6 bits.
+        return (pc << 6) | offset;
+    }
+    inline pattern_t &
+    get_pattern(addr_t trigger)
+    {
+        return patterns_[(trigger ^ (trigger >> 11)) & (PATTERN_TABLE_SIZE - 1)];
+    }
+
+    int region_bits_;
+    int region_lines_;
+    std::vector<region_t> active_;
+    std::vector<pattern_t> patterns_;
+    uint64_t use_count_ = 0;
+};
+
+#endif /* _PREFETCHER_SPATIAL_H_ */
@@ -0,0 +1,109 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "prefetcher_stream.h"
+#include "caching_device.h"
+#include "checkpoint.h"
+
+// An access that is not within the window of any stream starts a new stream in
+// place of the least recently used one.  A stream's prefetches run ahead of its
+// last access in its direction and stay within that access's page.
+
+prefetcher_stream_t::prefetcher_stream_t(int block_size, int late_refs)
+    : prefetcher_t(block_size, late_refs)
+    , streams_(NUM_STREAMS)
+{
+    // Training on hits lets the prefetcher keep up once its prefetches hit.
+    trains_on_hits_ = true;
+}
+
+void
+prefetcher_stream_t::prefetch(caching_device_t *cache, const memref_t &memref)
+{
+    addr_t line = memref.data.addr >> block_size_bits_;
+    ++use_count_;
+    stream_t *lru = &streams_[0];
+    for (stream_t &stream : streams_) {
+        if (!stream.valid) {
+            if (lru->valid)
+                lru = &stream;
+            continue;
+        }
+        if (lru->valid && stream.last_use < lru->last_use)
+            lru = &stream;
+        int64_t distance = static_cast<int64_t>(line - stream.last_line);
+        if (distance < -WINDOW || distance > WINDOW)
+            continue;
+        stream.last_use = use_count_;
+        if (distance == 0)
+            return;
+        int direction = distance > 0 ? 1 : -1;
+        if (direction == stream.direction) {
+            if (stream.confidence < CONFIDENCE_THRESHOLD)
+                ++stream.confidence;
+        } else {
+            stream.direction = direction;
+            stream.confidence = 0;
+        }
+        stream.last_line = line;
+        if (stream.confidence < CONFIDENCE_THRESHOLD)
+            return;
+        addr_t page = memref.data.addr >> PREFETCH_PAGE_BITS;
+        for (int i = 1; i <= DEGREE; ++i) {
+            addr_t target = (line + i * direction) << block_size_bits_;
+            if (target >> PREFETCH_PAGE_BITS != page)
+                break;
+            issue(cache, memref, target);
+        }
+        return;
+    }
+    lru->valid = true;
+    lru->last_line = line;
+    lru->direction = 0;
+    lru->confidence = 0;
+    lru->last_use = use_count_;
+}
+
+void
+prefetcher_stream_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write_vector(streams_);
+    out.write(use_count_);
+}
+
+bool
+prefetcher_stream_t::restore_state(checkpoint_reader_t &in)
+{
+    in.read_array(streams_.data(), streams_.size());
+    in.read(use_count_);
+    return !!in;
+}
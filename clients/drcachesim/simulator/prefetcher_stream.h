@@ -0,0 +1,75 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_stream: a hardware prefetcher that follows several streams of
+ * ascending or descending line accesses at once.
+ */
+
+#ifndef _PREFETCHER_STREAM_H_
+#define _PREFETCHER_STREAM_H_ 1
+
+#include <stdint.h>
+#include <vector>
+#include "prefetcher.h"
+
+class prefetcher_stream_t : public prefetcher_t {
+public:
+    prefetcher_stream_t(int block_size, int late_refs = 0);
+    void
+    prefetch(caching_device_t *cache, const memref_t &memref) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // The number of streams tracked at once, with least-recently-used replacement.
+    static const int NUM_STREAMS = 16;
+    // An access within this many lines of a stream's last access continues it.
+    static const int WINDOW = 16;
+    // A stream is followed once it has moved in the same direction this many
+    // times in a row, and then the next DEGREE lines in that direction are fetched.
+    static const int CONFIDENCE_THRESHOLD = 2;
+    static const int DEGREE = 4;
+
+protected:
+    struct stream_t {
+        bool valid = false;
+        addr_t last_line = 0;
+        int direction = 0;
+        int confidence = 0;
+        uint64_t last_use = 0;
+    };
+    std::vector<stream_t> streams_;
+    uint64_t use_count_ = 0;
+};
+
+#endif /* _PREFETCHER_STREAM_H_ */
@@ -0,0 +1,103 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "prefetcher_stride.h"
+#include "caching_device.h"
+#include "checkpoint.h"
+
+// Each table entry tracks the last line accessed by one instruction and the
+// distance to the line before it.  An entry for another instruction that maps to
+// the same slot replaces it.  A stride that differs from the recorded one lowers
+// the confidence, and replaces the recorded stride once the confidence is gone.
+// Prefetches stay within the page of the access.
+
+prefetcher_stride_t::prefetcher_stride_t(int block_size, int late_refs)
+    : prefetcher_t(block_size, late_refs)
+    , table_(TABLE_SIZE)
+{
+    // Training on hits lets the prefetcher keep up once its prefetches hit.
+    trains_on_hits_ = true;
+}
+
+void
+prefetcher_stride_t::prefetch(caching_device_t *cache, const memref_t &memref)
+{
+    // Instruction fetches have no separate PC to train on.
+    if (type_is_instr(memref.instr.type))
+        return;
+    addr_t pc = memref.data.pc;
+    addr_t line = memref.data.addr >> block_size_bits_;
+    entry_t &entry = table_[(pc ^ (pc >> 8)) & (TABLE_SIZE - 1)];
+    if (entry.pc != pc) {
+        entry.pc = pc;
+        entry.last_line = line;
+        entry.stride = 0;
+        entry.confidence = 0;
+        return;
+    }
+    int64_t stride = static_cast<int64_t>(line - entry.last_line);
+    if (stride == 0)
+        return;
+    entry.last_line = line;
+    if (stride == entry.stride) {
+        if (entry.confidence < CONFIDENCE_MAX)
+            ++entry.confidence;
+    } else {
+        if (entry.confidence > 0)
+            --entry.confidence;
+        if (entry.confidence == 0)
+            entry.stride = stride;
+        return;
+    }
+    if (entry.confidence < CONFIDENCE_THRESHOLD)
+        return;
+    addr_t page = memref.data.addr >> PREFETCH_PAGE_BITS;
+    for (int i = 1; i <= DEGREE; ++i) {
+        addr_t target = (line + i * entry.stride) << block_size_bits_;
+        if (target >> PREFETCH_PAGE_BITS != page)
+            break;
+        issue(cache, memref, target);
+    }
+}
+
+void
+prefetcher_stride_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write_vector(table_);
+}
+
+bool
+prefetcher_stride_t::restore_state(checkpoint_reader_t &in)
+{
+    in.read_array(table_.data(), table_.size());
+    return !!in;
+}
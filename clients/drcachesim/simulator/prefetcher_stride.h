@@ -0,0 +1,72 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* prefetcher_stride: a hardware prefetcher that detects a constant stride in the
+ * lines accessed by each instruction.
+ */
+
+#ifndef _PREFETCHER_STRIDE_H_
+#define _PREFETCHER_STRIDE_H_ 1
+
+#include <stdint.h>
+#include <vector>
+#include "prefetcher.h"
+
+class prefetcher_stride_t : public prefetcher_t {
+public:
+    prefetcher_stride_t(int block_size, int late_refs = 0);
+    void
+    prefetch(caching_device_t *cache, const memref_t &memref) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // The table is direct-mapped by PC.
+    static const int TABLE_SIZE = 256;
+    // A stride is used once it has been seen this many times in a row, counting
+    // up to CONFIDENCE_MAX, and then the next DEGREE lines along it are fetched.
+    static const int CONFIDENCE_THRESHOLD = 2;
+    static const int CONFIDENCE_MAX = 3;
+    static const int DEGREE = 2;
+
+protected:
+    struct entry_t {
+        addr_t pc = 0;
+        addr_t last_line = 0;
+        int64_t stride = 0; // In lines.
+        int confidence = 0;
+    };
+    std::vector<entry_t> table_;
+};
+
+#endif /* _PREFETCHER_STRIDE_H_ */
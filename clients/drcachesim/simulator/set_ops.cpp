@@ -0,0 +1,313 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "set_ops.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#    define SET_OPS_X86 1
+#    include <immintrin.h>
+#    define SET_OPS_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/***************************************************************************
+ * Scalar versions.
+ */
+
+static int
+find_tag_scalar(const addr_t *tags, int num_ways, addr_t tag)
+{
+    for (int way = 0; way < num_ways; ++way) {
+        if (tags[way] == tag)
+            return way;
+    }
+    return -1;
+}
+
+static void
+inc_counters_upto_scalar(int *counters, int num_ways, int limit)
+{
+    // Branch-free so that the compiler can auto-vectorize it.
+    for (int way = 0; way < num_ways; ++way)
+        counters[way] += (counters[way] <= limit);
+}
+
+static int
+find_max_counter_scalar(const int *counters, int num_ways)
+{
+    int max_way = 0;
+    for (int way = 1; way < num_ways; ++way) {
+        if (counters[way] > counters[max_way])
+            max_way = way;
+    }
+    return max_way;
+}
+
+#ifdef SET_OPS_X86
+
+/***************************************************************************
+ * SSE2 versions.
+ */
+
+SET_OPS_TARGET("sse2")
+static int
+find_tag_sse2(const addr_t *tags, int num_ways, addr_t tag)
+{
+    int way = 0;
+#    ifdef __x86_64__
+    // SSE2 has no 64-bit compare, so we require both 32-bit halves to match.
+    const __m128i key = _mm_set1_epi64x(tag);
+    for (; way + 2 <= num_ways; way += 2) {
+        __m128i eq = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + way)), key);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+#    else
+    const __m128i key = _mm_set1_epi32(tag);
+    for (; way + 4 <= num_ways; way += 4) {
+        __m128i eq = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + way)), key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+#    endif
+    int found = find_tag_scalar(tags + way, num_ways - way, tag);
+    return found < 0 ? -1 : way + found;
+}
+
+SET_OPS_TARGET("sse2")
+static void
+inc_counters_upto_sse2(int *counters, int num_ways, int limit)
+{
+    const __m128i lim = _mm_set1_epi32(limit);
+    const __m128i one = _mm_set1_epi32(1);
+    int way = 0;
+    for (; way + 4 <= num_ways; way += 4) {
+        __m128i *ptr = reinterpret_cast<__m128i *>(counters + way);
+        __m128i val = _mm_loadu_si128(ptr);
+        // Adding the all-ones greater-than mask undoes the increment for counters
+        // above the limit.
+        val = _mm_add_epi32(_mm_add_epi32(val, one), _mm_cmpgt_epi32(val, lim));
+        _mm_storeu_si128(ptr, val);
+    }
+    inc_counters_upto_scalar(counters + way, num_ways - way, limit);
+}
+
+SET_OPS_TARGET("sse2")
+static int
+find_max_counter_sse2(const int *counters, int num_ways)
+{
+    if (num_ways < 8)
+        return find_max_counter_scalar(counters, num_ways);
+    int way = 0;
+    __m128i max = _mm_loadu_si128(reinterpret_cast<const __m128i *>(counters));
+    for (way = 4; way + 4 <= num_ways; way += 4) {
+        __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i *>(counters + way));
+        // SSE2 has no 32-bit max, so we select via the compare mask.
+        __m128i gt = _mm_cmpgt_epi32(val, max);
+        max = _mm_or_si128(_mm_and_si128(gt, val), _mm_andnot_si128(gt, max));
+    }
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), max);
+    int max_val = lanes[0];
+    for (int i = 1; i < 4; ++i) {
+        if (lanes[i] > max_val)
+            max_val = lanes[i];
+    }
+    for (; way < num_ways; ++way) {
+        if (counters[way] > max_val)
+            max_val = counters[way];
+    }
+    const __m128i key = _mm_set1_epi32(max_val);
+    for (way = 0; way + 4 <= num_ways; way += 4) {
+        __m128i eq = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(counters + way)), key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+    for (; way < num_ways; ++way) {
+        if (counters[way] == max_val)
+            break;
+    }
+    return way;
+}
+
+/***************************************************************************
+ * AVX2 versions.
+ */
+
+SET_OPS_TARGET("avx2")
+static int
+find_tag_avx2(const addr_t *tags, int num_ways, addr_t tag)
+{
+    int way = 0;
+#    ifdef __x86_64__
+    const __m256i key = _mm256_set1_epi64x(tag);
+    for (; way + 4 <= num_ways; way += 4) {
+        __m256i eq = _mm256_cmpeq_epi64(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + way)), key);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+#    else
+    const __m256i key = _mm256_set1_epi32(tag);
+    for (; way + 8 <= num_ways; way += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + way)), key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+#    endif
+    int found = find_tag_scalar(tags + way, num_ways - way, tag);
+    return found < 0 ? -1 : way + found;
+}
+
+SET_OPS_TARGET("avx2")
+static void
+inc_counters_upto_avx2(int *counters, int num_ways, int limit)
+{
+    const __m256i lim = _mm256_set1_epi32(limit);
+    const __m256i one = _mm256_set1_epi32(1);
+    int way = 0;
+    for (; way + 8 <= num_ways; way += 8) {
+        __m256i *ptr = reinterpret_cast<__m256i *>(counters + way);
+        __m256i val = _mm256_loadu_si256(ptr);
+        val = _mm256_add_epi32(_mm256_add_epi32(val, one), _mm256_cmpgt_epi32(val, lim));
+        _mm256_storeu_si256(ptr, val);
+    }
+    inc_counters_upto_scalar(counters + way, num_ways - way, limit);
+}
+
+SET_OPS_TARGET("avx2")
+static int
+find_max_counter_avx2(const int *counters, int num_ways)
+{
+    if (num_ways < 16)
+        return find_max_counter_sse2(counters, num_ways);
+    int way = 0;
+    __m256i max = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counters));
+    for (way = 8; way + 8 <= num_ways; way += 8) {
+        max = _mm256_max_epi32(
+            max, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counters + way)));
+    }
+    __m128i half =
+        _mm_max_epi32(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int max_val = _mm_cvtsi128_si32(half);
+    for (; way < num_ways; ++way) {
+        if (counters[way] > max_val)
+            max_val = counters[way];
+    }
+    const __m256i key = _mm256_set1_epi32(max_val);
+    for (way = 0; way + 8 <= num_ways; way += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counters + way)), key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask != 0)
+            return way + __builtin_ctz(mask);
+    }
+    for (; way < num_ways; ++way) {
+        if (counters[way] == max_val)
+            break;
+    }
+    return way;
+}
+
+#endif /* SET_OPS_X86 */
+
+/***************************************************************************
+ * Runtime selection.
+ */
+
+static const set_ops_t scalar_ops = { find_tag_scalar, inc_counters_upto_scalar,
+                                      find_max_counter_scalar };
+#ifdef SET_OPS_X86
+static const set_ops_t sse2_ops = { find_tag_sse2, inc_counters_upto_sse2,
+                                    find_max_counter_sse2 };
+static const set_ops_t avx2_ops = { find_tag_avx2, inc_counters_upto_avx2,
+                                    find_max_counter_avx2 };
+#endif
+
+static set_ops_kind_t
+detect_best_kind()
+{
+#ifdef SET_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SET_OPS_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SET_OPS_SSE2;
+#endif
+    return SET_OPS_SCALAR;
+}
+
+set_ops_kind_t
+set_ops_best_kind()
+{
+    // Function-local static initialization is thread-safe, so devices being set
+    // up on different threads do not race here.
+    static const set_ops_kind_t best_kind = detect_best_kind();
+    return best_kind;
+}
+
+const set_ops_t *
+set_ops_get(set_ops_kind_t kind)
+{
+    if (kind > set_ops_best_kind())
+        return nullptr;
+    switch (kind) {
+    case SET_OPS_SCALAR: return &scalar_ops;
+#ifdef SET_OPS_X86
+    case SET_OPS_SSE2: return &sse2_ops;
+    case SET_OPS_AVX2: return &avx2_ops;
+#endif
+    default: return nullptr;
+    }
+}
+
+const char *
+set_ops_kind_name(set_ops_kind_t kind)
+{
+    switch (kind) {
+    case SET_OPS_SCALAR: return "scalar";
+    case SET_OPS_SSE2: return "sse2";
+    case SET_OPS_AVX2: return "avx2";
+    }
+    return "unknown";
+}
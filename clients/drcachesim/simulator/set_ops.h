@@ -0,0 +1,75 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* set_ops: vectorized operations over the ways of one cache set.
+ */
+
+#ifndef _SET_OPS_H_
+#define _SET_OPS_H_ 1
+
+#include "memref.h"
+
+// These routines operate on the contiguous per-set tag and counter arrays kept by
+// caching_device_t.  Each has a scalar version plus SSE2 and AVX2 versions on x86
+// hosts.  Each caching device uses the best version supported by the host
+// processor unless told otherwise (see caching_device_t::use_set_ops()).
+
+enum set_ops_kind_t {
+    SET_OPS_SCALAR,
+    SET_OPS_SSE2,
+    SET_OPS_AVX2,
+};
+
+struct set_ops_t {
+    // Returns the first way in [0,num_ways) whose tag equals "tag", or -1.
+    int (*find_tag)(const addr_t *tags, int num_ways, addr_t tag);
+    // Increments every counter in [0,num_ways) that is not larger than "limit".
+    void (*inc_counters_upto)(int *counters, int num_ways, int limit);
+    // Returns the first way in [0,num_ways) holding the largest counter.
+    int (*find_max_counter)(const int *counters, int num_ways);
+};
+
+// Returns the implementation of the given kind, or nullptr if the host processor or
+// the build does not support it.  The returned tables are never modified, so they
+// can be shared by caching devices on different threads.
+const set_ops_t *
+set_ops_get(set_ops_kind_t kind);
+
+// Returns the best kind the host processor supports.  This is computed once, on
+// the first call, in a thread-safe manner.
+set_ops_kind_t
+set_ops_best_kind();
+
+const char *
+set_ops_kind_name(set_ops_kind_t kind);
+
+#endif /* _SET_OPS_H_ */
@@ -30,6 +30,7 @@
  * DAMAGE.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <assert.h>
@@ -163,6 +164,64 @@ simulator_t::handle_thread_exit(memref_tid_t tid)
     thread2core_.erase(tid);
 }
 
+template <typename Key>
+static void
+save_core_map(checkpoint_writer_t &out, const std::unordered_map<Key, int> &map)
+{
+    out.write<uint64_t>(map.size());
+    for (const auto &entry : map) {
+        out.write(entry.first);
+        out.write(entry.second);
+    }
+}
+
+template <typename Key>
+static void
+restore_core_map(checkpoint_reader_t &in, std::unordered_map<Key, int> &map,
+                 unsigned int num_cores)
+{
+    uint64_t count;
+    in.read(count);
+    map.clear();
+    for (uint64_t i = 0; i < count && !!in; ++i) {
+        Key key;
+        int core;
+        in.read(key);
+        in.read(core);
+        if (core < 0 || static_cast<unsigned int>(core) >= num_cores) {
+            in.fail();
+            return;
+        }
+        map[key] = core;
+    }
+}
+
+void
+simulator_t::save_schedule(checkpoint_writer_t &out) const
+{
+    out.write(knob_num_cores_);
+    save_core_map(out, cpu2core_);
+    save_core_map(out, thread2core_);
+    out.write_vector(cpu_counts_);
+    out.write_vector(thread_counts_);
+    out.write_vector(thread_ever_counts_);
+}
+
+bool
+simulator_t::restore_schedule(checkpoint_reader_t &in)
+{
+    in.expect(knob_num_cores_);
+    if (!in)
+        return false;
+    restore_core_map(in, cpu2core_, knob_num_cores_);
+    restore_core_map(in, thread2core_, knob_num_cores_);
+    in.read_array(cpu_counts_.data(), cpu_counts_.size());
+    in.read_array(thread_counts_.data(), thread_counts_.size());
+    in.read_array(thread_ever_counts_.data(), thread_ever_counts_.size());
+    last_thread_ = 0;
+    return !!in;
+}
+
 void
 simulator_t::print_core(int core) const
 {
@@ -177,14 +236,20 @@ simulator_t::print_core(int core) const
             return;
         }
         std::cerr << " (" << cpu_counts_[core] << " traced CPU(s): ";
-        bool need_comma = false;
+        // We sort the cpus so the output does not depend on the order in which
+        // they were added, which differs when restored from a checkpoint.
+        std::vector<int> cpus;
         for (auto iter = cpu2core_.begin(); iter != cpu2core_.end(); ++iter) {
-            if (iter->second == core) {
-                if (need_comma)
-                    std::cerr << ", ";
-                std::cerr << "#" << iter->first;
-                need_comma = true;
-            }
+            if (iter->second == core)
+                cpus.push_back(iter->first);
+        }
+        std::sort(cpus.begin(), cpus.end());
+        bool need_comma = false;
+        for (int cpu : cpus) {
+            if (need_comma)
+                std::cerr << ", ";
+            std::cerr << "#" << cpu;
+            need_comma = true;
         }
         std::cerr << ")" << std::endl;
     }
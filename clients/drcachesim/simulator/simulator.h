@@ -41,6 +41,7 @@
 #include "caching_device_stats.h"
 #include "caching_device.h"
 #include "analysis_tool.h"
+#include "checkpoint.h"
 #include "memref.h"
 
 class simulator_t : public analysis_tool_t {
@@ -70,6 +71,12 @@ protected:
     core_for_thread(memref_tid_t tid);
     virtual void
     handle_thread_exit(memref_tid_t tid);
+    // Writes and restores the mapping of threads and cpus to cores for a
+    // checkpoint.
+    void
+    save_schedule(checkpoint_writer_t &out) const;
+    bool
+    restore_schedule(checkpoint_reader_t &in);
 
     unsigned int knob_num_cores_;
     uint64_t knob_skip_refs_;
@@ -82,6 +89,10 @@ protected:
     memref_tid_t last_thread_;
     int last_core_;
 
+    // The number of trace records handed to process_memref(), including skipped
+    // ones, which is where a checkpoint taken now resumes reading the trace.
+    uint64_t trace_position_ = 0;
+
     // For thread mapping to cores:
     std::unordered_map<int, int> cpu2core_;
     std::unordered_map<memref_tid_t, int> thread2core_;
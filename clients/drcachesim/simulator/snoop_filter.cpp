@@ -48,6 +48,9 @@ snoop_filter_t::init(cache_t **caches, int num_snooped_caches)
     num_writes_ = 0;
     num_writebacks_ = 0;
     num_invalidates_ = 0;
+    // The table grows with the footprint, so start it large enough to avoid a
+    // series of early rehashes.
+    coherence_table_.reserve(1 << 15);
 
     return true;
 }
@@ -135,3 +138,48 @@ snoop_filter_t::print_stats(void)
               << std::right << num_writebacks_ << std::endl;
     std::cerr.imbue(std::locale("C")); // Reset to avoid affecting later prints.
 }
+
+void
+snoop_filter_t::save_state(checkpoint_writer_t &out) const
+{
+    out.write(num_snooped_caches_);
+    out.write(num_writes_);
+    out.write(num_writebacks_);
+    out.write(num_invalidates_);
+    out.write<uint64_t>(coherence_table_.size());
+    std::vector<char> sharers(num_snooped_caches_);
+    coherence_table_.for_each(
+        [&](addr_t tag, const coherence_table_entry_t &entry) {
+            std::fill(sharers.begin(), sharers.end(), 0);
+            std::copy(entry.sharers.begin(), entry.sharers.end(), sharers.begin());
+            out.write(tag);
+            out.write(entry.dirty);
+            out.write_vector(sharers);
+        });
+}
+
+bool
+snoop_filter_t::restore_state(checkpoint_reader_t &in)
+{
+    in.expect(num_snooped_caches_);
+    in.read(num_writes_);
+    in.read(num_writebacks_);
+    in.read(num_invalidates_);
+    uint64_t count;
+    in.read(count);
+    coherence_table_.clear();
+    std::vector<char> sharers(num_snooped_caches_);
+    for (uint64_t i = 0; i < count && !!in; ++i) {
+        addr_t tag;
+        bool dirty;
+        in.read(tag);
+        in.read(dirty);
+        in.read_array(sharers.data(), sharers.size());
+        if (!in || tag == TAG_INVALID)
+            return false;
+        coherence_table_entry_t &entry = coherence_table_[tag];
+        entry.sharers.assign(sharers.begin(), sharers.end());
+        entry.dirty = dirty;
+    }
+    return !!in;
+}
@@ -34,7 +34,8 @@
 #define _SNOOP_FILTER_H_ 1
 
 #include "cache.h"
-#include <unordered_map>
+#include "checkpoint.h"
+#include "tag_table.h"
 #include <vector>
 
 struct coherence_table_entry_t {
@@ -56,10 +57,15 @@ public:
     snoop_eviction(addr_t tag, int id);
     void
     print_stats(void);
+    // Writes and restores the sharers of each line and the statistics.
+    void
+    save_state(checkpoint_writer_t &out) const;
+    bool
+    restore_state(checkpoint_reader_t &in);
 
 protected:
     // XXX: This initial coherence implementation uses a perfect snoop filter.
-    std::unordered_map<addr_t, coherence_table_entry_t> coherence_table_;
+    tag_table_t<coherence_table_entry_t> coherence_table_;
     cache_t **caches_;
     int num_snooped_caches_;
     int_least64_t num_writes_;
@@ -0,0 +1,197 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* tag_table: an open-addressing hashtable keyed by cache tags.
+ */
+
+#ifndef _TAG_TABLE_H_
+#define _TAG_TABLE_H_ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+#include "memref.h"
+
+// A hashtable from tags to values with linear probing over power-of-two arrays
+// of keys and values.  Unlike std::unordered_map, lookups hash inline and
+// touch no per-node allocations, and once the table is large enough inserts and
+// erases allocate nothing: erase shifts later entries of the probe sequence back
+// rather than leaving tombstones.  The all-ones tag marks an empty slot and so
+// cannot be a key, which TAG_INVALID already guarantees for our callers.
+template <typename Value> class tag_table_t {
+public:
+    tag_table_t()
+    {
+        resize(MIN_CAPACITY);
+    }
+
+    // Sizes the table to hold num_entries without growing.
+    void
+    reserve(size_t num_entries)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < num_entries * 2)
+            capacity *= 2;
+        if (capacity > keys_.size())
+            resize(capacity);
+    }
+
+    size_t
+    size() const
+    {
+        return size_;
+    }
+
+    // Returns nullptr if "key" is absent.
+    Value *
+    find(addr_t key)
+    {
+        for (size_t slot = home_slot(key);; slot = (slot + 1) & mask_) {
+            if (keys_[slot] == key)
+                return &values_[slot];
+            if (keys_[slot] == EMPTY_KEY)
+                return nullptr;
+        }
+    }
+
+    // Inserts a value-initialized entry if "key" is absent.  Like for
+    // std::unordered_map, the reference is invalidated by a later insert.
+    Value &
+    operator[](addr_t key)
+    {
+        assert(key != EMPTY_KEY);
+        size_t slot = home_slot(key);
+        for (; keys_[slot] != EMPTY_KEY; slot = (slot + 1) & mask_) {
+            if (keys_[slot] == key)
+                return values_[slot];
+        }
+        // Keep the load factor at or below 1/2 so probe sequences stay short.
+        if ((size_ + 1) * 2 > keys_.size()) {
+            resize(keys_.size() * 2);
+            return (*this)[key];
+        }
+        keys_[slot] = key;
+        ++size_;
+        return values_[slot];
+    }
+
+    bool
+    erase(addr_t key)
+    {
+        size_t hole = home_slot(key);
+        for (; keys_[hole] != key; hole = (hole + 1) & mask_) {
+            if (keys_[hole] == EMPTY_KEY)
+                return false;
+        }
+        // Move back each later entry of the run whose home slot does not lie
+        // cyclically within (hole, slot], so every entry stays reachable from
+        // its home slot.
+        for (size_t slot = (hole + 1) & mask_; keys_[slot] != EMPTY_KEY;
+             slot = (slot + 1) & mask_) {
+            size_t home = home_slot(keys_[slot]);
+            if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+                keys_[hole] = keys_[slot];
+                values_[hole] = std::move(values_[slot]);
+                hole = slot;
+            }
+        }
+        keys_[hole] = EMPTY_KEY;
+        values_[hole] = Value();
+        --size_;
+        return true;
+    }
+
+    // Calls func(key, value) for each entry, in no particular order.
+    template <typename Func>
+    void
+    for_each(Func func) const
+    {
+        for (size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (keys_[slot] != EMPTY_KEY)
+                func(keys_[slot], values_[slot]);
+        }
+    }
+
+    void
+    clear()
+    {
+        keys_.assign(keys_.size(), EMPTY_KEY);
+        values_.assign(values_.size(), Value());
+        size_ = 0;
+    }
+
+private:
+    static const addr_t EMPTY_KEY = static_cast<addr_t>(-1);
+    static const size_t MIN_CAPACITY = 16;
+
+    // Tags of neighboring lines are consecutive, and tags of lines that conflict
+    // in a cache share their low bits, so we take the high bits of a Fibonacci
+    // hash to spread both.
+    size_t
+    home_slot(addr_t key) const
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ULL) >>
+                                   shift_);
+    }
+
+    void
+    resize(size_t capacity)
+    {
+        std::vector<addr_t> old_keys(capacity, EMPTY_KEY);
+        std::vector<Value> old_values(capacity);
+        old_keys.swap(keys_);
+        old_values.swap(values_);
+        mask_ = capacity - 1;
+        shift_ = 64;
+        for (size_t bits = capacity; bits > 1; bits >>= 1)
+            --shift_;
+        size_ = 0;
+        for (size_t i = 0; i < old_keys.size(); ++i) {
+            if (old_keys[i] != EMPTY_KEY)
+                (*this)[old_keys[i]] = std::move(old_values[i]);
+        }
+    }
+
+    std::vector<addr_t> keys_;
+    std::vector<Value> values_;
+    size_t mask_ = 0;
+    int shift_ = 64;
+    size_t size_ = 0;
+};
+
+template <typename Value> const addr_t tag_table_t<Value>::EMPTY_KEY;
+template <typename Value> const size_t tag_table_t<Value>::MIN_CAPACITY;
+
+#endif /* _TAG_TABLE_H_ */
@@ -0,0 +1,129 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "timing_model.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+timing_model_t::timing_model_t(unsigned int num_cores, unsigned int mshrs,
+                               unsigned int memory_latency, double memory_bandwidth,
+                               unsigned int line_size)
+    : cores_(num_cores)
+    , num_mshrs_(mshrs == 0 ? 1 : mshrs)
+    , memory_latency_(memory_latency)
+{
+    transfer_cycles_ = memory_bandwidth > 0
+        ? static_cast<uint64_t>(std::ceil(line_size / memory_bandwidth))
+        : 0;
+    max_queue_cycles_ = transfer_cycles_ * num_mshrs_ * num_cores;
+    for (core_t &core : cores_)
+        core.mshrs.reserve(num_mshrs_);
+}
+
+uint64_t
+timing_model_t::access_memory(uint64_t cycle)
+{
+    uint64_t wait = 0;
+    if (memory_free_ > cycle)
+        wait = std::min(memory_free_ - cycle, max_queue_cycles_);
+    memory_free_ = std::max(memory_free_, cycle) + transfer_cycles_;
+    return wait + memory_latency_ + transfer_cycles_;
+}
+
+void
+timing_model_t::finish_access(const memref_t &memref)
+{
+    core_t &core = *core_;
+    if (type_is_instr(memref.instr.type))
+        ++core.cycles;
+    ++core.accesses;
+    core.access_cycles += latency_;
+    if (latency_ <= static_cast<uint64_t>(hit_latency_))
+        return;
+    uint64_t penalty = latency_ - hit_latency_;
+    std::vector<uint64_t> &mshrs = core.mshrs;
+    while (!mshrs.empty() && mshrs.front() <= core.cycles) {
+        std::pop_heap(mshrs.begin(), mshrs.end(), std::greater<uint64_t>());
+        mshrs.pop_back();
+    }
+    if (mshrs.size() >= num_mshrs_) {
+        // Wait for the oldest miss to free its MSHR.
+        core.stall_cycles += mshrs.front() - core.cycles;
+        core.cycles = mshrs.front();
+        std::pop_heap(mshrs.begin(), mshrs.end(), std::greater<uint64_t>());
+        mshrs.pop_back();
+    }
+    if (type_is_instr(memref.instr.type) || memref.data.type == TRACE_TYPE_READ) {
+        core.stall_cycles += penalty;
+        core.cycles += penalty;
+    } else {
+        mshrs.push_back(core.cycles + penalty);
+        std::push_heap(mshrs.begin(), mshrs.end(), std::greater<uint64_t>());
+    }
+}
+
+void
+timing_model_t::reset()
+{
+    for (core_t &core : cores_) {
+        core.cycles = 0;
+        core.stall_cycles = 0;
+        core.accesses = 0;
+        core.access_cycles = 0;
+        core.mshrs.clear();
+    }
+    memory_free_ = 0;
+}
+
+double
+timing_model_t::get_average_access_time(int core) const
+{
+    if (cores_[core].accesses == 0)
+        return 0;
+    return double(cores_[core].access_cycles) / cores_[core].accesses;
+}
+
+void
+timing_model_t::print_results(int core, const std::string &prefix) const
+{
+    std::cerr << prefix << std::setw(18) << std::left << "Cycles:" << std::setw(20)
+              << std::right << cores_[core].cycles << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Stall cycles:"
+              << std::setw(20) << std::right << cores_[core].stall_cycles << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Avg access time:"
+              << std::setw(20) << std::fixed << std::setprecision(2) << std::right
+              << get_average_access_time(core) << std::endl;
+}
@@ -0,0 +1,143 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* timing_model: estimates the cycles that each simulated core spends waiting on
+ * the cache hierarchy.
+ */
+
+#ifndef _TIMING_MODEL_H_
+#define _TIMING_MODEL_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "memref.h"
+#include "trace_entry.h"
+
+// A lightweight timing layer for the cache simulator.  Each access is charged the
+// hit latency of the L1 cache it goes to plus, for each device that misses, the
+// hit latency of that device's parent or the memory latency.  Each core is an
+// in-order core issuing one instruction per cycle whose L1 hit latency is hidden
+// by the pipeline.  Instruction fetch and load misses stall the core until they
+// complete while store and software prefetch misses only occupy one of the
+// core's miss status holding registers (MSHRs), whose completion times are kept
+// in a min-heap: the core stalls when all of them are busy.  Memory is a single
+// channel transferring memory_bandwidth bytes per cycle, where a line waits for
+// the lines ahead of it.  As the cores' clocks are not synchronized, a line never
+// waits for more lines than there are MSHRs across all cores.
+//
+// The caches call add_miss() from within each L1 access bracketed by
+// start_access() and finish_access().
+class timing_model_t {
+public:
+    timing_model_t(unsigned int num_cores, unsigned int mshrs,
+                   unsigned int memory_latency, double memory_bandwidth,
+                   unsigned int line_size);
+
+    inline void
+    start_access(int core, int hit_latency)
+    {
+        core_ = &cores_[core];
+        hit_latency_ = hit_latency;
+        latency_ = hit_latency;
+    }
+
+    // Called by a device that misses on a line, where "next_latency" is the hit
+    // latency of its parent and "from_memory" is whether it has no parent.  A
+    // hardware prefetch only uses memory bandwidth.
+    inline void
+    add_miss(const memref_t &memref, int next_latency, bool from_memory)
+    {
+        if (memref.data.type == TRACE_TYPE_HARDWARE_PREFETCH) {
+            if (from_memory)
+                access_memory(core_->cycles);
+            return;
+        }
+        latency_ += next_latency;
+        if (from_memory)
+            latency_ += access_memory(core_->cycles + latency_);
+    }
+
+    void
+    finish_access(const memref_t &memref);
+
+    // Clears the counts and the state of the cores and memory, for the end of
+    // warmup.
+    void
+    reset();
+
+    void
+    print_results(int core, const std::string &prefix) const;
+
+    uint64_t
+    get_cycles(int core) const
+    {
+        return cores_[core].cycles;
+    }
+    uint64_t
+    get_stall_cycles(int core) const
+    {
+        return cores_[core].stall_cycles;
+    }
+    // Returns the average memory access time in cycles.
+    double
+    get_average_access_time(int core) const;
+
+protected:
+    struct core_t {
+        uint64_t cycles = 0;
+        uint64_t stall_cycles = 0;
+        uint64_t accesses = 0;
+        uint64_t access_cycles = 0;
+        // The completion times of outstanding misses, as a min-heap.
+        std::vector<uint64_t> mshrs;
+    };
+
+    // Returns the latency of a line transfer from memory requested at "cycle".
+    uint64_t
+    access_memory(uint64_t cycle);
+
+    std::vector<core_t> cores_;
+    unsigned int num_mshrs_;
+    unsigned int memory_latency_;
+    uint64_t transfer_cycles_;
+    uint64_t max_queue_cycles_;
+    // The cycle at which the memory channel is next free.
+    uint64_t memory_free_ = 0;
+
+    core_t *core_ = nullptr;
+    int hit_latency_ = 0;
+    uint64_t latency_ = 0;
+};
+
+#endif /* _TIMING_MODEL_H_ */
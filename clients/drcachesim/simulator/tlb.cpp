@@ -31,6 +31,8 @@
  */
 
 #include "tlb.h"
+#include "checkpoint.h"
+#include "page_walker.h"
 #include "../common/utils.h"
 #include <assert.h>
 
@@ -40,6 +42,31 @@ tlb_t::init_blocks()
     for (int i = 0; i < num_blocks_; i++) {
         blocks_[i] = new tlb_entry_t;
     }
+    // Entries for different processes can share a tag.
+    duplicate_tags_ = true;
+}
+
+int
+tlb_t::find_entry_way(int block_idx, addr_t tag, memref_pid_t pid)
+{
+    if (use_tag2block_table_) {
+        // A tag missing from the table is in no entry, and one present is
+        // usually mapped to the entry for this process.
+        int way = find_caching_device_way(tag);
+        if (way < 0)
+            return associativity_;
+        if (((tlb_entry_t *)&get_caching_device_block(block_idx, way))->pid_ == pid)
+            return way;
+    }
+    int way;
+    for (way = 0; way < associativity_; ++way) {
+        // Compare the contiguous tag first so the entry object is only
+        // dereferenced on a tag match.
+        if (get_tag(block_idx, way) == tag &&
+            ((tlb_entry_t *)&get_caching_device_block(block_idx, way))->pid_ == pid)
+            break;
+    }
+    return way;
 }
 
 void
@@ -60,8 +87,9 @@ tlb_t::request(const memref_t &memref_in)
     // This means that one memref could touch multiple blocks.
     // We treat each block separately for statistics purposes.
     addr_t final_addr = memref_in.data.addr + memref_in.data.size - 1 /*avoid overflow*/;
-    addr_t final_tag = compute_tag(final_addr);
-    addr_t tag = compute_tag(memref_in.data.addr);
+    int page_bits, final_page_bits;
+    addr_t final_tag = compute_page_tag(final_addr, final_page_bits);
+    addr_t tag = compute_page_tag(memref_in.data.addr, page_bits);
     memref_pid_t pid = memref_in.data.pid;
 
     // Optimization: check last tag and pid if single-block
@@ -69,55 +97,85 @@ tlb_t::request(const memref_t &memref_in)
         // Make sure last_tag_ and pid are properly in sync.
         caching_device_block_t *tlb_entry =
             &get_caching_device_block(last_block_idx_, last_way_);
-        assert(tag != TAG_INVALID && tag == tlb_entry->tag_ &&
+        assert(tag != TAG_INVALID && tag == get_tag(last_block_idx_, last_way_) &&
                pid == ((tlb_entry_t *)tlb_entry)->pid_);
         record_access_stats(memref_in, true /*hit*/, tlb_entry);
         access_update(last_block_idx_, last_way_);
         return;
     }
 
+    // An empty access touches no page.
+    if (final_addr < memref_in.data.addr)
+        return;
     memref = memref_in;
-    for (; tag <= final_tag; ++tag) {
+    // With mixed page sizes the tags of consecutive pages are not consecutive, so
+    // we walk the pages by address.
+    while (true) {
         int way;
         int block_idx = compute_block_idx(tag);
+        addr_t next_addr = ((memref.data.addr >> page_bits) + 1) << page_bits;
 
-        if (tag + 1 <= final_tag)
-            memref.data.size = ((tag + 1) << block_size_bits_) - memref.data.addr;
-
-        for (way = 0; way < associativity_; ++way) {
-            caching_device_block_t *tlb_entry = &get_caching_device_block(block_idx, way);
-            if (tlb_entry->tag_ == tag && ((tlb_entry_t *)tlb_entry)->pid_ == pid) {
-                record_access_stats(memref, true /*hit*/, tlb_entry);
-                break;
-            }
-        }
+        if (tag != final_tag)
+            memref.data.size = next_addr - memref.data.addr;
 
-        if (way == associativity_) {
+        way = find_entry_way(block_idx, tag, pid);
+        if (way < associativity_) {
+            record_access_stats(memref, true /*hit*/,
+                                &get_caching_device_block(block_idx, way));
+        } else {
             way = replace_which_way(block_idx);
             caching_device_block_t *tlb_entry = &get_caching_device_block(block_idx, way);
 
             record_access_stats(memref, false /*miss*/, tlb_entry);
-            // If no parent we assume we get the data from main memory
+            // If no parent we walk the page tables.
             if (parent_ != NULL)
                 parent_->request(memref);
+            else if (walker_ != nullptr)
+                walker_->walk(memref, page_bits);
 
             // XXX: do we need to handle TLB coherency?
 
-            tlb_entry->tag_ = tag;
+            update_tag(block_idx, way, tag);
             ((tlb_entry_t *)tlb_entry)->pid_ = pid;
         }
 
         access_update(block_idx, way);
 
-        if (tag + 1 <= final_tag) {
-            addr_t next_addr = (tag + 1) << block_size_bits_;
-            memref.data.addr = next_addr;
-            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
-        }
         // Optimization: remember last tag and pid
         last_tag_ = tag;
         last_way_ = way;
         last_block_idx_ = block_idx;
         last_pid_ = pid;
+
+        if (tag == final_tag)
+            break;
+        memref.data.addr = next_addr;
+        memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
+        tag = compute_page_tag(next_addr, page_bits);
     }
 }
+
+void
+tlb_t::save_state(checkpoint_writer_t &out) const
+{
+    caching_device_t::save_state(out);
+    std::vector<memref_pid_t> pids(num_blocks_);
+    for (int i = 0; i < num_blocks_; i++)
+        pids[i] = static_cast<tlb_entry_t *>(blocks_[i])->pid_;
+    out.write_vector(pids);
+}
+
+bool
+tlb_t::restore_state(checkpoint_reader_t &in)
+{
+    if (!caching_device_t::restore_state(in))
+        return false;
+    std::vector<memref_pid_t> pids(num_blocks_);
+    in.read_array(pids.data(), pids.size());
+    if (!in)
+        return false;
+    for (int i = 0; i < num_blocks_; i++)
+        static_cast<tlb_entry_t *>(blocks_[i])->pid_ = pids[i];
+    last_tag_ = TAG_INVALID;
+    return true;
+}
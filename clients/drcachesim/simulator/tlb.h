@@ -37,13 +37,35 @@
 #define _TLB_H_ 1
 
 #include "caching_device.h"
+#include "page_size_map.h"
 #include "tlb_entry.h"
 #include "tlb_stats.h"
 
+class page_walker_t;
+
 class tlb_t : public caching_device_t {
 public:
     void
     request(const memref_t &memref) override;
+    void
+    save_state(checkpoint_writer_t &out) const override;
+    bool
+    restore_state(checkpoint_reader_t &in) override;
+
+    // Looks up the size of each page in "page_sizes" rather than using the base
+    // page size for all pages.  A TLB holds entries for pages of all sizes.
+    void
+    set_page_sizes(page_size_map_t *page_sizes)
+    {
+        page_sizes_ = page_sizes;
+        last_tag_ = TAG_INVALID;
+    }
+    // Has "walker" walk the page tables on each miss, for a TLB with no parent.
+    void
+    set_walker(page_walker_t *walker)
+    {
+        walker_ = walker;
+    }
 
     // TODO i#4816: The addition of the pid as a lookup parameter beyond just the tag
     // needs to be imposed on the parent methods invalidate(), contains_tag(), and
@@ -52,6 +74,30 @@ public:
 protected:
     void
     init_blocks() override;
+    // Returns the way of the entry for "tag" and "pid" within the set at block_idx,
+    // or associativity_ if there is none.
+    int
+    find_entry_way(int block_idx, addr_t tag, memref_pid_t pid);
+
+    // Returns the tag of the page holding "addr" and sets "page_bits" to log2 of
+    // its size.  The tags of pages larger than the base size hold their size in
+    // their top bits so that they never match those of other sizes.
+    inline addr_t
+    compute_page_tag(addr_t addr, int &page_bits)
+    {
+        if (page_sizes_ == nullptr) {
+            page_bits = block_size_bits_;
+            return addr >> block_size_bits_;
+        }
+        page_bits = page_sizes_->lookup(addr);
+        if (page_bits == block_size_bits_)
+            return addr >> page_bits;
+        return (addr >> page_bits) | (addr_t(page_bits) << HUGE_PAGE_TAG_SHIFT);
+    }
+    static const int HUGE_PAGE_TAG_SHIFT = 56;
+
+    page_size_map_t *page_sizes_ = nullptr;
+    page_walker_t *walker_ = nullptr;
 
     // Optimization: remember last pid in addition to last tag
     memref_pid_t last_pid_;
@@ -30,6 +30,7 @@
  * DAMAGE.
  */
 
+#include <fstream>
 #include <iostream>
 #include <iterator>
 #include <string>
@@ -39,6 +40,7 @@
 #include "../common/memref.h"
 #include "../common/options.h"
 #include "../common/utils.h"
+#include "checkpoint.h"
 #include "droption.h"
 #include "tlb_stats.h"
 #include "tlb.h"
@@ -50,11 +52,20 @@ tlb_simulator_create(const tlb_simulator_knobs_t &knobs)
     return new tlb_simulator_t(knobs);
 }
 
+// The associativity from which TLBs look up entries through a hashtable.
+static const int TLB_HASHTABLE_MIN_ASSOC = 64;
+
+static const char *const CHECKPOINT_KIND = "TLB";
+
 tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs)
     : simulator_t(knobs.num_cores, knobs.skip_refs, knobs.warmup_refs,
                   knobs.warmup_fraction, knobs.sim_refs, knobs.cpu_scheduling,
                   knobs.verbose)
     , knobs_(knobs)
+    , page_sizes_(compute_log2((int)knobs.page_size))
+    , walker_(knobs.num_cores, compute_log2((int)knobs.page_size), knobs.TLB_PWC_entries,
+              knobs.cache_knobs.L1D_latency, knobs.cache_knobs.LL_latency,
+              knobs.cache_knobs.memory_latency)
 {
     itlbs_ = new tlb_t *[knobs_.num_cores];
     dtlbs_ = new tlb_t *[knobs_.num_cores];
@@ -64,6 +75,17 @@ tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs)
         dtlbs_[i] = NULL;
         lltlbs_[i] = NULL;
     }
+    if (!knobs_.save_checkpoint.empty() && knobs_.warmup_refs == 0) {
+        error_string_ = "Usage error: -save_checkpoint requires -warmup_refs";
+        success_ = false;
+        return;
+    }
+    if (!knobs_.save_checkpoint.empty() && !knobs_.restore_checkpoint.empty()) {
+        error_string_ =
+            "Usage error: -save_checkpoint and -restore_checkpoint are exclusive";
+        success_ = false;
+        return;
+    }
     for (unsigned int i = 0; i < knobs_.num_cores; i++) {
         itlbs_[i] = create_tlb(knobs_.TLB_replace_policy);
         if (itlbs_[i] == NULL) {
@@ -99,6 +121,68 @@ tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs)
             success_ = false;
             return;
         }
+        // Walking the entries of a highly associative TLB on every lookup is a
+        // bottleneck, while for small sets the walk beats the hashtable.
+        for (tlb_t *tlb : { itlbs_[i], dtlbs_[i], lltlbs_[i] }) {
+            if (tlb->get_associativity() >= TLB_HASHTABLE_MIN_ASSOC)
+                tlb->set_hashtable_use(true);
+        }
+        lltlbs_[i]->set_walker(&walker_);
+    }
+
+    if (!knobs_.page_size_file.empty()) {
+        std::ifstream fin(knobs_.page_size_file);
+        std::string error;
+        if (!fin.is_open()) {
+            error_string_ = "Failed to open page size file " + knobs_.page_size_file;
+            success_ = false;
+            return;
+        }
+        if (!page_sizes_.read(fin, error)) {
+            error_string_ = "Failed to read page size file " + knobs_.page_size_file +
+                ": " + error;
+            success_ = false;
+            return;
+        }
+        if (!page_sizes_.empty()) {
+            for (unsigned int i = 0; i < knobs_.num_cores; i++) {
+                itlbs_[i]->set_page_sizes(&page_sizes_);
+                dtlbs_[i]->set_page_sizes(&page_sizes_);
+                lltlbs_[i]->set_page_sizes(&page_sizes_);
+            }
+        }
+    }
+
+    if (knobs_.TLB_walk_caches) {
+        cache_simulator_knobs_t cache_knobs = knobs_.cache_knobs;
+        // We apply the skip, warmup and simulation limits before passing references
+        // on, and the page walker needs the serial statistics of the default
+        // hierarchy.
+        cache_knobs.num_cores = knobs_.num_cores;
+        cache_knobs.cpu_scheduling = knobs_.cpu_scheduling;
+        cache_knobs.skip_refs = 0;
+        cache_knobs.warmup_refs = 0;
+        cache_knobs.warmup_fraction = 0.0;
+        cache_knobs.sim_refs = 1ULL << 63;
+        cache_knobs.parallel_cores = false;
+        cache_knobs.model_timing = false;
+        // Our own checkpoints hold the state of these caches.
+        cache_knobs.save_checkpoint.clear();
+        cache_knobs.restore_checkpoint.clear();
+        cache_knobs.miss_attribution = 0;
+        walk_caches_.reset(new cache_simulator_t(cache_knobs));
+        if (!*walk_caches_) {
+            error_string_ = "Failed to create the caches for page walks: " +
+                walk_caches_->get_error_string();
+            success_ = false;
+            return;
+        }
+        walker_.set_caches(walk_caches_.get());
+    }
+
+    if (!knobs_.restore_checkpoint.empty() && !read_checkpoint(knobs_.restore_checkpoint)) {
+        success_ = false;
+        return;
     }
 }
 
@@ -127,6 +211,7 @@ tlb_simulator_t::~tlb_simulator_t()
 bool
 tlb_simulator_t::process_memref(const memref_t &memref)
 {
+    ++trace_position_;
     if (knobs_.skip_refs > 0) {
         knobs_.skip_refs--;
         return true;
@@ -144,6 +229,10 @@ tlb_simulator_t::process_memref(const memref_t &memref)
     if (memref.marker.type == TRACE_TYPE_MARKER) {
         // We ignore markers before we ask core_for_thread, to avoid asking
         // too early on a timestamp marker.
+        if (walk_caches_ != nullptr && !walk_caches_->process_memref(memref)) {
+            error_string_ = walk_caches_->get_error_string();
+            return false;
+        }
         return true;
     }
 
@@ -159,6 +248,7 @@ tlb_simulator_t::process_memref(const memref_t &memref)
         last_core_ = core;
     }
 
+    walker_.set_core(core);
     if (type_is_instr(memref.instr.type))
         itlbs_[core]->request(memref);
     else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE)
@@ -176,6 +266,11 @@ tlb_simulator_t::process_memref(const memref_t &memref)
         error_string_ = "Unhandled memref type " + std::to_string(memref.data.type);
         return false;
     }
+    // The caches see the page table references of an access before the access.
+    if (walk_caches_ != nullptr && !walk_caches_->process_memref(memref)) {
+        error_string_ = walk_caches_->get_error_string();
+        return false;
+    }
 
     if (knobs_.verbose >= 3) {
         std::cerr << "::" << memref.data.pid << "." << memref.data.tid << ":: "
@@ -194,6 +289,12 @@ tlb_simulator_t::process_memref(const memref_t &memref)
                 dtlbs_[i]->get_stats()->reset();
                 lltlbs_[i]->get_stats()->reset();
             }
+            walker_.reset();
+            if (walk_caches_ != nullptr)
+                walk_caches_->reset_stats();
+            if (!knobs_.save_checkpoint.empty() &&
+                !write_checkpoint(knobs_.save_checkpoint))
+                return false;
         }
     } else {
         knobs_.sim_refs--;
@@ -214,8 +315,70 @@ tlb_simulator_t::print_results()
             dtlbs_[i]->get_stats()->print_stats("    ");
             std::cerr << "  LL stats:" << std::endl;
             lltlbs_[i]->get_stats()->print_stats("    ");
+            std::cerr << "  Page walks:" << std::endl;
+            walker_.print_results(i, "    ");
         }
     }
+    if (walk_caches_ != nullptr)
+        return walk_caches_->print_results();
+    return true;
+}
+
+bool
+tlb_simulator_t::write_checkpoint(const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    checkpoint_writer_t writer(out);
+    writer.write_header(CHECKPOINT_KIND, trace_position_);
+    save_schedule(writer);
+    for (unsigned int i = 0; i < knobs_.num_cores; i++) {
+        itlbs_[i]->save_state(writer);
+        dtlbs_[i]->save_state(writer);
+        lltlbs_[i]->save_state(writer);
+    }
+    walker_.save_state(writer);
+    writer.write(walk_caches_ != nullptr);
+    if (walk_caches_ != nullptr)
+        walk_caches_->save_state(writer);
+    out.flush();
+    if (!out.is_open() || !writer) {
+        error_string_ = "Failed to write checkpoint " + path;
+        return false;
+    }
+    return true;
+}
+
+bool
+tlb_simulator_t::read_checkpoint(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        error_string_ = "Failed to open checkpoint " + path;
+        return false;
+    }
+    checkpoint_reader_t reader(in);
+    uint64_t position;
+    std::string error;
+    if (!reader.read_header(CHECKPOINT_KIND, position, error)) {
+        error_string_ = "Failed to read checkpoint " + path + ": " + error;
+        return false;
+    }
+    bool ok = restore_schedule(reader);
+    for (unsigned int i = 0; ok && i < knobs_.num_cores; i++) {
+        ok = itlbs_[i]->restore_state(reader) && dtlbs_[i]->restore_state(reader) &&
+            lltlbs_[i]->restore_state(reader);
+    }
+    ok = ok && walker_.restore_state(reader);
+    reader.expect(walk_caches_ != nullptr);
+    if (!ok || !reader || (walk_caches_ != nullptr && !walk_caches_->restore_state(reader))) {
+        error_string_ = "Checkpoint " + path +
+            " does not match the simulated TLBs or is truncated";
+        return false;
+    }
+    // The reader skips the records up to the checkpoint, including the warmup.
+    trace_position_ = position;
+    knobs_.skip_refs = 0;
+    knobs_.warmup_refs = 0;
     return true;
 }
 
@@ -36,8 +36,12 @@
 #ifndef _TLB_SIMULATOR_H_
 #define _TLB_SIMULATOR_H_ 1
 
+#include <memory>
 #include <unordered_map>
 #include "simulator.h"
+#include "cache_simulator.h"
+#include "page_size_map.h"
+#include "page_walker.h"
 #include "tlb_simulator_create.h"
 #include "tlb_stats.h"
 #include "tlb.h"
@@ -51,10 +55,23 @@ public:
     bool
     print_results() override;
 
+    const page_walker_t &
+    get_page_walker() const
+    {
+        return walker_;
+    }
+
 protected:
     // Create a tlb_t object with a specific replacement policy.
     virtual tlb_t *
     create_tlb(std::string policy);
+    // Writes a checkpoint of the TLBs, page walk caches and any walk caches at
+    // the current trace position.
+    bool
+    write_checkpoint(const std::string &path);
+    // Restores a checkpoint, after which simulation resumes without warmup.
+    bool
+    read_checkpoint(const std::string &path);
 
     tlb_simulator_knobs_t knobs_;
 
@@ -63,6 +80,11 @@ protected:
     tlb_t **itlbs_;
     tlb_t **dtlbs_;
     tlb_t **lltlbs_;
+
+    page_size_map_t page_sizes_;
+    page_walker_t walker_;
+    // Simulates the page table references and the trace with TLB_walk_caches.
+    std::unique_ptr<cache_simulator_t> walk_caches_;
 };
 
 #endif /* _TLB_SIMULATOR_H_ */
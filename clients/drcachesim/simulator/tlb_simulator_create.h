@@ -37,6 +37,7 @@
 
 #include <string>
 #include "analysis_tool.h"
+#include "cache_simulator_create.h"
 
 /**
  * @file drmemtrace/tlb_simulator_create.h
@@ -59,12 +60,17 @@ struct tlb_simulator_knobs_t {
         , TLB_L2_entries(1024)
         , TLB_L2_assoc(4)
         , TLB_replace_policy("LFU")
+        , page_size_file("")
+        , TLB_PWC_entries(32)
+        , TLB_walk_caches(false)
         , skip_refs(0)
         , warmup_refs(0)
         , warmup_fraction(0.0)
         , sim_refs(1ULL << 63)
         , cpu_scheduling(false)
         , verbose(0)
+        , save_checkpoint("")
+        , restore_checkpoint("")
     {
     }
     unsigned int num_cores;
@@ -76,12 +82,20 @@ struct tlb_simulator_knobs_t {
     unsigned int TLB_L2_entries;
     unsigned int TLB_L2_assoc;
     std::string TLB_replace_policy;
+    std::string page_size_file;
+    unsigned int TLB_PWC_entries;
+    bool TLB_walk_caches;
+    // The caches simulated with TLB_walk_caches, whose latencies are also used
+    // for the cost of page table references without TLB_walk_caches.
+    cache_simulator_knobs_t cache_knobs;
     uint64_t skip_refs;
     uint64_t warmup_refs;
     double warmup_fraction;
     uint64_t sim_refs;
     bool cpu_scheduling;
     unsigned int verbose;
+    std::string save_checkpoint;
+    std::string restore_checkpoint;
 };
 
 /** Creates an instance of a TLB simulator. */
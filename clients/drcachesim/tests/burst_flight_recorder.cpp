@@ -0,0 +1,203 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL GOOGLE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* This application links in drmemtrace_static and runs under -flight_recorder,
+ * which keeps the trace only in memory, and then triggers a dump of the recorded
+ * history partway through its execution.  It then post-processes the dump and
+ * checks that it holds the references leading up to the trigger, but none from
+ * before the history window nor from after the dump.
+ */
+
+/* Like burst_static we deliberately do not include configure.h here */
+
+#include "dr_api.h"
+#include "drmemtrace/drmemtrace.h"
+#include "analyzer.h"
+#include "tracer/raw2trace.h"
+#include "tracer/raw2trace_directory.h"
+#include <assert.h>
+#include <iostream>
+#include <math.h>
+#include <set>
+#include <stdlib.h>
+
+/* Each is written only at one point of the run, so we can tell whether that
+ * point made it into the dump.
+ */
+static volatile char early_buf[4096];
+static volatile char trigger_buf[4096];
+static volatile char late_buf[4096];
+
+bool
+my_setenv(const char *var, const char *value)
+{
+#ifdef UNIX
+    return setenv(var, value, 1 /*override*/) == 0;
+#else
+    return SetEnvironmentVariable(var, value) == TRUE;
+#endif
+}
+
+static int
+do_some_work(int arg)
+{
+    static int iters = 512;
+    double val = (double)arg;
+    for (int i = 0; i < iters; ++i) {
+        val += sin(val);
+    }
+    return (val > 0);
+}
+
+static void
+touch(volatile char *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i += 64)
+        buf[i] = 1;
+}
+
+static bool
+in_buf(addr_t addr, volatile char *buf, size_t size)
+{
+    return addr >= reinterpret_cast<addr_t>(buf) &&
+        addr < reinterpret_cast<addr_t>(buf) + size;
+}
+
+static std::string
+post_process()
+{
+    const char *raw_dir;
+    drmemtrace_status_t mem_res = drmemtrace_get_output_path(&raw_dir);
+    assert(mem_res == DRMEMTRACE_SUCCESS);
+    std::string outdir = std::string(raw_dir) + DIRSEP + "post_processed";
+    void *dr_context = dr_standalone_init();
+    /* Use a new scope to free raw2trace_directory_t before dr_standalone_exit(). */
+    {
+        raw2trace_directory_t dir;
+        if (!dr_create_dir(outdir.c_str())) {
+            std::cerr << "Failed to create output dir";
+            assert(false);
+        }
+        std::string dir_err = dir.initialize(raw_dir, outdir);
+        assert(dir_err.empty());
+        raw2trace_t raw2trace(dir.modfile_bytes_, dir.in_files_, dir.out_files_,
+                              dr_context,
+                              0
+#ifdef WINDOWS
+                              /* FIXME i#3983: Creating threads in standalone mode
+                               * causes problems.  We disable the pool for now.
+                               */
+                              ,
+                              0
+#endif
+        );
+        std::string error = raw2trace.do_conversion();
+        if (!error.empty()) {
+            std::cerr << "raw2trace failed: " << error << "\n";
+            assert(false);
+        }
+    }
+    dr_standalone_exit();
+    return outdir;
+}
+
+static void
+check_dump(const std::string &dir)
+{
+    analyzer_t analyzer(dir);
+    if (!analyzer) {
+        std::cerr << "Failed to initialize iterator " << analyzer.get_error_string()
+                  << "\n";
+        return;
+    }
+    std::set<memref_tid_t> tids;
+    bool saw_early = false, saw_trigger = false, saw_late = false;
+    for (reader_t &iter = analyzer.begin(); iter != analyzer.end(); ++iter) {
+        const memref_t &memref = *iter;
+        tids.insert(memref.data.tid);
+        if (memref.data.type != TRACE_TYPE_WRITE)
+            continue;
+        if (in_buf(memref.data.addr, early_buf, sizeof(early_buf)))
+            saw_early = true;
+        else if (in_buf(memref.data.addr, trigger_buf, sizeof(trigger_buf)))
+            saw_trigger = true;
+        else if (in_buf(memref.data.addr, late_buf, sizeof(late_buf)))
+            saw_late = true;
+    }
+    std::cerr << tids.size() << " thread(s) dumped\n";
+    if (!saw_trigger)
+        std::cerr << "error: the dump is missing the trigger point\n";
+    if (saw_early)
+        std::cerr << "error: the dump has references from before its window\n";
+    if (saw_late)
+        std::cerr << "error: the dump has references from after the trigger\n";
+}
+
+int
+main(int argc, const char *argv[])
+{
+    static int outer_iters = 2048;
+    static int iter_dump = outer_iters / 2;
+
+    if (!my_setenv("DYNAMORIO_OPTIONS",
+                   "-stderr_mask 0xc -client_lib ';;-offline -flight_recorder 256K'"))
+        std::cerr << "failed to set env var!\n";
+
+    std::cerr << "pre-DR init\n";
+    /* Nothing is recorded before we start. */
+    assert(drmemtrace_flight_recorder_dump() == DRMEMTRACE_ERROR_NOT_IMPLEMENTED);
+    dr_app_setup();
+    std::cerr << "pre-DR start\n";
+    dr_app_start();
+    assert(dr_app_running_under_dynamorio());
+    /* Far more history than the 256K ring holds separates this from the trigger. */
+    touch(early_buf, sizeof(early_buf));
+    for (int i = 0; i < outer_iters; ++i) {
+        if (i == iter_dump) {
+            std::cerr << "triggering dump\n";
+            touch(trigger_buf, sizeof(trigger_buf));
+            if (drmemtrace_flight_recorder_dump() != DRMEMTRACE_SUCCESS)
+                std::cerr << "failed to trigger dump\n";
+        }
+        if (do_some_work(i) < 0)
+            std::cerr << "error in computation\n";
+    }
+    /* The dump was written at the first buffer flush after the trigger, long
+     * before this.
+     */
+    touch(late_buf, sizeof(late_buf));
+    std::cerr << "pre-DR detach\n";
+    dr_app_stop_and_cleanup();
+    check_dump(post_process());
+    std::cerr << "all done\n";
+    return 0;
+}
@@ -37,6 +37,8 @@
 #include "cache_replacement_policy_unit_test.h"
 #include "simulator/cache_fifo.h"
 #include "simulator/cache_lru.h"
+#include "simulator/cache_rrip.h"
+#include "simulator/cache_ship.h"
 
 // Indices for test address vector.
 enum {
@@ -66,7 +68,10 @@ template <class T> class cache_policy_test_t : public T {
     int total_size_;
 
 public:
-    cache_policy_test_t(int associativity, int line_size, int total_size)
+    template <typename... Args>
+    cache_policy_test_t(int associativity, int line_size, int total_size,
+                        Args... policy_args)
+        : T(policy_args...)
     {
         associativity_ = associativity;
         line_size_ = line_size;
@@ -96,6 +101,30 @@ public:
                expected_replacement_way_after_access);
     }
 
+    void
+    access_and_check_cache(const addr_t addr, const addr_t pc,
+                           const int expected_replacement_way_after_access)
+    {
+        memref_t ref;
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 1;
+        ref.data.addr = addr;
+        ref.data.pc = pc;
+        this->request(ref);
+        assert(this->get_next_way_to_replace(this->get_block_index(addr)) ==
+               expected_replacement_way_after_access);
+    }
+
+    // Returns the replacement counter of the block holding addr.
+    int
+    get_block_counter(const addr_t addr)
+    {
+        addr_t tag = this->compute_tag(addr);
+        int way = this->find_caching_device_way(tag);
+        assert(way >= 0);
+        return this->get_counter(this->compute_block_idx(tag), way);
+    }
+
     bool
     tags_are_different(const std::vector<addr_t> &addresses)
     {
@@ -240,6 +269,126 @@ unit_test_cache_fifo_eight_way()
     cache_fifo_test.access_and_check_cache(addr_vec[ADDR_L], 4); // I  J  K  L  e  F  G  H
 }
 
+void
+unit_test_cache_srrip_four_way()
+{
+    cache_policy_test_t<cache_rrip_t> cache_srrip_test(/*associativity=*/4,
+                                                       /*line_size=*/32,
+                                                       /*total_size=*/256, RRIP_STATIC);
+    cache_srrip_test.initialize_cache();
+
+    assert(cache_srrip_test.block_indices_are_identical(addr_vec));
+    assert(cache_srrip_test.tags_are_different(addr_vec));
+
+    // Lower-case letter shows the way that is to be replaced after the access.
+    // The digits are the re-reference prediction values of the ways.
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_A], 1); // A x X X  2 - - -
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_B], 2); // A B x X  2 2 - -
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_C], 3); // A B C x  2 2 2 -
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_D], 0); // a B C D  2 2 2 2
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_A], 1); // A b C D  0 2 2 2
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_E], 2); // A E c D  1 2 3 3
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_F], 3); // A E F d  1 2 2 3
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_E], 3); // A E F d  1 0 2 3
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_G], 2); // A E f G  1 0 2 2
+    cache_srrip_test.access_and_check_cache(addr_vec[ADDR_H], 3); // A E H g  2 1 2 3
+    assert(cache_srrip_test.get_block_counter(addr_vec[ADDR_A]) == 2);
+    assert(cache_srrip_test.get_block_counter(addr_vec[ADDR_H]) == 2);
+}
+
+void
+unit_test_cache_brrip_four_way()
+{
+    cache_policy_test_t<cache_rrip_t> cache_brrip_test(/*associativity=*/4,
+                                                       /*line_size=*/32,
+                                                       /*total_size=*/256, RRIP_BIMODAL);
+    cache_brrip_test.initialize_cache();
+
+    // Lower-case letter shows the way that is to be replaced after the access.
+    // The digits are the re-reference prediction values of the ways.
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_A], 1); // A x X X  3 - - -
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_B], 2); // A B x X  3 3 - -
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_C], 3); // A B C x  3 3 3 -
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_D], 0); // a B C D  3 3 3 3
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_A], 1); // A b C D  0 3 3 3
+    // New lines are inserted as distant and so replace each other.
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_E], 1); // A e C D  0 3 3 3
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_F], 1); // A f C D  0 3 3 3
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_A], 1); // A f C D  0 3 3 3
+    // Every BRRIP_LONG_INTERVAL-th insertion is long instead.
+    for (int i = 7; i < cache_rrip_t::BRRIP_LONG_INTERVAL; ++i) {
+        cache_brrip_test.access_and_check_cache(addr_vec[ADDR_E + ((i + 1) % 2)], 1);
+    }
+    cache_brrip_test.access_and_check_cache(addr_vec[ADDR_G], 2); // A G c D  0 2 3 3
+    assert(cache_brrip_test.get_block_counter(addr_vec[ADDR_G]) == 2);
+}
+
+void
+unit_test_cache_drrip_set_dueling()
+{
+    // 16 sets of 4 ways: sets 0, 4, 8 and 12 lead for SRRIP, sets 2, 6, 10 and 14
+    // lead for BRRIP, and the rest follow.
+    const int num_sets = 16;
+    const int line_size = 32;
+    cache_policy_test_t<cache_rrip_t> cache_drrip_test(
+        /*associativity=*/4, line_size, /*total_size=*/4 * line_size * num_sets,
+        RRIP_DYNAMIC);
+    cache_drrip_test.initialize_cache();
+    auto addr = [&](int set, int tag) -> addr_t {
+        return (static_cast<addr_t>(tag) * num_sets + set) * line_size;
+    };
+
+    // The selector starts out favoring SRRIP.
+    cache_drrip_test.access_and_check_cache(addr(1, 0), 1);
+    assert(cache_drrip_test.get_block_counter(addr(1, 0)) ==
+           cache_rrip_t::RRPV_MAX - 1);
+    // A miss in an SRRIP leader set tips the followers over to BRRIP.
+    cache_drrip_test.access_and_check_cache(addr(0, 0), 1);
+    assert(cache_drrip_test.get_block_counter(addr(0, 0)) ==
+           cache_rrip_t::RRPV_MAX - 1);
+    cache_drrip_test.access_and_check_cache(addr(1, 1), 2);
+    assert(cache_drrip_test.get_block_counter(addr(1, 1)) == cache_rrip_t::RRPV_MAX);
+    // Two misses in a BRRIP leader set tip them back.
+    cache_drrip_test.access_and_check_cache(addr(2, 0), 1);
+    assert(cache_drrip_test.get_block_counter(addr(2, 0)) == cache_rrip_t::RRPV_MAX);
+    cache_drrip_test.access_and_check_cache(addr(2, 1), 2);
+    cache_drrip_test.access_and_check_cache(addr(3, 0), 1);
+    assert(cache_drrip_test.get_block_counter(addr(3, 0)) ==
+           cache_rrip_t::RRPV_MAX - 1);
+}
+
+void
+unit_test_cache_ship_four_way()
+{
+    cache_policy_test_t<cache_ship_t> cache_ship_test(/*associativity=*/4,
+                                                      /*line_size=*/32,
+                                                      /*total_size=*/128);
+    cache_ship_test.initialize_cache();
+
+    const addr_t scan_pc = 0x1000;
+    const addr_t reuse_pc = 0x2000;
+    // Lower-case letter shows the way that is to be replaced after the access.
+    // The digits are the re-reference prediction values of the ways.
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_A], scan_pc, 1); // 2 - - -
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_B], scan_pc, 2); // 2 2 - -
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_C], scan_pc, 3); // 2 2 2 -
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_D], scan_pc, 0); // 2 2 2 2
+    // Evicting A without reuse marks scan_pc as dead, so E is inserted distant.
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_E], scan_pc, 0); // 3 3 3 3
+    assert(cache_ship_test.get_block_counter(addr_vec[ADDR_E]) ==
+           cache_rrip_t::RRPV_MAX);
+    // reuse_pc has no history and gets the SRRIP insertion.
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_F], reuse_pc, 1); // 2 3 3 3
+    assert(cache_ship_test.get_block_counter(addr_vec[ADDR_F]) ==
+           cache_rrip_t::RRPV_MAX - 1);
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_F], reuse_pc, 1); // 0 3 3 3
+    // Scanning lines now keep replacing each other rather than F.
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_G], scan_pc, 1); // 0 3 3 3
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_H], scan_pc, 1); // 0 3 3 3
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_I], scan_pc, 1); // 0 3 3 3
+    cache_ship_test.access_and_check_cache(addr_vec[ADDR_F], reuse_pc, 1); // 0 3 3 3
+}
+
 void
 unit_test_cache_replacement_policy()
 {
@@ -247,5 +396,9 @@ unit_test_cache_replacement_policy()
     unit_test_cache_lru_eight_way();
     unit_test_cache_fifo_four_way();
     unit_test_cache_fifo_eight_way();
+    unit_test_cache_srrip_four_way();
+    unit_test_cache_brrip_four_way();
+    unit_test_cache_drrip_set_dueling();
+    unit_test_cache_ship_four_way();
     // XXX i#4842: Add more test sequences.
 }
@@ -0,0 +1,222 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+// Microbenchmark for the per-set tag match and LRU update operations used by the
+// cache simulator.  For each set_ops implementation the host supports it drives an
+// LRU cache of each of several associativities with the same synthetic reference
+// stream and prints simulated references per second.  It also checks that every
+// implementation produces the same hit and miss counts.  Finally it compares
+// looking up ways through the tag-to-way table against set walks for fully
+// associative TLBs, whose entries for different processes may share tags.  Last,
+// it checks that the -timing model keeps the cache simulator within twice its
+// throughput without it.
+// Usage: tool.drcachesim.set_ops_bench [num_refs]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#undef NDEBUG
+#include <assert.h>
+#include "simulator/cache_lru.h"
+#include "simulator/cache_simulator.h"
+#include "simulator/cache_stats.h"
+#include "simulator/set_ops.h"
+#include "simulator/tlb.h"
+#include "simulator/tlb_stats.h"
+
+static const int LINE_SIZE = 64;
+static const int CACHE_SIZE = 256 * 1024;
+
+struct bench_result_t {
+    double refs_per_sec;
+    int_least64_t hits;
+    int_least64_t misses;
+};
+
+static bench_result_t
+run_one(set_ops_kind_t ops_kind, int associativity, int num_refs)
+{
+    cache_stats_t stats(LINE_SIZE, "", true);
+    cache_lru_t cache;
+    if (!cache.init(associativity, LINE_SIZE, CACHE_SIZE, nullptr, &stats, nullptr) ||
+        !cache.use_set_ops(ops_kind)) {
+        std::cerr << "Failed to initialize a " << associativity << "-way cache\n";
+        exit(1);
+    }
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    // A fixed-seed LCG mixing a hot region that mostly hits with a region four
+    // times the cache size that mostly misses, so both the tag match and the
+    // replacement paths are exercised.
+    uint64_t seed = 42;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_refs; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t rnd = seed >> 33;
+        uint64_t span = (rnd & 3) == 0 ? 4 * CACHE_SIZE : CACHE_SIZE / 2;
+        ref.data.addr = static_cast<addr_t>((rnd >> 2) % span) & ~(addr_t)3;
+        cache.request(ref);
+    }
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    bench_result_t res;
+    res.refs_per_sec = secs.count() > 0 ? num_refs / secs.count() : 0;
+    res.hits = stats.get_metric(metric_name_t::HITS);
+    res.misses = stats.get_metric(metric_name_t::MISSES);
+    return res;
+}
+
+static bench_result_t
+run_tlb(int entries, bool use_table, int num_refs)
+{
+    const int page_size = 4096;
+    tlb_stats_t stats(page_size);
+    tlb_t tlb;
+    if (!tlb.init(entries, page_size, entries, nullptr, &stats)) {
+        std::cerr << "Failed to initialize a " << entries << "-entry TLB\n";
+        exit(1);
+    }
+    tlb.set_hashtable_use(use_table);
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    // Two processes touch the same pages: mostly a hot set that fits in the TLB,
+    // with occasional references to a region twice the TLB reach.
+    uint64_t seed = 42;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_refs; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t rnd = seed >> 33;
+        ref.data.pid = 1 + (rnd & 1);
+        uint64_t pages = (rnd & 0x1e) == 0 ? 2 * entries : entries / 4;
+        ref.data.addr = static_cast<addr_t>(((rnd >> 3) % pages) * page_size);
+        tlb.request(ref);
+    }
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    bench_result_t res;
+    res.refs_per_sec = secs.count() > 0 ? num_refs / secs.count() : 0;
+    res.hits = stats.get_metric(metric_name_t::HITS);
+    res.misses = stats.get_metric(metric_name_t::MISSES);
+    return res;
+}
+
+static double
+run_cache_sim(bool timing, int num_refs)
+{
+    cache_simulator_knobs_t knobs;
+    knobs.model_timing = timing;
+    cache_simulator_t cache_sim(knobs);
+    if (!cache_sim) {
+        std::cerr << "Failed to create the cache simulator\n";
+        exit(1);
+    }
+    memref_t ref = {};
+    ref.data.pid = 1;
+    ref.data.size = 4;
+    // Eight threads with a code footprint that fits in the L1 caches and a data
+    // footprint twice the LLC size.
+    uint64_t seed = 42;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_refs; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t rnd = seed >> 33;
+        ref.data.tid = 1 + (rnd & 7);
+        if ((rnd & 0x18) == 0) {
+            ref.data.type = TRACE_TYPE_INSTR;
+            ref.data.addr = static_cast<addr_t>((rnd >> 5) % (16 * 1024));
+        } else {
+            ref.data.type = (rnd & 0x20) == 0 ? TRACE_TYPE_WRITE : TRACE_TYPE_READ;
+            uint64_t span = (rnd & 0x1c0) == 0 ? 2 * knobs.LL_size : 16 * 1024;
+            ref.data.addr = static_cast<addr_t>((rnd >> 9) % span) & ~(addr_t)3;
+        }
+        cache_sim.process_memref(ref);
+    }
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    return secs.count() > 0 ? num_refs / secs.count() : 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    int num_refs = 4 * 1000 * 1000;
+    if (argc > 1)
+        num_refs = atoi(argv[1]);
+    const int assocs[] = { 4, 8, 16, 32 };
+    const int num_assocs = sizeof(assocs) / sizeof(assocs[0]);
+    bench_result_t scalar[num_assocs];
+    for (int kind = SET_OPS_SCALAR; kind <= SET_OPS_AVX2; ++kind) {
+        set_ops_kind_t ops_kind = static_cast<set_ops_kind_t>(kind);
+        if (set_ops_get(ops_kind) == nullptr)
+            continue;
+        for (int i = 0; i < num_assocs; ++i) {
+            bench_result_t res = run_one(ops_kind, assocs[i], num_refs);
+            if (kind == SET_OPS_SCALAR)
+                scalar[i] = res;
+            else
+                assert(res.hits == scalar[i].hits && res.misses == scalar[i].misses);
+            std::cout << std::setw(6) << set_ops_kind_name(ops_kind)
+                      << " " << std::setw(2) << assocs[i] << "-way: " << std::fixed
+                      << std::setprecision(0) << res.refs_per_sec << " refs/sec";
+            if (kind != SET_OPS_SCALAR && scalar[i].refs_per_sec > 0) {
+                std::cout << " (" << std::setprecision(2)
+                          << res.refs_per_sec / scalar[i].refs_per_sec << "x scalar)";
+            }
+            std::cout << "\n";
+        }
+    }
+    for (int entries : { 64, 1024 }) {
+        bench_result_t walk = run_tlb(entries, false, num_refs);
+        bench_result_t table = run_tlb(entries, true, num_refs);
+        assert(table.hits == walk.hits && table.misses == walk.misses);
+        std::cout << std::setw(4) << entries << "-entry TLB: " << std::setprecision(0)
+                  << walk.refs_per_sec << " refs/sec walking, " << table.refs_per_sec
+                  << " refs/sec with table";
+        if (walk.refs_per_sec > 0) {
+            std::cout << " (" << std::setprecision(2)
+                      << table.refs_per_sec / walk.refs_per_sec << "x)";
+        }
+        std::cout << "\n";
+    }
+    double plain = run_cache_sim(false, num_refs);
+    double timing = run_cache_sim(true, num_refs);
+    std::cout << "cache simulator: " << std::setprecision(0) << plain
+              << " refs/sec, with -timing " << timing << " refs/sec";
+    if (timing > 0) {
+        std::cout << " (" << std::setprecision(2) << plain / timing << "x slower)";
+    }
+    std::cout << "\n";
+    // Short runs used as tests are too noisy to compare.
+    if (num_refs >= 1000 * 1000)
+        assert(timing * 2 >= plain);
+    return 0;
+}
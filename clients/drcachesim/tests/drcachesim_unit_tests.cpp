@@ -32,11 +32,31 @@
 
 // Unit tests for drcachesim
 #include <iostream>
+#include <memory>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 #undef NDEBUG
 #include <assert.h>
 #include "cache_replacement_policy_unit_test.h"
 #include "simulator/cache_simulator.h"
+#include "simulator/cache_lru.h"
+#include "simulator/cache_stats.h"
+#include "simulator/checkpoint.h"
+#include "simulator/page_size_map.h"
+#include "simulator/page_walker.h"
+#include "simulator/pc_symbolizer.h"
+#include "simulator/parallel_cache_sim.h"
+#include "simulator/prefetcher_spatial.h"
+#include "simulator/set_ops.h"
+#include "simulator/tag_table.h"
+#include "simulator/timing_model.h"
+#include "simulator/tlb.h"
+#include "simulator/tlb_stats.h"
+#include "tools/miss_ratio_curve.h"
 #include "../common/memref.h"
 
 static cache_simulator_knobs_t
@@ -306,6 +326,623 @@ LLC {
            num_accesses - 1);
 }
 
+static void
+simulate_multicore_stream(cache_simulator_t &cache_sim)
+{
+    // Interleave 8 threads over 4 cores with a mix of instruction fetches, reads,
+    // writes and flushes, with enough distinct lines to miss in every level.
+    uint64_t seed = 7;
+    memref_t ref = {};
+    for (int i = 0; i < 200000; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t rnd = seed >> 33;
+        ref.data.pid = 1;
+        ref.data.tid = 1 + (rnd % 8);
+        ref.data.addr = static_cast<addr_t>((rnd >> 3) % (1 << 18));
+        ref.data.size = 4;
+        switch ((rnd >> 24) % 8) {
+        case 0:
+        case 1: ref.data.type = TRACE_TYPE_INSTR; break;
+        case 2: ref.data.type = TRACE_TYPE_WRITE; break;
+        default: ref.data.type = TRACE_TYPE_READ; break;
+        }
+        if (i % 20011 == 0) {
+            ref.flush.type = TRACE_TYPE_DATA_FLUSH;
+            ref.flush.size = 4096;
+        }
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_parallel_cores failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+    cache_sim.finish_parallel_simulation();
+}
+
+void
+unit_test_parallel_cores()
+{
+    cache_simulator_knobs_t knobs;
+    knobs.L1I_size = 4 * 1024;
+    knobs.L1D_size = 4 * 1024;
+    knobs.LL_size = 64 * 1024;
+    knobs.warmup_refs = 1000;
+    cache_simulator_t serial_sim(knobs);
+    simulate_multicore_stream(serial_sim);
+    const metric_name_t metrics[] = { metric_name_t::HITS, metric_name_t::MISSES,
+                                      metric_name_t::CHILD_HITS,
+                                      metric_name_t::COMPULSORY_MISSES };
+    for (bool deterministic : { true, false }) {
+        knobs.parallel_cores = true;
+        knobs.parallel_deterministic = deterministic;
+        knobs.parallel_epoch = 777;
+        cache_simulator_t parallel_sim(knobs);
+        simulate_multicore_stream(parallel_sim);
+        for (unsigned int core = 0; core < knobs.num_cores; ++core) {
+            for (metric_name_t metric : metrics) {
+                // The private caches never depend on the order of shared accesses.
+                for (cache_split_t split :
+                     { cache_split_t::DATA, cache_split_t::INSTRUCTION }) {
+                    assert(parallel_sim.get_cache_metric(metric, 1, core, split) ==
+                           serial_sim.get_cache_metric(metric, 1, core, split));
+                }
+                int_least64_t serial_llc = serial_sim.get_cache_metric(metric, 2, core);
+                int_least64_t parallel_llc =
+                    parallel_sim.get_cache_metric(metric, 2, core);
+                if (deterministic)
+                    assert(parallel_llc == serial_llc);
+                else if (metric == metric_name_t::CHILD_HITS)
+                    assert(parallel_llc == serial_llc);
+            }
+        }
+        // The total number of shared accesses does not depend on their order.
+        assert(parallel_sim.get_cache_metric(metric_name_t::HITS, 2) +
+                   parallel_sim.get_cache_metric(metric_name_t::MISSES, 2) ==
+               serial_sim.get_cache_metric(metric_name_t::HITS, 2) +
+                   serial_sim.get_cache_metric(metric_name_t::MISSES, 2));
+    }
+    // The private caches must not depend on the shared state.
+    knobs.model_coherence = true;
+    cache_simulator_t coherent_sim(knobs);
+    assert(!coherent_sim);
+    cache_lru_t llc, l1i, l1d;
+    cache_stats_t llc_stats(64), l1i_stats(64), l1d_stats(64);
+    llc.init(4, 64, 4096, nullptr, &llc_stats, nullptr, true /*inclusive*/);
+    l1i.init(2, 64, 1024, &llc, &l1i_stats, nullptr);
+    l1d.init(2, 64, 1024, &llc, &l1d_stats, nullptr);
+    cache_t *l1_icaches[] = { &l1i };
+    cache_t *l1_dcaches[] = { &l1d };
+    parallel_cache_sim_t inclusive_sim(true, 777);
+    std::string error;
+    assert(!inclusive_sim.init(l1_icaches, l1_dcaches, 1, &llc, error));
+    assert(!error.empty());
+}
+
+void
+unit_test_set_sampling()
+{
+    cache_simulator_knobs_t knobs;
+    knobs.L1I_size = 4 * 1024;
+    knobs.L1D_size = 4 * 1024;
+    knobs.LL_size = 64 * 1024;
+    knobs.LL_assoc = 4;
+    cache_simulator_t full_sim(knobs);
+    simulate_multicore_stream(full_sim);
+    knobs.LL_sample_fraction = 0.25;
+    cache_simulator_t sampled_sim(knobs);
+    simulate_multicore_stream(sampled_sim);
+    // The L1 caches are unaffected, while the LLC estimates should be close.
+    assert(sampled_sim.get_cache_metric(metric_name_t::MISSES, 1) ==
+           full_sim.get_cache_metric(metric_name_t::MISSES, 1));
+    assert(sampled_sim.get_cache_metric(metric_name_t::CHILD_HITS, 2) ==
+           full_sim.get_cache_metric(metric_name_t::CHILD_HITS, 2));
+    double full_misses =
+        static_cast<double>(full_sim.get_cache_metric(metric_name_t::MISSES, 2));
+    double sampled_misses =
+        static_cast<double>(sampled_sim.get_cache_metric(metric_name_t::MISSES, 2));
+    assert(full_misses > 0 && fabs(sampled_misses - full_misses) / full_misses < 0.1);
+}
+
+void
+unit_test_set_ops()
+{
+    // Compare each vector implementation the host supports against the scalar one,
+    // covering associativities that do and do not fill whole vectors.
+    const int max_ways = 40;
+    const set_ops_t &scalar_ops = *set_ops_get(SET_OPS_SCALAR);
+    std::vector<addr_t> tags(max_ways);
+    std::vector<int> counters(max_ways), expect_counters(max_ways);
+    for (int kind = SET_OPS_SSE2; kind <= SET_OPS_AVX2; ++kind) {
+        const set_ops_t *vec_ops = set_ops_get(static_cast<set_ops_kind_t>(kind));
+        if (vec_ops == nullptr)
+            continue;
+        for (int num_ways = 1; num_ways <= max_ways; ++num_ways) {
+            for (int trial = 0; trial < 64; ++trial) {
+                for (int way = 0; way < num_ways; ++way) {
+                    // Include tags that differ only in their upper half.
+                    addr_t upper = static_cast<addr_t>(rand() % 4);
+                    tags[way] = (upper << (sizeof(addr_t) * 4)) | (rand() % 8);
+                    counters[way] = rand() % (num_ways + 1);
+                }
+                addr_t tag = tags[rand() % num_ways] + (trial % 2);
+                assert(vec_ops->find_tag(tags.data(), num_ways, tag) ==
+                       scalar_ops.find_tag(tags.data(), num_ways, tag));
+                assert(vec_ops->find_max_counter(counters.data(), num_ways) ==
+                       scalar_ops.find_max_counter(counters.data(), num_ways));
+                int limit = rand() % (num_ways + 1);
+                expect_counters = counters;
+                scalar_ops.inc_counters_upto(expect_counters.data(), num_ways, limit);
+                vec_ops->inc_counters_upto(counters.data(), num_ways, limit);
+                assert(counters == expect_counters);
+            }
+        }
+    }
+}
+
+void
+unit_test_miss_ratio_curve()
+{
+    // The single-pass curve must match separate simulations of each LRU cache.
+    miss_ratio_curve_knobs_t knobs;
+    knobs.min_size = 1024;
+    knobs.max_size = 64 * 1024;
+    knobs.max_assoc = 8;
+    miss_ratio_curve_t mrc(knobs);
+    std::vector<memref_t> refs;
+    uint64_t seed = 11;
+    memref_t ref = {};
+    for (int i = 0; i < 50000; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t rnd = seed >> 33;
+        ref.data.type = (rnd % 4 == 0) ? TRACE_TYPE_WRITE : TRACE_TYPE_READ;
+        // Mix a hot region with a larger one, with some references spanning lines.
+        ref.data.addr = static_cast<addr_t>((rnd >> 3) % ((rnd & 4) ? 4096 : 96 * 1024));
+        ref.data.size = 8;
+        refs.push_back(ref);
+        mrc.process_memref(ref);
+    }
+    int_least64_t accesses = mrc.get_accesses(miss_ratio_curve_t::STREAM_DATA);
+    assert(accesses > static_cast<int_least64_t>(refs.size()));
+    assert(mrc.get_accesses(miss_ratio_curve_t::STREAM_UNIFIED) == accesses);
+    assert(mrc.get_accesses(miss_ratio_curve_t::STREAM_INSTRUCTION) == 0);
+    for (int size = 1024; size <= 64 * 1024; size *= 2) {
+        for (int assoc : { 1, 2, 4, 8, 0 }) {
+            cache_lru_t cache;
+            cache_stats_t stats(64);
+            if (!cache.init(assoc == 0 ? size / 64 : assoc, 64, size, nullptr, &stats,
+                            nullptr)) {
+                std::cerr << "drcachesim unit_test_miss_ratio_curve failed to init\n";
+                exit(1);
+            }
+            for (const memref_t &entry : refs)
+                cache.request(entry);
+            assert(stats.get_metric(metric_name_t::HITS) +
+                       stats.get_metric(metric_name_t::MISSES) ==
+                   accesses);
+            assert(mrc.get_misses(miss_ratio_curve_t::STREAM_DATA, size, assoc) ==
+                   stats.get_metric(metric_name_t::MISSES));
+        }
+    }
+    assert(mrc.get_misses(miss_ratio_curve_t::STREAM_DATA, 128 * 1024, 1) == -1);
+    assert(mrc.get_misses(miss_ratio_curve_t::STREAM_DATA, 1024, 16) == -1);
+}
+
+void
+unit_test_tag_table()
+{
+    // Mirror random inserts and erases into a std::unordered_map.  The keys are
+    // strided like tags that conflict in a cache, so probe runs form and erase
+    // has to shift entries back across them, including across the wraparound.
+    tag_table_t<int> table;
+    std::unordered_map<addr_t, int> expect;
+    for (int i = 0; i < 200000; ++i) {
+        addr_t key = static_cast<addr_t>(rand() % 512) << 12;
+        if (rand() % 3 == 0) {
+            assert(table.erase(key) == (expect.erase(key) == 1));
+        } else {
+            table[key] = i;
+            expect[key] = i;
+        }
+        assert(table.size() == expect.size());
+        addr_t probe = static_cast<addr_t>(rand() % 512) << 12;
+        int *value = table.find(probe);
+        auto it = expect.find(probe);
+        assert((value == nullptr) == (it == expect.end()));
+        assert(value == nullptr || *value == it->second);
+    }
+    table.clear();
+    assert(table.size() == 0 && table.find(0) == nullptr);
+}
+
+// Runs data reads of the given addresses and PCs through a single-core simulator
+// with the given L1D prefetcher and returns the simulator's L1D metric.
+static int_least64_t
+run_prefetcher(const std::string &prefetcher, const std::vector<addr_t> &addrs,
+               const std::vector<addr_t> &pcs, metric_name_t metric,
+               unsigned int late_refs = 4)
+{
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    knobs.L1D_size = 64 * 64;
+    knobs.L1D_assoc = 8;
+    knobs.LL_size = 1024 * 64;
+    knobs.LL_assoc = 16;
+    knobs.data_prefetcher = prefetcher;
+    knobs.prefetch_late_refs = late_refs;
+    cache_simulator_t cache_sim(knobs);
+    memref_t ref;
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    for (size_t i = 0; i < addrs.size(); ++i) {
+        ref.data.addr = addrs[i];
+        ref.data.pc = pcs[i];
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_prefetchers failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+    return cache_sim.get_cache_metric(metric, 1, 0, cache_split_t::DATA);
+}
+
+void
+unit_test_prefetchers()
+{
+    std::vector<addr_t> addrs, pcs;
+    // A single instruction walking through memory 3 lines at a time, interleaved
+    // with another walking backward one line at a time.
+    for (int i = 0; i < 300; ++i) {
+        addrs.push_back(0x100000 + i * 3 * 64);
+        pcs.push_back(0x1000);
+        addrs.push_back(0x900000 - i * 64);
+        pcs.push_back(0x2000);
+    }
+    int_least64_t base_misses = run_prefetcher("none", addrs, pcs, metric_name_t::MISSES);
+    assert(base_misses == 600);
+    assert(run_prefetcher("none", addrs, pcs, metric_name_t::PREFETCHES_ISSUED) == 0);
+    for (const std::string &policy : { "stride", "stream" }) {
+        int_least64_t misses = run_prefetcher(policy, addrs, pcs, metric_name_t::MISSES);
+        int_least64_t issued =
+            run_prefetcher(policy, addrs, pcs, metric_name_t::PREFETCHES_ISSUED);
+        int_least64_t useful =
+            run_prefetcher(policy, addrs, pcs, metric_name_t::PREFETCHES_USEFUL);
+        assert(misses < base_misses / 3);
+        // Every demand hit is on a line we prefetched.
+        assert(useful == static_cast<int_least64_t>(addrs.size()) - misses);
+        assert(issued >= useful);
+        assert(run_prefetcher(policy, addrs, pcs, metric_name_t::PREFETCHES_LATE) <=
+               useful);
+        assert(run_prefetcher(policy, addrs, pcs, metric_name_t::PREFETCHES_LATE, 0) ==
+               0);
+    }
+
+    // The same three lines of each 2KB region, the first touched by the same
+    // instruction.  Each region after the first NUM_ACTIVE_REGIONS evicts one from
+    // the active table, whose stored pattern then prefetches its other lines.
+    addrs.clear();
+    pcs.clear();
+    for (int region = 0; region < 200; ++region) {
+        for (int line : { 0, 5, 9 }) {
+            addrs.push_back(0x200000 + region * 2048 + line * 64);
+            pcs.push_back(0x3000 + line);
+        }
+    }
+    base_misses = run_prefetcher("none", addrs, pcs, metric_name_t::MISSES);
+    assert(base_misses == 600);
+    int_least64_t misses = run_prefetcher("spatial", addrs, pcs, metric_name_t::MISSES);
+    assert(misses ==
+           3 * prefetcher_spatial_t::NUM_ACTIVE_REGIONS +
+               (200 - prefetcher_spatial_t::NUM_ACTIVE_REGIONS));
+    assert(run_prefetcher("spatial", addrs, pcs, metric_name_t::PREFETCHES_USEFUL) ==
+           600 - misses);
+
+    // With a direct-mapped 2-line L1D, next-line prefetches evict lines in use.
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    knobs.L1D_size = 2 * 64;
+    knobs.L1D_assoc = 1;
+    knobs.data_prefetcher = "nextline";
+    cache_simulator_t cache_sim(knobs);
+    memref_t ref;
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    ref.data.pc = 0;
+    for (addr_t line : { 0, 3, 0, 1 }) {
+        ref.data.addr = line * 64;
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_prefetchers failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+    // Line 1 is prefetched on each miss to line 0, and line 4 on the miss to line
+    // 3, evicting line 0.
+    assert(cache_sim.get_cache_metric(metric_name_t::PREFETCHES_ISSUED, 1, 0,
+                                      cache_split_t::DATA) == 3);
+    assert(cache_sim.get_cache_metric(metric_name_t::PREFETCHES_POLLUTING, 1, 0,
+                                      cache_split_t::DATA) == 1);
+    assert(cache_sim.get_cache_metric(metric_name_t::PREFETCHES_USEFUL, 1, 0,
+                                      cache_split_t::DATA) == 1);
+    assert(cache_sim.get_cache_metric(metric_name_t::PREFETCHES_LATE, 1, 0,
+                                      cache_split_t::DATA) == 1);
+}
+
+void
+unit_test_timing_model()
+{
+    // One core with two MSHRs, a 100-cycle memory, and one cycle per line transfer.
+    timing_model_t timing(1, 2, 100, 64.0, 64);
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    // A load missing in the L1 and the LLC stalls for the LLC and memory latencies.
+    timing.start_access(0, 4);
+    timing.add_miss(ref, 40, false);
+    timing.add_miss(ref, 0, true);
+    timing.finish_access(ref);
+    assert(timing.get_stall_cycles(0) == 141);
+    assert(timing.get_cycles(0) == 141);
+    // A hit costs nothing beyond the pipeline.
+    timing.start_access(0, 4);
+    timing.finish_access(ref);
+    assert(timing.get_stall_cycles(0) == 141);
+    assert(timing.get_average_access_time(0) == (145 + 4) / 2.0);
+    // Store misses only stall once both MSHRs are busy, and the third one waits
+    // for the first to complete.  Each transfer also waits for the prior one.
+    ref.data.type = TRACE_TYPE_WRITE;
+    for (int i = 0; i < 3; ++i) {
+        timing.start_access(0, 4);
+        timing.add_miss(ref, 0, true);
+        timing.finish_access(ref);
+    }
+    assert(timing.get_stall_cycles(0) == 141 + 101);
+    // Hardware prefetches use bandwidth but add no latency.
+    timing.reset();
+    ref.data.type = TRACE_TYPE_READ;
+    memref_t prefetch = ref;
+    prefetch.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
+    timing.start_access(0, 4);
+    timing.add_miss(ref, 0, true);
+    timing.add_miss(prefetch, 0, true);
+    timing.finish_access(ref);
+    assert(timing.get_stall_cycles(0) == 101);
+    timing.start_access(0, 4);
+    timing.add_miss(ref, 0, true);
+    timing.finish_access(ref);
+    assert(timing.get_stall_cycles(0) == 101 + 101);
+
+    // Timing must not change the hits and misses of the caches.
+    cache_simulator_knobs_t knobs;
+    knobs.L1I_size = 4 * 1024;
+    knobs.L1D_size = 4 * 1024;
+    knobs.LL_size = 64 * 1024;
+    cache_simulator_t plain_sim(knobs);
+    simulate_multicore_stream(plain_sim);
+    knobs.model_timing = true;
+    cache_simulator_t timing_sim(knobs);
+    simulate_multicore_stream(timing_sim);
+    const timing_model_t *model = timing_sim.get_timing_model();
+    assert(model != nullptr && plain_sim.get_timing_model() == nullptr);
+    for (unsigned int core = 0; core < knobs.num_cores; ++core) {
+        for (unsigned int level = 1; level <= 2; ++level) {
+            assert(timing_sim.get_cache_metric(metric_name_t::MISSES, level, core) ==
+                   plain_sim.get_cache_metric(metric_name_t::MISSES, level, core));
+        }
+        assert(model->get_stall_cycles(core) > 0);
+        assert(model->get_cycles(core) > model->get_stall_cycles(core));
+        assert(model->get_average_access_time(core) > knobs.L1D_latency);
+    }
+    knobs.parallel_cores = true;
+    cache_simulator_t parallel_sim(knobs);
+    assert(!parallel_sim);
+}
+
+static void
+simulate_checkpoint_stream(cache_simulator_t &cache_sim, int start, int end)
+{
+    uint64_t seed = 11;
+    memref_t ref = {};
+    for (int i = 0; i < end; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (i < start)
+            continue;
+        uint64_t rnd = seed >> 33;
+        ref.data.pid = 1;
+        ref.data.tid = 1 + (rnd % 4);
+        ref.data.addr = static_cast<addr_t>((rnd >> 3) % (1 << 17));
+        ref.data.size = 4;
+        ref.data.type = (rnd >> 24) % 4 == 0 ? TRACE_TYPE_INSTR : TRACE_TYPE_READ;
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_checkpoint failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+}
+
+void
+unit_test_checkpoint()
+{
+    // A run restored from the checkpoint written at the end of warmup must match
+    // a run that simulates the warmup itself.
+    const std::string path = "drcachesim_unit_test.ckpt";
+    const int num_refs = 100000;
+    cache_simulator_knobs_t knobs;
+    knobs.L1I_size = 4 * 1024;
+    knobs.L1D_size = 4 * 1024;
+    knobs.LL_size = 32 * 1024;
+    knobs.data_prefetcher = "stride";
+    knobs.replace_policy = "SRRIP";
+    knobs.warmup_refs = 20000;
+    knobs.save_checkpoint = path;
+    cache_simulator_t saving_sim(knobs);
+    simulate_checkpoint_stream(saving_sim, 0, num_refs);
+    uint64_t position;
+    std::string error;
+    if (!checkpoint_read_position(path, position, error)) {
+        std::cerr << "drcachesim unit_test_checkpoint failed: " << error << "\n";
+        exit(1);
+    }
+    assert(position > 0 && position < num_refs);
+    knobs.save_checkpoint.clear();
+    knobs.restore_checkpoint = path;
+    cache_simulator_t restored_sim(knobs);
+    if (!restored_sim) {
+        std::cerr << "drcachesim unit_test_checkpoint failed: "
+                  << restored_sim.get_error_string() << "\n";
+        exit(1);
+    }
+    simulate_checkpoint_stream(restored_sim, static_cast<int>(position), num_refs);
+    for (int level = 1; level <= 2; ++level) {
+        for (metric_name_t metric :
+             { metric_name_t::HITS, metric_name_t::MISSES, metric_name_t::CHILD_HITS,
+               metric_name_t::PREFETCH_HITS }) {
+            assert(saving_sim.get_cache_metric(metric, level, 0) ==
+                   restored_sim.get_cache_metric(metric, level, 0));
+        }
+    }
+    assert(saving_sim.get_cache_metric(metric_name_t::MISSES, 2, 0) > 0);
+
+    // A checkpoint of another hierarchy is rejected.
+    knobs.LL_size = 64 * 1024;
+    cache_simulator_t mismatched_sim(knobs);
+    assert(!mismatched_sim);
+    std::remove(path.c_str());
+}
+
+class test_symbolizer_t : public pc_symbolizer_t {
+public:
+    void
+    lookup(addr_t pc, std::string &module, std::string &function) override
+    {
+        ++lookups;
+        module = "test";
+        function = pc < 0x2000 ? "low" : "high";
+    }
+    int lookups = 0;
+};
+
+void
+unit_test_miss_attribution()
+{
+    // Demand misses are counted per instruction, but hits and prefetches are not.
+    cache_stats_t stats(64, "", false);
+    stats.enable_pc_attribution();
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    ref.data.pc = 0x1000;
+    stats.access(ref, false, nullptr);
+    stats.access(ref, false, nullptr);
+    stats.access(ref, true, nullptr);
+    ref.data.pc = 0x1004;
+    stats.access(ref, false, nullptr);
+    ref.data.type = TRACE_TYPE_PREFETCH;
+    stats.access(ref, false, nullptr);
+    ref.instr.type = TRACE_TYPE_INSTR;
+    ref.instr.addr = 0x3000;
+    stats.access(ref, false, nullptr);
+    std::unordered_map<addr_t, int_least64_t> counts;
+    stats.get_pc_misses()->for_each(
+        [&](addr_t pc, int_least64_t count) { counts[pc] = count; });
+    assert(counts.size() == 3);
+    assert(counts[0x1000] == 2 && counts[0x1004] == 1 && counts[0x3000] == 1);
+    stats.reset();
+    assert(stats.get_pc_misses()->size() == 0);
+
+    // The report symbolizes each instruction once across all levels.
+    cache_simulator_knobs_t knobs;
+    knobs.num_cores = 1;
+    knobs.miss_attribution = 2;
+    knobs.data_prefetcher = "none";
+    auto symbolizer = std::make_shared<test_symbolizer_t>();
+    knobs.symbolizer = symbolizer;
+    cache_simulator_t cache_sim(knobs);
+    ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    for (int i = 0; i < 64; ++i) {
+        ref.data.pc = i % 2 == 0 ? 0x1000 : 0x3000;
+        ref.data.addr = 64 * i;
+        if (!cache_sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_miss_attribution failed: "
+                      << cache_sim.get_error_string() << "\n";
+            exit(1);
+        }
+    }
+    cache_sim.print_results();
+    assert(symbolizer->lookups == 2);
+}
+
+void
+unit_test_page_walker()
+{
+    // Hints may be given as ranges or as smaps, where the 1G-aligned interior of a
+    // hugetlbfs mapping uses 1G pages and a THP mapping uses 2M pages.
+    std::istringstream hints("# A comment.\n"
+                             "200000-600000 2M\n"
+                             "400000-600000 4K\n"
+                             "7f0000000000-7f0080000000 rw-p 00000000 00:0f 12 /huge\n"
+                             "Size:            2097152 kB\n"
+                             "KernelPageSize:  1048576 kB\n"
+                             "7f1000000000-7f1000400000 rw-p 00000000 00:00 0\n"
+                             "KernelPageSize:        4 kB\n"
+                             "AnonHugePages:      4096 kB\n");
+    page_size_map_t page_sizes(12);
+    std::string error;
+    if (!page_sizes.read(hints, error)) {
+        std::cerr << "drcachesim unit_test_page_walker failed: " << error << "\n";
+        exit(1);
+    }
+    assert(page_sizes.lookup(0x1ff000) == 12);
+    assert(page_sizes.lookup(0x3ff000) == 21);
+    assert(page_sizes.lookup(0x400000) == 12);
+    assert(page_sizes.lookup(0x7f0040000000) == 30);
+    assert(page_sizes.lookup(0x7f1000200000) == 21);
+    assert(page_sizes.lookup(0x7f1000400000) == 12);
+    std::istringstream bad("1000-2000 3K\n");
+    assert(!page_size_map_t(12).read(bad, error));
+
+    // Four levels for 4K pages with a two-entry page walk cache per level.
+    page_walker_t walker(1, 12, 2, 4, 40, 200);
+    assert(walker.get_num_levels() == 4);
+    memref_t ref = {};
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 4;
+    ref.data.addr = 0x1000;
+    walker.walk(ref, 12);
+    for (int level = 0; level < 4; ++level)
+        assert(walker.get_references(0, level) == 1);
+    assert(walker.get_cycles(0, 0) == 44);
+    // The same 2M region only needs the leaf entry.
+    ref.data.addr = 0x2000;
+    walker.walk(ref, 12);
+    assert(walker.get_pwc_hits(0, 1) == 1 && walker.get_references(0, 0) == 2);
+    // A 2M page in another 1G region ends at level 1, after a hit at level 3.
+    ref.data.addr = 0x40000000;
+    walker.walk(ref, 21);
+    assert(walker.get_pwc_hits(0, 3) == 1);
+    assert(walker.get_references(0, 2) == 2 && walker.get_references(0, 1) == 2);
+    assert(walker.get_references(0, 0) == 2 && walker.get_walks(0) == 3);
+
+    // A TLB caches a 2M page in one entry, so only the first access walks.
+    page_walker_t tlb_walker(1, 12, 2, 4, 40, 200);
+    for (page_size_map_t *sizes : { (page_size_map_t *)nullptr, &page_sizes }) {
+        tlb_t tlb;
+        if (!tlb.init(4, 4096, 16, nullptr, new tlb_stats_t(4096))) {
+            std::cerr << "drcachesim unit_test_page_walker failed to init the TLB\n";
+            exit(1);
+        }
+        tlb.set_page_sizes(sizes);
+        tlb.set_walker(&tlb_walker);
+        tlb_walker.reset();
+        for (addr_t addr = 0x200000; addr < 0x400000; addr += 0x10000) {
+            ref.data.addr = addr;
+            tlb.request(ref);
+        }
+        assert(tlb_walker.get_walks(0) == (sizes == nullptr ? 32 : 1));
+        delete tlb.get_stats();
+    }
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -316,5 +953,15 @@ main(int argc, const char *argv[])
     unit_test_sim_refs();
     unit_test_child_hits();
     unit_test_cache_replacement_policy();
+    unit_test_set_ops();
+    unit_test_tag_table();
+    unit_test_parallel_cores();
+    unit_test_set_sampling();
+    unit_test_miss_ratio_curve();
+    unit_test_prefetchers();
+    unit_test_timing_model();
+    unit_test_page_walker();
+    unit_test_checkpoint();
+    unit_test_miss_attribution();
     return 0;
 }
@@ -0,0 +1,147 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL GOOGLE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Unit tests for physaddr_t. */
+
+#include "dr_api.h"
+#include "tracer/physaddr.h"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define CHECK(cond, msg, ...)         \
+    do {                              \
+        if (!(cond)) {                \
+            std::cerr << msg << "\n"; \
+            return false;             \
+        }                             \
+    } while (0)
+
+// Reads the physical page backing "vpage" straight from the kernel.
+static bool
+read_pagemap(addr_t vpage, size_t page_size, OUT addr_t *ppage)
+{
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd == -1)
+        return false;
+    uint64_t entry;
+    ssize_t got = pread(fd, &entry, sizeof(entry), vpage / page_size * sizeof(entry));
+    close(fd);
+    if (got != sizeof(entry) || (entry & (1ULL << 63)) == 0)
+        return false;
+    *ppage = static_cast<addr_t>((entry & ((1ULL << 55) - 1)) * page_size);
+    return true;
+}
+
+// Moves a page elsewhere and maps a new page in its place, and checks that a
+// translation cached before the move is not served afterward.
+static bool
+test_remap_invalidation(void *drcontext)
+{
+    physaddr_t physaddr;
+    CHECK(physaddr.init(), "failed to initialize physaddr_t");
+    size_t page_size = dr_page_size();
+    // Reserve a spot to move the page to, plus a neighbor that is translated
+    // by the same batched pagemap read.
+    char *region = reinterpret_cast<char *>(mmap(nullptr, 3 * page_size,
+                                                 PROT_READ | PROT_WRITE,
+                                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    CHECK(region != MAP_FAILED, "mmap failed");
+    char *page = region, *neighbor = region + page_size, *moved = region + 2 * page_size;
+    page[0] = 1;
+    neighbor[0] = 1;
+
+    addr_t phys, neighbor_phys, kernel_phys;
+    bool from_cache;
+    CHECK(physaddr.virtual2physical(drcontext, reinterpret_cast<addr_t>(page), &phys,
+                                    &from_cache),
+          "failed to translate page");
+    CHECK(!from_cache, "first query should not be cached");
+    CHECK(read_pagemap(reinterpret_cast<addr_t>(page), page_size, &kernel_phys) &&
+              kernel_phys == phys,
+          "translation does not match pagemap");
+    CHECK(physaddr.virtual2physical(drcontext, reinterpret_cast<addr_t>(neighbor),
+                                    &neighbor_phys, &from_cache),
+          "failed to translate neighbor");
+    CHECK(!from_cache, "first neighbor query should not be cached");
+    CHECK(physaddr.virtual2physical(drcontext, reinterpret_cast<addr_t>(page), &phys,
+                                    &from_cache) &&
+              from_cache,
+          "repeated query should be cached");
+
+    // Move the page and put a new one in its place.  The old physical page
+    // now backs "moved", so "page" must get a different one.
+    CHECK(physaddr_t::syscall_changes_mappings(SYS_mremap),
+          "mremap should invalidate translations");
+    CHECK(mremap(page, page_size, page_size, MREMAP_MAYMOVE | MREMAP_FIXED, moved) ==
+              moved,
+          "mremap failed");
+    CHECK(mmap(page, page_size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == page,
+          "mmap failed");
+    page[0] = 1;
+    // This is what the tracer does after such a system call.
+    physaddr_t::invalidate_all();
+
+    addr_t new_phys, moved_phys;
+    CHECK(physaddr.virtual2physical(drcontext, reinterpret_cast<addr_t>(page), &new_phys,
+                                    &from_cache),
+          "failed to translate remapped page");
+    CHECK(!from_cache, "stale translation served from the cache");
+    CHECK(new_phys != phys, "stale translation served from the table");
+    CHECK(read_pagemap(reinterpret_cast<addr_t>(page), page_size, &kernel_phys) &&
+              kernel_phys == new_phys,
+          "remapped translation does not match pagemap");
+    CHECK(physaddr.virtual2physical(drcontext, reinterpret_cast<addr_t>(moved),
+                                    &moved_phys, &from_cache) &&
+              moved_phys == phys,
+          "moved page has the wrong translation");
+    munmap(region, 3 * page_size);
+    return true;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    void *drcontext = dr_standalone_init();
+    // Without CAP_SYS_ADMIN the kernel hands out zero page frames, so there is
+    // nothing to check.
+    if (physaddr_t::global_init()) {
+        if (!test_remap_invalidation(drcontext))
+            return 1;
+    }
+    dr_standalone_exit();
+    std::cerr << "all done\n";
+    return 0;
+}
@@ -80,6 +80,16 @@ public:
         byte *pc = instrlist_encode(drcontext, &instrs, decode_buf_, true);
         ASSERT(pc - decode_buf_ < MAX_DECODE_SIZE, "decode buffer overflow");
         set_modvec_(&modules_);
+        set_gencode_index_(&gencode_index_);
+    }
+
+    // Additionally presents the encoded instrs as a -record_gencode snapshot of
+    // code at "orig_pc" whose bytes start at "file_offs" in the snapshot file.
+    void
+    add_gencode_snapshot(uint64_t file_offs, app_pc orig_pc)
+    {
+        gencode_offs_ = file_offs;
+        gencode_pc_ = orig_pc;
     }
 
 protected:
@@ -88,6 +98,11 @@ protected:
     {
         modules_.push_back(module_t("fake_exe", 0, decode_buf_, 0, MAX_DECODE_SIZE,
                                     MAX_DECODE_SIZE, true));
+        if (gencode_pc_ != nullptr) {
+            gencode_index_[gencode_offs_] = modules_.size();
+            modules_.push_back(module_t("<gencode>", gencode_pc_, decode_buf_, 0,
+                                        MAX_DECODE_SIZE, MAX_DECODE_SIZE, true));
+        }
         return "";
     }
 
@@ -95,6 +110,9 @@ private:
     static const int MAX_DECODE_SIZE = 1024;
     byte decode_buf_[MAX_DECODE_SIZE];
     std::vector<module_t> modules_;
+    std::map<uint64_t, size_t> gencode_index_;
+    uint64_t gencode_offs_ = 0;
+    app_pc gencode_pc_ = nullptr;
 };
 
 offline_entry_t
@@ -280,12 +298,77 @@ test_branch_delays(void *drcontext)
     return true;
 }
 
+bool
+test_gencode_snapshots(void *drcontext)
+{
+    instrlist_t *ilist = instrlist_create(drcontext);
+    instr_t *nop = XINST_CREATE_nop(drcontext);
+    instr_t *move =
+        XINST_CREATE_move(drcontext, opnd_create_reg(REG1), opnd_create_reg(REG2));
+    instrlist_append(ilist, nop);
+    instrlist_append(ilist, move);
+    size_t offs_move = instr_length(drcontext, nop);
+    const uint64_t file_offs = sizeof(gencode_snapshot_t);
+    app_pc orig_pc = reinterpret_cast<app_pc>(0x10000);
+
+    std::vector<offline_entry_t> raw;
+    raw.push_back(make_header());
+    raw.push_back(make_tid());
+    raw.push_back(make_pid());
+    raw.push_back(make_line_size());
+    raw.push_back(make_timestamp());
+    raw.push_back(make_core());
+    // A block in the generated code, followed by a reference to a snapshot we
+    // do not have, which should be skipped.
+    offline_entry_t block = make_block(file_offs, 2);
+    block.pc.modidx = PC_MODIDX_GENCODE;
+    raw.push_back(block);
+    block.pc.modoffs = file_offs + 4096;
+    block.pc.instr_count = 1;
+    raw.push_back(block);
+    raw.push_back(make_exit());
+    std::ostringstream raw_out;
+    for (const auto &entry : raw) {
+        std::string as_string(reinterpret_cast<const char *>(&entry),
+                              reinterpret_cast<const char *>(&entry + 1));
+        raw_out << as_string;
+    }
+    std::istringstream raw_in(raw_out.str());
+    std::vector<std::istream *> input;
+    input.push_back(&raw_in);
+    std::ostringstream result_stream;
+    std::vector<std::ostream *> output;
+    output.push_back(&result_stream);
+
+    raw2trace_test_t raw2trace(input, output, *ilist, drcontext);
+    raw2trace.add_gencode_snapshot(file_offs, orig_pc);
+    std::string error = raw2trace.do_conversion();
+    CHECK(error.empty(), error);
+    instrlist_clear_and_destroy(drcontext, ilist);
+
+    std::string result = result_stream.str();
+    CHECK(result.size() % sizeof(trace_entry_t) == 0,
+          "output is not a multiple of trace_entry_t");
+    std::vector<trace_entry_t> instrs;
+    for (size_t pos = 0; pos < result.size(); pos += sizeof(trace_entry_t)) {
+        trace_entry_t entry = *reinterpret_cast<trace_entry_t *>(&result[pos]);
+        if (type_is_instr(static_cast<trace_type_t>(entry.type)))
+            instrs.push_back(entry);
+    }
+    CHECK(instrs.size() == 2, "expected exactly the two snapshot instrs");
+    CHECK(instrs[0].addr == reinterpret_cast<addr_t>(orig_pc),
+          "first instr has the wrong pc");
+    CHECK(instrs[1].addr == reinterpret_cast<addr_t>(orig_pc + offs_move),
+          "second instr has the wrong pc");
+    return true;
+}
+
 int
 main(int argc, const char *argv[])
 {
 
     void *drcontext = dr_standalone_init();
-    if (!test_branch_delays(drcontext))
+    if (!test_branch_delays(drcontext) || !test_gencode_snapshots(drcontext))
         return 1;
     return 0;
 }
@@ -0,0 +1,244 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "miss_ratio_curve.h"
+#include "../common/utils.h"
+
+const std::string miss_ratio_curve_t::TOOL_NAME = "Miss ratio curve tool";
+
+// Marks an empty slot in a set's stack.
+static const addr_t NO_LINE = static_cast<addr_t>(-1);
+
+analysis_tool_t *
+miss_ratio_curve_tool_create(const miss_ratio_curve_knobs_t &knobs)
+{
+    return new miss_ratio_curve_t(knobs);
+}
+
+miss_ratio_curve_t::stream_data_t::stream_data_t(uint64_t max_lines, uint64_t skip_dist)
+    : ref_list(new line_ref_list_t(max_lines, skip_dist, false))
+    , hits_at_distance(max_lines, 0)
+{
+}
+
+miss_ratio_curve_t::miss_ratio_curve_t(const miss_ratio_curve_knobs_t &knobs)
+    : knobs_(knobs)
+    , line_size_bits_(0)
+{
+    if (!IS_POWER_OF_2(knobs_.line_size) || !IS_POWER_OF_2(knobs_.min_size) ||
+        !IS_POWER_OF_2(knobs_.max_size) || !IS_POWER_OF_2(knobs_.max_assoc) ||
+        knobs_.min_size < knobs_.line_size || knobs_.min_size > knobs_.max_size) {
+        error_string_ = "Usage error: the line size, cache sizes, and maximum "
+                        "associativity must be powers of 2, with the minimum size "
+                        "between the line size and the maximum size.";
+        success_ = false;
+        return;
+    }
+    line_size_bits_ = compute_log2(static_cast<int>(knobs_.line_size));
+    uint64_t max_lines = knobs_.max_size >> line_size_bits_;
+    uint64_t min_sets =
+        std::max<uint64_t>(1, (knobs_.min_size >> line_size_bits_) / knobs_.max_assoc);
+    for (int i = 0; i < STREAM_COUNT; ++i) {
+        std::unique_ptr<stream_data_t> stream(
+            new stream_data_t(max_lines, knobs_.skip_list_distance));
+        // Each set count needs as many ways as its largest cache has.
+        for (uint64_t num_sets = min_sets; num_sets <= max_lines; num_sets *= 2) {
+            set_stacks_t stacks;
+            stacks.num_sets = num_sets;
+            stacks.depth = static_cast<unsigned int>(
+                std::min<uint64_t>(knobs_.max_assoc, max_lines / num_sets));
+            stacks.tags.assign(num_sets * stacks.depth, NO_LINE);
+            stacks.hits_at_depth.assign(stacks.depth, 0);
+            stream->set_stacks.push_back(std::move(stacks));
+        }
+        streams_.push_back(std::move(stream));
+    }
+    if (knobs_.verbose >= 1) {
+        std::cerr << "Miss ratio curves for sizes " << knobs_.min_size << " to "
+                  << knobs_.max_size << " with up to " << knobs_.max_assoc
+                  << " ways using " << streams_[0]->set_stacks.size()
+                  << " set counts\n";
+    }
+}
+
+void
+miss_ratio_curve_t::access_line(stream_data_t &stream, addr_t tag)
+{
+    ++stream.accesses;
+    for (set_stacks_t &stacks : stream.set_stacks) {
+        addr_t *set = &stacks.tags[(tag & (stacks.num_sets - 1)) * stacks.depth];
+        unsigned int depth = 0;
+        while (depth < stacks.depth && set[depth] != tag)
+            ++depth;
+        if (depth < stacks.depth)
+            ++stacks.hits_at_depth[depth];
+        else
+            depth = stacks.depth - 1; // Drop the least recently used line.
+        for (; depth > 0; --depth)
+            set[depth] = set[depth - 1];
+        set[0] = tag;
+    }
+    auto it = stream.line_map.find(tag);
+    if (it == stream.line_map.end()) {
+        line_ref_t *ref = new line_ref_t(tag);
+        stream.line_map.insert(std::make_pair(tag, ref));
+        stream.ref_list->add_to_front(ref);
+    } else {
+        int_least64_t dist = stream.ref_list->move_to_front(it->second);
+        if (static_cast<uint64_t>(dist) < stream.hits_at_distance.size())
+            ++stream.hits_at_distance[dist];
+    }
+}
+
+void
+miss_ratio_curve_t::access(stream_data_t &stream, const memref_t &memref)
+{
+    // Like the cache simulator, we treat each line touched by a reference as
+    // a separate access.
+    addr_t final_addr =
+        memref.data.addr + (memref.data.size == 0 ? 0 : memref.data.size - 1);
+    addr_t final_tag = final_addr >> line_size_bits_;
+    for (addr_t tag = memref.data.addr >> line_size_bits_; tag <= final_tag; ++tag)
+        access_line(stream, tag);
+}
+
+bool
+miss_ratio_curve_t::process_memref(const memref_t &memref)
+{
+    // We model caches shared by all threads, so this tool is serial-only.
+    if (type_is_instr(memref.instr.type) ||
+        memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
+        access(*streams_[STREAM_INSTRUCTION], memref);
+        access(*streams_[STREAM_UNIFIED], memref);
+    } else if (memref.data.type == TRACE_TYPE_READ ||
+               memref.data.type == TRACE_TYPE_WRITE ||
+               type_is_prefetch(memref.data.type)) {
+        access(*streams_[STREAM_DATA], memref);
+        access(*streams_[STREAM_UNIFIED], memref);
+    }
+    return true;
+}
+
+int_least64_t
+miss_ratio_curve_t::get_accesses(stream_t stream) const
+{
+    return streams_[stream]->accesses;
+}
+
+int_least64_t
+miss_ratio_curve_t::get_misses(stream_t stream, uint64_t total_size,
+                               unsigned int assoc) const
+{
+    if (!IS_POWER_OF_2(total_size) || total_size < knobs_.min_size ||
+        total_size > knobs_.max_size ||
+        (assoc != 0 && (!IS_POWER_OF_2(assoc) || assoc > knobs_.max_assoc)))
+        return -1;
+    const stream_data_t &data = *streams_[stream];
+    uint64_t lines = total_size >> line_size_bits_;
+    int_least64_t hits = 0;
+    if (assoc == 0) {
+        for (uint64_t dist = 0; dist < lines; ++dist)
+            hits += data.hits_at_distance[dist];
+        return data.accesses - hits;
+    }
+    if (assoc > lines)
+        return -1;
+    for (const set_stacks_t &stacks : data.set_stacks) {
+        if (stacks.num_sets != lines / assoc)
+            continue;
+        for (unsigned int depth = 0; depth < assoc; ++depth)
+            hits += stacks.hits_at_depth[depth];
+        return data.accesses - hits;
+    }
+    return -1;
+}
+
+static std::string
+size_string(uint64_t size)
+{
+    std::ostringstream str;
+    if (size >= 1024 * 1024 * 1024 && size % (1024 * 1024 * 1024) == 0)
+        str << size / (1024 * 1024 * 1024) << "G";
+    else if (size >= 1024 * 1024 && size % (1024 * 1024) == 0)
+        str << size / (1024 * 1024) << "M";
+    else if (size >= 1024 && size % 1024 == 0)
+        str << size / 1024 << "K";
+    else
+        str << size;
+    return str.str();
+}
+
+void
+miss_ratio_curve_t::print_stream(stream_t which, const std::string &name) const
+{
+    const stream_data_t &stream = *streams_[which];
+    std::cerr << name << " accesses: " << stream.accesses
+              << ", unique lines: " << stream.ref_list->unique_lines_ << "\n";
+    if (stream.accesses == 0)
+        return;
+    std::cerr << std::setw(10) << "Size";
+    for (unsigned int assoc = 1; assoc <= knobs_.max_assoc; assoc *= 2)
+        std::cerr << std::setw(10) << std::to_string(assoc) + "-way";
+    std::cerr << std::setw(10) << "fully"
+              << "\n";
+    std::cerr << std::fixed << std::setprecision(2);
+    for (uint64_t size = knobs_.min_size; size <= knobs_.max_size; size *= 2) {
+        std::cerr << std::setw(10) << size_string(size);
+        for (unsigned int assoc = 1; assoc <= knobs_.max_assoc; assoc *= 2) {
+            int_least64_t misses = get_misses(which, size, assoc);
+            if (misses < 0) {
+                std::cerr << std::setw(10) << "-";
+                continue;
+            }
+            std::cerr << std::setw(9) << 100. * misses / stream.accesses << "%";
+        }
+        std::cerr << std::setw(9)
+                  << 100. * get_misses(which, size, 0) / stream.accesses << "%\n";
+    }
+    std::cerr.unsetf(std::ios::fixed);
+}
+
+bool
+miss_ratio_curve_t::print_results()
+{
+    std::cerr << TOOL_NAME << " results:\n";
+    std::cerr << "LRU miss ratios for " << knobs_.line_size << "-byte lines\n";
+    print_stream(STREAM_INSTRUCTION, "Instruction");
+    print_stream(STREAM_DATA, "Data");
+    print_stream(STREAM_UNIFIED, "Unified");
+    return true;
+}
@@ -0,0 +1,118 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* miss-ratio-curve: a single-pass simulation of many LRU cache configurations.
+ */
+
+#ifndef _MISS_RATIO_CURVE_H_
+#define _MISS_RATIO_CURVE_H_ 1
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "analysis_tool.h"
+#include "miss_ratio_curve_create.h"
+#include "reuse_distance.h"
+#include "memref.h"
+
+// LRU obeys the inclusion property: a cache with the same number of sets and
+// more ways always holds a superset of the lines of a smaller one.  Thus one LRU
+// stack per set yields the hits of every associativity at once, and a single
+// pass over the trace with one set of stacks per set count (Hill and Smith's
+// all-associativity simulation) covers every power-of-two size and
+// associativity.  Fully associative caches use the global stack distance from
+// the reuse distance tool's line_ref_list_t.
+class miss_ratio_curve_t : public analysis_tool_t {
+public:
+    // The instruction and data streams model first-level caches.  The unified
+    // stream models one cache for both which sees every reference, i.e., without
+    // the filtering of a level in front of it.
+    enum stream_t {
+        STREAM_INSTRUCTION,
+        STREAM_DATA,
+        STREAM_UNIFIED,
+        STREAM_COUNT,
+    };
+
+    explicit miss_ratio_curve_t(const miss_ratio_curve_knobs_t &knobs);
+    bool
+    process_memref(const memref_t &memref) override;
+    bool
+    print_results() override;
+
+    int_least64_t
+    get_accesses(stream_t stream) const;
+    // Returns the misses an LRU cache of total_size bytes with the given
+    // associativity would have had on "stream" so far, where an associativity
+    // of 0 asks for a fully associative cache.  Returns -1 if the configuration
+    // is outside the knob ranges.
+    int_least64_t
+    get_misses(stream_t stream, uint64_t total_size, unsigned int assoc) const;
+
+protected:
+    // The LRU stacks, most recent line first, of every set for one set count.
+    // They are truncated to the largest associativity simulated with this many
+    // sets: a line found at depth d hits in every cache with more than d ways.
+    struct set_stacks_t {
+        uint64_t num_sets;
+        unsigned int depth;
+        std::vector<addr_t> tags;
+        std::vector<int_least64_t> hits_at_depth;
+    };
+
+    struct stream_data_t {
+        stream_data_t(uint64_t max_lines, uint64_t skip_dist);
+        std::vector<set_stacks_t> set_stacks;
+        // The nodes are owned by ref_list.
+        std::unordered_map<addr_t, line_ref_t *> line_map;
+        std::unique_ptr<line_ref_list_t> ref_list;
+        // The fully associative hits by stack distance, up to the largest size.
+        std::vector<int_least64_t> hits_at_distance;
+        int_least64_t accesses = 0;
+    };
+
+    void
+    access_line(stream_data_t &stream, addr_t tag);
+    void
+    access(stream_data_t &stream, const memref_t &memref);
+    void
+    print_stream(stream_t which, const std::string &name) const;
+
+    const miss_ratio_curve_knobs_t knobs_;
+    int line_size_bits_;
+    std::vector<std::unique_ptr<stream_data_t>> streams_;
+    static const std::string TOOL_NAME;
+};
+
+#endif /* _MISS_RATIO_CURVE_H_ */
@@ -0,0 +1,78 @@
+/* **********************************************************
+ * Copyright (c) 2022 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* miss-ratio-curve tool creation */
+
+#ifndef _MISS_RATIO_CURVE_CREATE_H_
+#define _MISS_RATIO_CURVE_CREATE_H_ 1
+
+#include <stdint.h>
+#include "analysis_tool.h"
+
+/**
+ * @file drmemtrace/miss_ratio_curve_create.h
+ * @brief DrMemtrace miss ratio curve tool creation.
+ */
+
+/**
+ * The options for miss_ratio_curve_tool_create().
+ * The options are currently documented in \ref sec_drcachesim_ops.
+ */
+// These options are currently documented in ../common/options.cpp.
+struct miss_ratio_curve_knobs_t {
+    miss_ratio_curve_knobs_t()
+        : line_size(64)
+        , min_size(1024)
+        , max_size(8 * 1024 * 1024)
+        , max_assoc(16)
+        , skip_list_distance(500)
+        , verbose(0)
+    {
+    }
+    unsigned int line_size;
+    uint64_t min_size;
+    uint64_t max_size;
+    unsigned int max_assoc;
+    unsigned int skip_list_distance;
+    unsigned int verbose;
+};
+
+/**
+ * Creates an analysis tool which computes, in a single pass, the miss ratios of
+ * LRU caches of every power-of-two size and associativity in the ranges given
+ * by the knobs.
+ */
+analysis_tool_t *
+miss_ratio_curve_tool_create(const miss_ratio_curve_knobs_t &knobs);
+
+#endif /* _MISS_RATIO_CURVE_CREATE_H_ */
@@ -297,6 +297,16 @@ drmemtrace_status_t
 drmemtrace_get_timestamp_from_offline_trace(const void *trace, size_t trace_size,
                                             OUT uint64 *timestamp);
 
+/**
+ * Triggers a dump of the in-memory trace history kept under the -flight_recorder
+ * option.  Each thread writes its history to its trace file on its next buffer
+ * flush or at its exit.  This may be called from any thread, including from an
+ * application that links drmemtrace statically.  Returns
+ * DRMEMTRACE_ERROR_NOT_IMPLEMENTED if -flight_recorder is not enabled.
+ */
+drmemtrace_status_t
+drmemtrace_flight_recorder_dump(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -88,6 +88,9 @@ typedef struct {
     int id;
     int arg_num;
     bool noret;
+    // Whether the entry markers are written by inlined instrumentation
+    // (-record_inline_entry) rather than by func_pre_hook.
+    bool inline_entry;
 } func_metadata_t;
 
 static func_metadata_t *
@@ -98,9 +101,50 @@ create_func_metadata(const char *name, int id, int arg_num, bool noret)
     f->id = id;
     f->arg_num = arg_num;
     f->noret = noret;
+    f->inline_entry = false;
     return f;
 }
 
+#ifdef X64
+// The registers holding the leading arguments at function entry under the
+// default calling convention, which is what drwrap_get_arg() assumes as well.
+static const reg_id_t arg_regs[] = {
+#    ifdef X86
+#        ifdef WINDOWS
+    DR_REG_RCX, DR_REG_RDX, DR_REG_R8, DR_REG_R9,
+#        else
+    DR_REG_RDI, DR_REG_RSI, DR_REG_RDX, DR_REG_RCX, DR_REG_R8, DR_REG_R9,
+#        endif
+#    elif defined(AARCH64)
+    DR_REG_X0, DR_REG_X1, DR_REG_X2, DR_REG_X3,
+    DR_REG_X4, DR_REG_X5, DR_REG_X6, DR_REG_X7,
+#    endif
+};
+#endif
+
+// Returns whether the entry markers for f can be written by inlined
+// instrumentation.
+static bool
+can_inline_entry(const func_metadata_t *f)
+{
+#ifdef X64
+    // The inlined markers are only written by the offline instrumentation:
+    // see instrument_func_entry() in tracer.cpp.
+    if (!op_record_inline_entry.get_value() || !op_offline.get_value())
+        return false;
+    if (f->arg_num > static_cast<int>(BUFFER_SIZE_ELEMENTS(arg_regs)))
+        return false;
+    // With retaddr replacement, drwrap's entry clean call, which executes prior
+    // to our inlined code, clobbers the return address we want to record.
+    if (!f->noret && op_record_replace_retaddr.get_value())
+        return false;
+    return true;
+#else
+    // 32-bit calling conventions pass arguments on the stack.
+    return false;
+#endif
+}
+
 static void
 delete_func_metadata(func_metadata_t *f)
 {
@@ -256,8 +300,10 @@ instru_funcs_module_load(void *drcontext, const module_data_t *mod, bool loaded)
                    f->name, id, f_traced->arg_num);
         } else {
             id = wrap_id++;
-            drvector_append(&funcs_wrapped,
-                            create_func_metadata(f->name, id, f->arg_num, f->noret));
+            func_metadata_t *f_traced =
+                create_func_metadata(f->name, id, f->arg_num, f->noret);
+            f_traced->inline_entry = can_inline_entry(f_traced);
+            drvector_append(&funcs_wrapped, f_traced);
             if (!hashtable_add(&pc2idplus1, (void *)f_pc, (void *)(ptr_int_t)(id + 1)))
                 DR_ASSERT(false && "Failed to maintain pc2idplus1 internal hashtable");
         }
@@ -271,6 +317,23 @@ instru_funcs_module_load(void *drcontext, const module_data_t *mod, bool loaded)
         uint flags = 0;
         if (!f->noret && op_record_replace_retaddr.get_value())
             flags = DRWRAP_REPLACE_RETADDR;
+        if (can_inline_entry(f)) {
+            // We only need drwrap for the return value.
+            if (f->noret) {
+                NOTIFY(1, "Inlined entry for %s!%s @%p == id %d\n", mod_name, f->name,
+                       f_pc, id);
+                continue;
+            }
+            if (drwrap_wrap_ex(f_pc, nullptr, func_post_hook, (void *)(ptr_uint_t)id,
+                               flags)) {
+                NOTIFY(1, "Inserted post hook and inlined entry for %s!%s @%p == id %d\n",
+                       mod_name, f->name, f_pc, id);
+            } else {
+                NOTIFY(0, "Failed to insert post hook for %s!%s == id %d\n", mod_name,
+                       f->name, id);
+            }
+            continue;
+        }
         if (drwrap_wrap_ex(f_pc, func_pre_hook, f->noret ? nullptr : func_post_hook,
                            (void *)(ptr_uint_t)id, flags)) {
             NOTIFY(1, "Inserted hooks for %s!%s @%p == id %d\n", mod_name, f->name, f_pc,
@@ -327,8 +390,14 @@ instru_funcs_module_unload(void *drcontext, const module_data_t *mod)
         // To support a different library with a to-trace symbol being mapped at the
         // same pc, we remove from pc2idplus1.  If the same library is re-loaded, we'll
         // give a new id to the same symbol in the new incarnation.
+        dr_mutex_lock(funcs_wrapped_lock);
         hashtable_remove(&pc2idplus1, (void *)f_pc);
-        if (drwrap_unwrap(f_pc, func_pre_hook, f->noret ? nullptr : func_post_hook)) {
+        dr_mutex_unlock(funcs_wrapped_lock);
+        bool inline_entry = can_inline_entry(f);
+        if (inline_entry && f->noret)
+            continue; // Never wrapped.
+        if (drwrap_unwrap(f_pc, inline_entry ? nullptr : func_pre_hook,
+                          f->noret ? nullptr : func_post_hook)) {
             NOTIFY(1, "Removed hooks for %s!%s @%p\n", mod_name, f->name, f_pc);
         } else {
             NOTIFY(0, "Failed to remove hooks for %s!%s @%p\n", mod_name, f->name, f_pc);
@@ -336,6 +405,39 @@ instru_funcs_module_unload(void *drcontext, const module_data_t *mod)
     }
 }
 
+bool
+func_trace_inline_entry(app_pc pc, OUT int *id, OUT int *arg_num)
+{
+    if (funcs_str.empty() || !op_record_inline_entry.get_value() ||
+        !op_offline.get_value())
+        return false;
+    bool res = false;
+    dr_mutex_lock(funcs_wrapped_lock);
+    int idplus1 = (int)(ptr_int_t)hashtable_lookup(&pc2idplus1, (void *)pc);
+    if (idplus1 != 0) {
+        func_metadata_t *f =
+            (func_metadata_t *)drvector_get_entry(&funcs_wrapped, (uint)idplus1 - 1);
+        if (f->inline_entry) {
+            *id = f->id;
+            *arg_num = f->arg_num;
+            res = true;
+        }
+    }
+    dr_mutex_unlock(funcs_wrapped_lock);
+    return res;
+}
+
+reg_id_t
+func_trace_get_arg_reg(int arg)
+{
+#ifdef X64
+    DR_ASSERT(arg >= 0 && arg < static_cast<int>(BUFFER_SIZE_ELEMENTS(arg_regs)));
+    return arg_regs[arg];
+#else
+    return DR_REG_NULL;
+#endif
+}
+
 dr_emit_flags_t
 func_trace_enabled_instrument_event(void *drcontext, void *tag, instrlist_t *bb,
                                     instr_t *instr, instr_t *where, bool for_trace,
@@ -74,6 +74,19 @@ func_trace_init(func_trace_append_entry_vec_t append_entry_vec_,
 void
 func_trace_exit();
 
+// Returns whether the entry markers (#TRACE_MARKER_TYPE_FUNC_ID,
+// #TRACE_MARKER_TYPE_FUNC_RETADDR, and #TRACE_MARKER_TYPE_FUNC_ARG) for a
+// traced function starting at "pc" should be written by the caller's inlined
+// instrumentation rather than by a callback (-record_inline_entry).  If so,
+// returns the function's id and the number of arguments to record.
+bool
+func_trace_inline_entry(app_pc pc, OUT int *id, OUT int *arg_num);
+
+// Returns the register holding argument number "arg" at the entry to a
+// function for which func_trace_inline_entry() returned true.
+reg_id_t
+func_trace_get_arg_reg(int arg);
+
 // Needed for DRWRAP_INVERT_CONTROL.
 dr_emit_flags_t
 func_trace_enabled_instrument_event(void *drcontext, void *tag, instrlist_t *bb,
@@ -422,6 +422,27 @@ public:
     bb_analysis(void *drcontext, void *tag, void **bb_field, instrlist_t *ilist,
                 bool repstr_expanded) override;
 
+    // These insert inlined code to add a marker entry into the trace buffer at
+    // reg_ptr+adjust and return the updated adjust value.  The first stores the
+    // constant "value", using "scratch" as a temporary.  The second stores the
+    // pointer-sized value held in "reg_val", which is clobbered.  Values that
+    // might not fit in one entry are always split across two entries.
+    int
+    insert_save_marker(void *drcontext, instrlist_t *ilist, instr_t *where,
+                       reg_id_t reg_ptr, reg_id_t scratch, int adjust,
+                       trace_marker_type_t type, uintptr_t value);
+    int
+    insert_save_marker_from_reg(void *drcontext, instrlist_t *ilist, instr_t *where,
+                                reg_id_t reg_ptr, int adjust, trace_marker_type_t type,
+                                reg_id_t reg_val);
+
+    // Enables -record_gencode: the bytes of blocks outside of modules are written
+    // to "gencode_file" and their PC entries refer to those snapshots.  If
+    // snapshots were already taken (i.e., prior to a fork) they are re-written to
+    // the new file so that the offsets already encoded in the code cache stay valid.
+    void
+    set_gencode_file(file_t gencode_file);
+
     static bool
     custom_module_data(void *(*load_cb)(module_data_t *module, int seg_idx),
                        int (*print_cb)(void *data, char *dst, size_t max_len),
@@ -477,6 +498,19 @@ private:
     ssize_t (*write_file_func_)(file_t file, const void *data, size_t count);
     file_t modfile_;
 
+    // State for -record_gencode, which is only allocated when it is enabled, as
+    // we need to keep the size of this class small.
+    struct gencode_record_t;
+    struct gencode_state_t;
+    gencode_state_t *gencode_;
+
+    void
+    record_gencode(void *drcontext, app_pc start, int instr_count);
+    bool
+    lookup_gencode(app_pc start, OUT uint64_t *offset);
+    bool
+    write_gencode_record(gencode_record_t *record);
+
     void
     opnd_check_elidable(void *drcontext, instrlist_t *ilist, instr_t *instr, opnd_t memop,
                         int op_index, int memop_index, bool write, int version,
@@ -38,6 +38,7 @@
 #include "drreg.h"
 #include "drutil.h"
 #include "drcovlib.h"
+#include "hashtable.h"
 #include "instru.h"
 #include "../common/trace_entry.h"
 #include <new>
@@ -51,12 +52,40 @@ void *(*offline_instru_t::user_load_)(module_data_t *module, int seg_idx);
 int (*offline_instru_t::user_print_)(void *data, char *dst, size_t max_len);
 void (*offline_instru_t::user_free_)(void *data);
 
+// A snapshot of the code of one basic block for -record_gencode.
+struct offline_instru_t::gencode_record_t {
+    app_pc pc;
+    uint64_t hash;
+    size_t size;
+    byte *bytes;
+    // The offset of the code bytes (not the header) in the gencode file.
+    uint64_t offset;
+    // An older snapshot of different code at the same address.
+    gencode_record_t *older;
+    // The next snapshot in file order.
+    gencode_record_t *next;
+};
+
+struct offline_instru_t::gencode_state_t {
+    // Maps a block start address to the gencode_record_t for the code most
+    // recently seen there.
+    hashtable_t table;
+    void *lock;
+    file_t file;
+    uint64_t file_size;
+    gencode_record_t *first;
+    gencode_record_t *last;
+};
+
+#define GENCODE_TABLE_HASH_BITS 10
+
 // This constructor is for use in post-processing when we just need the
 // elision utility functions.
 offline_instru_t::offline_instru_t()
     : instru_t(nullptr, false, nullptr, sizeof(offline_entry_t))
     , write_file_func_(nullptr)
     , modfile_(INVALID_FILE)
+    , gencode_(nullptr)
 {
     // We can't use drmgr in standalone mode, but for post-processing it's just us,
     // so we just pick a note value.
@@ -74,6 +103,7 @@ offline_instru_t::offline_instru_t(void (*insert_load_buf)(void *, instrlist_t *
                disable_optimizations)
     , write_file_func_(write_file)
     , modfile_(module_file)
+    , gencode_(nullptr)
 {
     drcovlib_status_t res = drmodtrack_init();
     DR_ASSERT(res == DRCOVLIB_SUCCESS);
@@ -111,6 +141,18 @@ offline_instru_t::~offline_instru_t()
     } while (res == DRCOVLIB_ERROR_BUF_TOO_SMALL);
     res = drmodtrack_exit();
     DR_ASSERT(res == DRCOVLIB_SUCCESS);
+    if (gencode_ != nullptr) {
+        gencode_record_t *next;
+        for (gencode_record_t *record = gencode_->first; record != nullptr;
+             record = next) {
+            next = record->next;
+            dr_global_free(record->bytes, record->size);
+            dr_global_free(record, sizeof(*record));
+        }
+        hashtable_delete(&gencode_->table);
+        dr_mutex_destroy(gencode_->lock);
+        dr_global_free(gencode_, sizeof(*gencode_));
+    }
     drmgr_exit();
 }
 
@@ -403,6 +445,201 @@ offline_instru_t::insert_save_entry(void *drcontext, instrlist_t *ilist, instr_t
     return sizeof(offline_entry_t);
 }
 
+int
+offline_instru_t::insert_save_marker(void *drcontext, instrlist_t *ilist, instr_t *where,
+                                     reg_id_t reg_ptr, reg_id_t scratch, int adjust,
+                                     trace_marker_type_t type, uintptr_t value)
+{
+    // We construct the entries up front and store them as constants.
+    offline_entry_t entries[2];
+    int size = append_marker(reinterpret_cast<byte *>(entries), type, value);
+    for (int i = 0; i < size / static_cast<int>(sizeof(offline_entry_t)); ++i) {
+        adjust += insert_save_entry(drcontext, ilist, where, reg_ptr, scratch, adjust,
+                                    &entries[i]);
+    }
+    return adjust;
+}
+
+int
+offline_instru_t::insert_save_marker_from_reg(void *drcontext, instrlist_t *ilist,
+                                              instr_t *where, reg_id_t reg_ptr,
+                                              int adjust, trace_marker_type_t type,
+                                              reg_id_t reg_val)
+{
+    // We fill in the value and the type fields with separate 32-bit stores, which
+    // avoids needing a second scratch register or clobbering the arithmetic flags
+    // to shift and combine them.
+    reg_id_t reg_val32 = reg_resize_to_opsz(reg_val, OPSZ_4);
+    offline_entry_t header;
+    header.extended.type = OFFLINE_TYPE_EXTENDED;
+    header.extended.ext = OFFLINE_EXT_TYPE_MARKER;
+    header.extended.valueA = 0;
+#ifdef X64
+    // A 64-bit value needs a TRACE_MARKER_TYPE_SPLIT_VALUE entry holding the top
+    // half followed by the regular marker entry holding the bottom half.
+    // Rather than shifting, we store the whole value into the second entry and
+    // read its top half back out.
+    int disp_top = adjust;
+    int disp_bottom = adjust + sizeof(offline_entry_t);
+    MINSERT(ilist, where,
+            XINST_CREATE_store(drcontext, OPND_CREATE_MEMPTR(reg_ptr, disp_bottom),
+                               opnd_create_reg(reg_val)));
+    MINSERT(ilist, where,
+            XINST_CREATE_load(drcontext, opnd_create_reg(reg_val32),
+                              OPND_CREATE_MEM32(reg_ptr, disp_bottom + 4)));
+    MINSERT(ilist, where,
+            XINST_CREATE_store(drcontext, OPND_CREATE_MEM32(reg_ptr, disp_top),
+                               opnd_create_reg(reg_val32)));
+    header.extended.valueB = TRACE_MARKER_TYPE_SPLIT_VALUE;
+    instrlist_insert_mov_immed_ptrsz(drcontext,
+                                     static_cast<ptr_int_t>(header.combined_value >> 32),
+                                     opnd_create_reg(reg_val), ilist, where, NULL, NULL);
+    MINSERT(ilist, where,
+            XINST_CREATE_store(drcontext, OPND_CREATE_MEM32(reg_ptr, disp_top + 4),
+                               opnd_create_reg(reg_val32)));
+    adjust = disp_bottom;
+#else
+    MINSERT(ilist, where,
+            XINST_CREATE_store(drcontext, OPND_CREATE_MEM32(reg_ptr, adjust),
+                               opnd_create_reg(reg_val32)));
+#endif
+    DR_ASSERT((uint)type < 1 << EXT_VALUE_B_BITS);
+    header.extended.valueB = type;
+    instrlist_insert_mov_immed_ptrsz(drcontext,
+                                     static_cast<ptr_int_t>(header.combined_value >> 32),
+                                     opnd_create_reg(reg_val), ilist, where, NULL, NULL);
+    MINSERT(ilist, where,
+            XINST_CREATE_store(drcontext, OPND_CREATE_MEM32(reg_ptr, adjust + 4),
+                               opnd_create_reg(reg_val32)));
+    return adjust + sizeof(offline_entry_t);
+}
+
+void
+offline_instru_t::set_gencode_file(file_t gencode_file)
+{
+    if (gencode_ == nullptr) {
+        gencode_ = (gencode_state_t *)dr_global_alloc(sizeof(*gencode_));
+        hashtable_init_ex(&gencode_->table, GENCODE_TABLE_HASH_BITS, HASH_INTPTR,
+                          false /*!strdup*/, false /*!synch*/, nullptr, nullptr, nullptr);
+        gencode_->lock = dr_mutex_create();
+        gencode_->first = nullptr;
+        gencode_->last = nullptr;
+    }
+    dr_mutex_lock(gencode_->lock);
+    gencode_->file = gencode_file;
+    gencode_->file_size = 0;
+    for (gencode_record_t *record = gencode_->first; record != nullptr;
+         record = record->next) {
+        if (!write_gencode_record(record))
+            break;
+    }
+    dr_mutex_unlock(gencode_->lock);
+}
+
+// The caller must hold gencode_->lock.
+bool
+offline_instru_t::write_gencode_record(gencode_record_t *record)
+{
+    DR_ASSERT(record->offset == gencode_->file_size + sizeof(gencode_snapshot_t));
+    gencode_snapshot_t header;
+    header.orig_pc = reinterpret_cast<uint64_t>(record->pc);
+    header.hash = record->hash;
+    header.size = record->size;
+    if (write_file_func_(gencode_->file, &header, sizeof(header)) !=
+            (ssize_t)sizeof(header) ||
+        write_file_func_(gencode_->file, record->bytes, record->size) !=
+            (ssize_t)record->size)
+        return false;
+    gencode_->file_size += sizeof(header) + record->size;
+    return true;
+}
+
+void
+offline_instru_t::record_gencode(void *drcontext, app_pc start, int instr_count)
+{
+    // Post-processing decodes instr_count instructions sequentially from the
+    // start, so that is the range we need.
+    app_pc end = start;
+    for (int i = 0; i < instr_count && end != nullptr; ++i)
+        end = decode_next_pc(drcontext, end);
+    if (end == nullptr || end == start)
+        return;
+    size_t size = end - start;
+    byte *bytes = (byte *)dr_global_alloc(size);
+    size_t read;
+    if (!dr_safe_read(start, size, bytes, &read) || read != size) {
+        dr_global_free(bytes, size);
+        return;
+    }
+    // FNV-1a.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    dr_mutex_lock(gencode_->lock);
+    gencode_record_t *head =
+        (gencode_record_t *)hashtable_lookup(&gencode_->table, start);
+    gencode_record_t *record = head, *prev = nullptr;
+    while (record != nullptr &&
+           (record->hash != hash || record->size != size ||
+            memcmp(record->bytes, bytes, size) != 0)) {
+        prev = record;
+        record = record->older;
+    }
+    if (record != nullptr) {
+        dr_global_free(bytes, size);
+        if (record != head) {
+            // The code was changed back to an earlier version: make that the
+            // current one.
+            prev->older = record->older;
+            record->older = head;
+            hashtable_add_replace(&gencode_->table, start, record);
+        }
+        dr_mutex_unlock(gencode_->lock);
+        return;
+    }
+    uint64_t offset = gencode_->file_size + sizeof(gencode_snapshot_t);
+    if (offset + size >= uint64_t(1) << PC_MODOFFS_BITS) {
+        // We can no longer encode offsets into the file: leave the block undecodable.
+        dr_global_free(bytes, size);
+        dr_mutex_unlock(gencode_->lock);
+        return;
+    }
+    record = (gencode_record_t *)dr_global_alloc(sizeof(*record));
+    record->pc = start;
+    record->hash = hash;
+    record->size = size;
+    record->bytes = bytes;
+    record->offset = offset;
+    record->older = head;
+    record->next = nullptr;
+    if (!write_gencode_record(record)) {
+        dr_global_free(bytes, size);
+        dr_global_free(record, sizeof(*record));
+        dr_mutex_unlock(gencode_->lock);
+        return;
+    }
+    if (gencode_->last == nullptr)
+        gencode_->first = record;
+    else
+        gencode_->last->next = record;
+    gencode_->last = record;
+    hashtable_add_replace(&gencode_->table, start, record);
+    dr_mutex_unlock(gencode_->lock);
+}
+
+bool
+offline_instru_t::lookup_gencode(app_pc start, OUT uint64_t *offset)
+{
+    dr_mutex_lock(gencode_->lock);
+    gencode_record_t *record =
+        (gencode_record_t *)hashtable_lookup(&gencode_->table, start);
+    if (record != nullptr)
+        *offset = record->offset;
+    dr_mutex_unlock(gencode_->lock);
+    return record != nullptr;
+}
+
 uint64_t
 offline_instru_t::get_modoffs(void *drcontext, app_pc pc, OUT uint *modidx)
 {
@@ -419,19 +656,29 @@ offline_instru_t::insert_save_pc(void *drcontext, instrlist_t *ilist, instr_t *w
 {
     app_pc modbase;
     uint modidx;
+    uint64_t base_offs = 0;
     if (drmodtrack_lookup(drcontext, pc, &modidx, &modbase) != DRCOVLIB_SUCCESS) {
-        // FIXME i#2062: add non-module support.  The plan for instrs is to have
-        // one entry w/ the start abs pc, and subsequent entries that pack the instr
-        // length for 10 instrs, 4 bits each, into a pc.modoffs field.  We will
-        // also need to store the type (read/write/prefetch*) and size for the
-        // memrefs.
-        modidx = 0;
-        modbase = pc;
-    }
+        app_pc block_start = instr_get_app_pc(instrlist_first_app(ilist));
+        if (gencode_ != nullptr && lookup_gencode(block_start, &base_offs)) {
+            // The offset is into the snapshot of this block in the gencode file.
+            modidx = PC_MODIDX_GENCODE;
+            modbase = block_start;
+        } else {
+            // FIXME i#2062: add non-module support.  The plan for instrs is to have
+            // one entry w/ the start abs pc, and subsequent entries that pack the
+            // instr length for 10 instrs, 4 bits each, into a pc.modoffs field.  We
+            // will also need to store the type (read/write/prefetch*) and size for
+            // the memrefs.  For now, -record_gencode covers most such code.
+            modidx = 0;
+            modbase = pc;
+        }
+    } else
+        DR_ASSERT(modidx < PC_MODIDX_GENCODE);
     offline_entry_t entry;
     entry.pc.type = OFFLINE_TYPE_PC;
     // We put the ARM vs Thumb mode into the modoffs to ensure proper decoding.
-    uint64_t modoffs = dr_app_pc_as_jump_target(instr_get_isa_mode(where), pc) - modbase;
+    uint64_t modoffs = base_offs +
+        (dr_app_pc_as_jump_target(instr_get_isa_mode(where), pc) - modbase);
     // Check that the values we want to assign to the bitfields in offline_entry_t do not
     // overflow. In i#2956 we observed an overflow for the modidx field.
     DR_ASSERT(modoffs < uint64_t(1) << PC_MODOFFS_BITS);
@@ -649,6 +896,13 @@ offline_instru_t::bb_analysis(void *drcontext, void *tag, void **bb_field,
                               instrlist_t *ilist, bool repstr_expanded)
 {
     *bb_field = (void *)(ptr_uint_t)instru_t::count_app_instrs(ilist);
+    if (gencode_ != nullptr) {
+        app_pc start = dr_fragment_app_pc(tag);
+        uint modidx;
+        app_pc modbase;
+        if (drmodtrack_lookup(drcontext, start, &modidx, &modbase) != DRCOVLIB_SUCCESS)
+            record_gencode(drcontext, start, (int)(ptr_uint_t)*bb_field);
+    }
     identify_elidable_addresses(drcontext, ilist, OFFLINE_FILE_VERSION);
 }
 
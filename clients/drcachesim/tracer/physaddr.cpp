@@ -35,6 +35,7 @@
 #    include <unistd.h>
 #    include <sys/stat.h>
 #    include <fcntl.h>
+#    include <sys/syscall.h>
 #    include <linux/capability.h>
 #    include <fstream>
 #endif
@@ -57,6 +58,7 @@
 #    define PAGEMAP_SWAP 0x4000000000000000
 #    define PAGEMAP_PFN 0x007fffffffffffff
 std::atomic<bool> physaddr_t::has_privileges_;
+std::atomic<uint64_t> physaddr_t::mapping_generation_;
 #endif
 
 physaddr_t::physaddr_t()
@@ -70,6 +72,8 @@ physaddr_t::physaddr_t()
     , num_hit_cache_(0)
     , num_hit_table_(0)
     , num_miss_(0)
+    , num_batch_reads_(0)
+    , num_invalidations_(0)
 #endif
 {
 #ifdef LINUX
@@ -83,6 +87,7 @@ physaddr_t::physaddr_t()
         temp >>= 1;
     }
     NOTIFY(1, "Page size: %zu; bits: %d\n", page_size_, page_bits_);
+    generation_ = mapping_generation_.load(std::memory_order_acquire);
 #endif
 }
 
@@ -92,8 +97,11 @@ physaddr_t::~physaddr_t()
     if (num_miss_ > 0) {
         NOTIFY(1,
                "physaddr: hit cache: " UINT64_FORMAT_STRING
-               ", hit table " UINT64_FORMAT_STRING ", miss " UINT64_FORMAT_STRING "\n",
-               num_hit_cache_, num_hit_table_, num_miss_);
+               ", hit table " UINT64_FORMAT_STRING ", miss " UINT64_FORMAT_STRING
+               ", batch reads " UINT64_FORMAT_STRING
+               ", invalidations " UINT64_FORMAT_STRING "\n",
+               num_hit_cache_, num_hit_table_, num_miss_, num_batch_reads_,
+               num_invalidations_);
     }
     if (v2p_ != nullptr)
         dr_hashtable_destroy(drcontext_, v2p_);
@@ -131,12 +139,34 @@ physaddr_t::global_init()
         }
     }
     DR_ASSERT(std::atomic_is_lock_free(&has_privileges_));
+    DR_ASSERT(std::atomic_is_lock_free(&mapping_generation_));
     return has_privileges_;
 #else
     return false;
 #endif
 }
 
+bool
+physaddr_t::syscall_changes_mappings(int sysnum)
+{
+#ifdef LINUX
+    // We do not include mmap: a new mapping can only replace pages if it
+    // is MAP_FIXED on top of an existing one, which we treat as rare enough
+    // to leave to -virt2phys_freq.
+    return sysnum == SYS_munmap || sysnum == SYS_mremap || sysnum == SYS_madvise;
+#else
+    return false;
+#endif
+}
+
+void
+physaddr_t::invalidate_all()
+{
+#ifdef LINUX
+    mapping_generation_.fetch_add(1, std::memory_order_release);
+#endif
+}
+
 bool
 physaddr_t::init()
 {
@@ -154,6 +184,7 @@ physaddr_t::init()
     // We record the context so we can pass the same one in our destructor, which
     // might be called from a different thread.
     drcontext_ = dr_get_current_drcontext();
+    generation_ = mapping_generation_.load(std::memory_order_acquire);
     v2p_ = dr_hashtable_create(drcontext_, V2P_INITIAL_BITS, 20,
                                /*synch=*/false, nullptr);
 
@@ -176,6 +207,77 @@ physaddr_t::init()
 #endif
 }
 
+#ifdef LINUX
+void
+physaddr_t::flush_cache(void *drcontext)
+{
+    memset(last_vpage_, static_cast<char>(PAGE_INVALID), sizeof(last_vpage_));
+    // We do not bother to clear last_ppage_ as it is only used when
+    // last_vpage_ holds legitimate values.
+    dr_hashtable_clear(drcontext, v2p_);
+}
+
+bool
+physaddr_t::read_pagemap_batch(void *drcontext, addr_t vpage, OUT addr_t *ppage)
+{
+    // The pagemap file contains one 64-bit int per page.
+    // See the docs at https://www.kernel.org/doc/Documentation/vm/pagemap.txt
+    // For huge pages it's the same: there are just N consecutive entries, with
+    // the first marked COMPOUND_HEAD and the rest COMPOUND_TAIL in the flags,
+    // which we ignore here.
+    // We read an aligned group of entries so that repeated misses in the same
+    // region do not re-read overlapping ranges.
+    addr_t batch_start = ALIGN_BACKWARD(vpage, page_size_ * PAGEMAP_BATCH);
+    if (batch_start + page_size_ * PAGEMAP_BATCH < batch_start) {
+        // Avoid overflow at the very top of the address space.
+        batch_start = vpage;
+    }
+    uint64_t entries[PAGEMAP_BATCH];
+    off64_t offs = batch_start / page_size_ * sizeof(entries[0]);
+    // The read may be cut short at the end of the address space; we only
+    // require the entry for vpage.
+    ssize_t got = pread64(fd_, (char *)entries, sizeof(entries), offs);
+    size_t vpage_idx = (vpage - batch_start) / page_size_;
+    if (got < 0 || static_cast<size_t>(got) < (vpage_idx + 1) * sizeof(entries[0])) {
+        NOTIFY(1, "v2p failure: read at " INT64_FORMAT_STRING " failed for %p\n", offs,
+               vpage);
+        return false;
+    }
+    ++num_batch_reads_;
+    int count = static_cast<int>(got / sizeof(entries[0]));
+    bool success = false;
+    for (int i = 0; i < count; ++i) {
+        addr_t cur_vpage = batch_start + i * page_size_;
+        uint64_t entry = entries[i];
+        NOTIFY(3, "v2p: %p => entry " HEX64_FORMAT_STRING "\n", cur_vpage, entry);
+        if (!TESTALL(PAGEMAP_VALID, entry) || TESTANY(PAGEMAP_SWAP, entry)) {
+            if (cur_vpage == vpage) {
+                NOTIFY(1, "v2p failure: entry %p is invalid for %p in T%d\n", entry,
+                       vpage, dr_get_thread_id(drcontext));
+            }
+            continue;
+        }
+        addr_t cur_ppage = (addr_t)((entry & PAGEMAP_PFN) << page_bits_);
+        // Despite the kernel handing out a 0 PFN for unprivileged reads, 0 is a
+        // valid possible PFN.
+        // Store 0 as a sentinel since 0 means no entry.
+        // Neighbors are marked as prefetched so that their first query still
+        // reports a non-cached result to the caller.
+        if (cur_vpage == vpage) {
+            dr_hashtable_add(drcontext, v2p_, cur_vpage,
+                             reinterpret_cast<void *>(
+                                 cur_ppage == 0 ? ZERO_ADDR_PAYLOAD : cur_ppage));
+            *ppage = cur_ppage;
+            success = true;
+        } else if (dr_hashtable_lookup(drcontext, v2p_, cur_vpage) == nullptr) {
+            dr_hashtable_add(drcontext, v2p_, cur_vpage,
+                             reinterpret_cast<void *>(cur_ppage | PREFETCHED_PAYLOAD));
+        }
+    }
+    return success;
+}
+#endif
+
 bool
 physaddr_t::virtual2physical(void *drcontext, addr_t virt, OUT addr_t *phys,
                              OUT bool *from_cache)
@@ -187,15 +289,21 @@ physaddr_t::virtual2physical(void *drcontext, addr_t virt, OUT addr_t *phys,
     bool use_cache = true;
     if (from_cache != nullptr)
         *from_cache = false;
+    uint64_t cur_generation = mapping_generation_.load(std::memory_order_acquire);
+    if (cur_generation != generation_) {
+        // Some thread unmapped or remapped memory: our translations may be stale.
+        // We can keep using the table afterward as the following queries will
+        // re-read the kernel's current mappings.
+        flush_cache(drcontext);
+        generation_ = cur_generation;
+        ++num_invalidations_;
+    }
     if (op_virt2phys_freq.get_value() > 0 && ++count_ >= op_virt2phys_freq.get_value()) {
         // Flush the cache and re-sync with the kernel.
         // XXX i#4014: Provide a similar option that doesn't flush and just checks
         // whether mappings have changed?
         use_cache = false;
-        memset(last_vpage_, static_cast<char>(PAGE_INVALID), sizeof(last_vpage_));
-        // We do not bother to clear last_ppage_ as it is only used when
-        // last_vpage_ holds legitimate values.
-        dr_hashtable_clear(drcontext, v2p_);
+        flush_cache(drcontext);
         count_ = 0;
     }
     if (use_cache) {
@@ -215,11 +323,21 @@ physaddr_t::virtual2physical(void *drcontext, addr_t virt, OUT addr_t *phys,
         void *lookup = dr_hashtable_lookup(drcontext, v2p_, vpage);
         if (lookup != nullptr) {
             addr_t ppage = reinterpret_cast<addr_t>(lookup);
+            bool prefetched = false;
             // Restore a 0 payload.
             if (ppage == ZERO_ADDR_PAYLOAD)
                 ppage = 0;
+            else if (TESTANY(PREFETCHED_PAYLOAD, ppage)) {
+                // This is the first query for a page read as part of a batch.
+                ppage &= ~PREFETCHED_PAYLOAD;
+                prefetched = true;
+                dr_hashtable_remove(drcontext, v2p_, vpage);
+                dr_hashtable_add(
+                    drcontext, v2p_, vpage,
+                    reinterpret_cast<void *>(ppage == 0 ? ZERO_ADDR_PAYLOAD : ppage));
+            }
             if (from_cache != nullptr)
-                *from_cache = true;
+                *from_cache = !prefetched;
             *phys = ppage + page_offs(virt);
             last_vpage_[cache_idx_] = vpage;
             last_ppage_[cache_idx_] = ppage;
@@ -234,35 +352,9 @@ physaddr_t::virtual2physical(void *drcontext, addr_t virt, OUT addr_t *phys,
         NOTIFY(1, "v2p failure: file descriptor is invalid\n");
         return false;
     }
-    // The pagemap file contains one 64-bit int per page.
-    // See the docs at https://www.kernel.org/doc/Documentation/vm/pagemap.txt
-    // For huge pages it's the same: there are just N consecutive entries, with
-    // the first marked COMPOUND_HEAD and the rest COMPOUND_TAIL in the flags,
-    // which we ignore here.
-    off64_t offs = vpage / page_size_ * 8;
-    if (lseek64(fd_, offs, SEEK_SET) < 0) {
-        NOTIFY(1, "v2p failure: seek to " INT64_FORMAT_STRING " for %p failed\n", offs,
-               vpage);
-        return false;
-    }
-    uint64_t entry;
-    if (read(fd_, (char *)&entry, sizeof(entry)) != sizeof(entry)) {
-        NOTIFY(1, "v2p failure: read failed for %p\n", vpage);
+    addr_t ppage;
+    if (!read_pagemap_batch(drcontext, vpage, &ppage))
         return false;
-    }
-    NOTIFY(3, "v2p: %p => entry " HEX64_FORMAT_STRING " @ offs " INT64_FORMAT_STRING "\n",
-           vpage, entry, offs);
-    if (!TESTALL(PAGEMAP_VALID, entry) || TESTANY(PAGEMAP_SWAP, entry)) {
-        NOTIFY(1, "v2p failure: entry %p is invalid for %p in T%d\n", entry, vpage,
-               dr_get_thread_id(drcontext));
-        return false;
-    }
-    addr_t ppage = (addr_t)((entry & PAGEMAP_PFN) << page_bits_);
-    // Despite the kernel handing out a 0 PFN for unprivileged reads, 0 is a valid
-    // possible PFN.
-    // Store 0 as a sentinel since 0 means no entry.
-    dr_hashtable_add(drcontext, v2p_, vpage,
-                     reinterpret_cast<void *>(ppage == 0 ? ZERO_ADDR_PAYLOAD : ppage));
     *phys = ppage + page_offs(virt);
     last_ppage_[cache_idx_] = ppage;
     last_vpage_[cache_idx_] = vpage;
@@ -66,6 +66,18 @@ public:
     static bool
     global_init();
 
+    // Returns whether "sysnum" can change the virtual-to-physical mapping of
+    // existing pages (e.g., munmap or mremap), requiring a call to
+    // invalidate_all() once it completes.
+    static bool
+    syscall_changes_mappings(int sysnum);
+
+    // Invalidates the cached translations of every instance, in every thread.
+    // Each instance notices the change lazily on its next query, so this is
+    // safe to call from any thread without synchronization.
+    static void
+    invalidate_all();
+
 private:
 #ifdef LINUX
     inline addr_t
@@ -79,6 +91,16 @@ private:
         return addr & ((1 << page_bits_) - 1);
     }
 
+    // Clears the local cache and the per-thread table.
+    void
+    flush_cache(void *drcontext);
+
+    // Reads the pagemap entries for the PAGEMAP_BATCH pages surrounding "vpage"
+    // with a single pread and adds every present page to the table.
+    // Returns false if the entry for "vpage" itself could not be obtained.
+    bool
+    read_pagemap_batch(void *drcontext, addr_t vpage, OUT addr_t *ppage);
+
     size_t page_size_;
     int page_bits_;
     static constexpr int NUM_CACHE = 8;
@@ -104,11 +126,25 @@ private:
     // With hashtable_t nullptr is how non-existence is shown, so we store
     // an actual 0 address (can happen for physical) as this sentinel.
     static constexpr addr_t ZERO_ADDR_PAYLOAD = PAGE_INVALID;
+    // Physical pages are aligned, so we use the bottom bit to mark entries
+    // added by a batch read that have not yet been queried.  This is
+    // checked after ZERO_ADDR_PAYLOAD, which also has the bit set.
+    static constexpr addr_t PREFETCHED_PAYLOAD = 1;
+    // The number of consecutive pagemap entries read on each table miss.
+    // Neighboring pages are very likely to be queried soon after, and a single
+    // larger read costs little more than a one-entry read.
+    static constexpr int PAGEMAP_BATCH = 32;
     unsigned int count_;
+    // The value of mapping_generation_ when our cache was last flushed.
+    uint64_t generation_;
     uint64_t num_hit_cache_;
     uint64_t num_hit_table_;
     uint64_t num_miss_;
+    uint64_t num_batch_reads_;
+    uint64_t num_invalidations_;
     static std::atomic<bool> has_privileges_;
+    // Incremented by invalidate_all().
+    static std::atomic<uint64_t> mapping_generation_;
 #endif
 };
 
@@ -38,13 +38,20 @@
 #include "drcovlib.h"
 #include "raw2trace.h"
 #include "instru.h"
+#include "raw2trace_directory.h"
+#include "directory_iterator.h"
 #include "../common/memref.h"
+#include "../common/process_manifest.h"
 #include "../common/trace_entry.h"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 // Assumes we return an error string by convention.
@@ -115,6 +122,48 @@ trace_metadata_writer_t::write_timestamp(byte *buffer, uint64 timestamp)
  * Module list
  */
 
+// Module files are mapped once per path and shared among all live module_mapper_t
+// instances, which saves address space and page cache when converting many
+// processes of one application concurrently.
+struct mapped_module_file_t {
+    byte *base;
+    size_t size;
+    int refcount;
+};
+static std::mutex mapped_module_files_lock;
+static std::unordered_map<std::string, mapped_module_file_t> mapped_module_files;
+
+static byte *
+map_module_file(const char *path, OUT size_t *size)
+{
+    std::lock_guard<std::mutex> guard(mapped_module_files_lock);
+    auto it = mapped_module_files.find(path);
+    if (it != mapped_module_files.end()) {
+        ++it->second.refcount;
+        *size = it->second.size;
+        return it->second.base;
+    }
+    byte *base = dr_map_executable_file(path, DR_MAPEXE_SKIP_WRITABLE, size);
+    if (base != nullptr)
+        mapped_module_files[path] = { base, *size, 1 };
+    return base;
+}
+
+static bool
+unmap_module_file(byte *base, size_t size)
+{
+    std::lock_guard<std::mutex> guard(mapped_module_files_lock);
+    for (auto it = mapped_module_files.begin(); it != mapped_module_files.end(); ++it) {
+        if (it->second.base == base) {
+            if (--it->second.refcount > 0)
+                return true;
+            mapped_module_files.erase(it);
+            break;
+        }
+    }
+    return dr_unmap_executable_file(base, size);
+}
+
 const char *(*module_mapper_t::user_parse_)(const char *src, OUT void **data) = nullptr;
 void (*module_mapper_t::user_free_)(void *data) = nullptr;
 int (*module_mapper_t::user_print_)(void *data, char *dst, size_t max_len) = nullptr;
@@ -168,7 +217,7 @@ module_mapper_t::~module_mapper_t()
     for (std::vector<module_t>::iterator mvi = modvec_.begin(); mvi != modvec_.end();
          ++mvi) {
         if (!mvi->is_external && mvi->map_seg_base != NULL && mvi->total_map_size != 0) {
-            bool ok = dr_unmap_executable_file(mvi->map_seg_base, mvi->total_map_size);
+            bool ok = unmap_module_file(mvi->map_seg_base, mvi->total_map_size);
             if (!ok)
                 WARN("Failed to unmap module %s", mvi->path);
         }
@@ -277,6 +326,8 @@ raw2trace_t::do_module_parsing()
         module_mapper_ = module_mapper_t::create(modmap_, user_parse_, user_process_,
                                                  user_process_data_, user_free_,
                                                  verbosity_, alt_module_dir_);
+        if (gencode_ != nullptr)
+            module_mapper_->set_gencode_snapshots(gencode_, gencode_size_);
     }
     return module_mapper_->get_last_error();
 }
@@ -319,6 +370,7 @@ raw2trace_t::read_and_map_modules()
     }
 
     set_modvec_(&module_mapper_->get_loaded_modules());
+    set_gencode_index_(&module_mapper_->get_gencode_index());
     return module_mapper_->get_last_error();
 }
 
@@ -390,14 +442,12 @@ module_mapper_t::read_and_map_modules()
                     basename = std::string(basename, sep_index + 1, std::string::npos);
                 std::string new_path = alt_module_dir_ + DIRSEP + basename;
                 VPRINT(2, "Trying to map %s\n", new_path.c_str());
-                base_pc = dr_map_executable_file(new_path.c_str(),
-                                                 DR_MAPEXE_SKIP_WRITABLE, &map_size);
+                base_pc = map_module_file(new_path.c_str(), &map_size);
             }
             if (base_pc == NULL) {
                 // Try the recorded path.
                 VPRINT(2, "Trying to map %s\n", info.path);
-                base_pc =
-                    dr_map_executable_file(info.path, DR_MAPEXE_SKIP_WRITABLE, &map_size);
+                base_pc = map_module_file(info.path, &map_size);
             }
             if (base_pc == NULL) {
                 // We expect to fail to map dynamorio.dll for x64 Windows as it
@@ -421,6 +471,39 @@ module_mapper_t::read_and_map_modules()
         }
     }
     VPRINT(1, "Successfully read %zu modules\n", modlist_.size());
+    if (gencode_ != nullptr)
+        read_gencode_snapshots();
+}
+
+void
+module_mapper_t::read_gencode_snapshots()
+{
+    size_t pos = 0;
+    while (pos < gencode_size_) {
+        gencode_snapshot_t header;
+        if (gencode_size_ - pos < sizeof(header)) {
+            // The application may have been killed while a snapshot was being written.
+            WARN("Ignoring truncated generated code snapshot at +%zu", pos);
+            break;
+        }
+        memcpy(&header, gencode_ + pos, sizeof(header));
+        pos += sizeof(header);
+        if (header.size > gencode_size_ - pos) {
+            WARN("Ignoring truncated generated code snapshot at +%zu", pos);
+            break;
+        }
+        VPRINT(2, "Generated code snapshot %zu: " PIFX "-" PIFX " at +%zu\n",
+               modvec_.size(), (ptr_uint_t)header.orig_pc,
+               (ptr_uint_t)(header.orig_pc + header.size), pos);
+        gencode_index_[pos] = modvec_.size();
+        modvec_.push_back(module_t("<gencode>",
+                                   reinterpret_cast<app_pc>(
+                                       static_cast<ptr_uint_t>(header.orig_pc)),
+                                   (byte *)gencode_ + pos, 0, (size_t)header.size,
+                                   (size_t)header.size, true /*external data*/));
+        pos += (size_t)header.size;
+    }
+    VPRINT(1, "Successfully read %zu generated code snapshots\n", gencode_index_.size());
 }
 
 std::string
@@ -729,6 +812,98 @@ raw2trace_t::do_conversion()
     return "";
 }
 
+// Returns whether the final trace directory for the raw files in rawdir is
+// missing or empty.
+static bool
+trace_dir_needs_conversion(const std::string &rawdir)
+{
+    std::string tracedir = raw2trace_directory_t::tracedir_from_rawdir(rawdir);
+    if (!directory_iterator_t::is_directory(tracedir))
+        return true;
+    directory_iterator_t end;
+    directory_iterator_t iter(tracedir);
+    if (!iter)
+        return true;
+    for (; iter != end; ++iter) {
+        if ((*iter) != "." && (*iter) != "..")
+            return false;
+    }
+    return true;
+}
+
+std::string
+raw2trace_t::convert_process_manifest(const std::string &outdir, unsigned int verbosity,
+                                      int worker_count, const std::string &alt_module_dir)
+{
+    std::vector<process_manifest_entry_t> processes;
+    if (!read_process_manifest(outdir, &processes))
+        return "Failed to read process manifest in " + outdir;
+    if (worker_count < 0) {
+        worker_count = std::thread::hardware_concurrency();
+        if (worker_count > kDefaultJobMax)
+            worker_count = kDefaultJobMax;
+    }
+    // The workers are split between whole processes, which are independent, and
+    // the threads within each process.
+    size_t concurrent = std::max(1, std::min(worker_count, (int)processes.size()));
+    int per_process_workers = worker_count / static_cast<int>(concurrent);
+    if (per_process_workers <= 1)
+        per_process_workers = 0;
+    // drmodtrack's custom module data callbacks and the DR standalone reference
+    // count are global, so we serialize module parsing and teardown while letting
+    // the conversions themselves run concurrently.
+    std::mutex setup_lock;
+    std::atomic<size_t> next_process(0);
+    std::vector<std::string> errors(processes.size());
+    void *dcontext = dr_standalone_init();
+    auto convert_processes = [&]() {
+        for (size_t i = next_process++; i < processes.size(); i = next_process++) {
+            std::string rawdir = outdir + DIRSEP + processes[i].subdir;
+            if (!trace_dir_needs_conversion(rawdir))
+                continue;
+            std::unique_ptr<raw2trace_directory_t> dir;
+            std::unique_ptr<raw2trace_t> raw2trace;
+            std::string error;
+            {
+                std::lock_guard<std::mutex> guard(setup_lock);
+                dir.reset(new raw2trace_directory_t(verbosity));
+                error = dir->initialize(rawdir, "");
+                if (error.empty()) {
+                    raw2trace.reset(new raw2trace_t(dir->modfile_bytes_, dir->in_files_,
+                                                    dir->out_files_, dcontext, verbosity,
+                                                    per_process_workers, alt_module_dir));
+                    if (dir->gencode_bytes_ != nullptr) {
+                        raw2trace->set_gencode_snapshots(dir->gencode_bytes_,
+                                                         dir->gencode_size_);
+                    }
+                    error = raw2trace->do_module_parsing_and_mapping();
+                }
+            }
+            if (error.empty())
+                error = raw2trace->do_conversion();
+            {
+                std::lock_guard<std::mutex> guard(setup_lock);
+                raw2trace.reset();
+                dir.reset();
+            }
+            if (!error.empty())
+                errors[i] = "Process " + processes[i].subdir + ": " + error;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < concurrent; ++i)
+        threads.push_back(std::thread(convert_processes));
+    convert_processes();
+    for (std::thread &thread : threads)
+        thread.join();
+    dr_standalone_exit();
+    for (const std::string &error : errors) {
+        if (!error.empty())
+            return error;
+    }
+    return "";
+}
+
 raw2trace_t::block_summary_t *
 raw2trace_t::lookup_block_summary(void *tls, app_pc block_start)
 {
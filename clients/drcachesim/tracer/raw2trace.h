@@ -46,6 +46,7 @@
 #include "drcovlib.h"
 #include <array>
 #include <atomic>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include "trace_entry.h"
@@ -414,6 +415,31 @@ public:
         return modvec_;
     }
 
+    /**
+     * Provides the contents of the #DRMEMTRACE_GENCODE_FILENAME file written with
+     * -record_gencode.  Each snapshot in the file is added to the module list with
+     * the path "<gencode>" so that the code it holds can be decoded.  Must be called
+     * before get_loaded_modules().  The contents are not copied and must remain valid
+     * for the lifetime of this object.
+     */
+    void
+    set_gencode_snapshots(const char *contents, size_t size)
+    {
+        gencode_ = contents;
+        gencode_size_ = size;
+    }
+
+    /**
+     * Returns a map from the offset of each -record_gencode snapshot's code in the
+     * #DRMEMTRACE_GENCODE_FILENAME file to the index of its entry in the vector
+     * returned by get_loaded_modules().
+     */
+    const std::map<uint64_t, size_t> &
+    get_gencode_index() const
+    {
+        return gencode_index_;
+    }
+
     /**
      * This interface is meant to be used with a final trace rather than a raw
      * trace, using the module log file saved from the raw2trace conversion.
@@ -483,9 +509,15 @@ protected:
     std::string
     do_module_parsing();
 
+    void
+    read_gencode_snapshots();
+
     const char *modmap_ = nullptr;
     void *modhandle_ = nullptr;
     std::vector<module_t> modvec_;
+    const char *gencode_ = nullptr;
+    size_t gencode_size_ = 0;
+    std::map<uint64_t, size_t> gencode_index_;
     void (*const cached_user_free_)(void *data) = nullptr;
 
     // Custom module fields that use drmodtrack are global.
@@ -858,6 +890,17 @@ protected:
         modvec_ptr_ = modvec;
     }
 
+    /**
+     * Set the map of -record_gencode snapshots to module map entries, as returned by
+     * module_mapper_t::get_gencode_index().  Without it, code in such snapshots is
+     * treated like code not in any module.
+     */
+    void
+    set_gencode_index_(const std::map<uint64_t, size_t> *gencode_index)
+    {
+        gencode_index_ptr_ = gencode_index;
+    }
+
 private:
     T *
     impl()
@@ -1012,31 +1055,51 @@ private:
         return error;
     }
 
+    // Converts the modidx and modoffs of a PC entry referring to a -record_gencode
+    // snapshot into the index of the snapshot's modvec_() entry and the offset
+    // within it.  Returns false if we do not have the snapshot.
+    bool
+    resolve_gencode_pc(INOUT uint64 *modidx, INOUT uint64 *modoffs)
+    {
+        if (gencode_index_ptr_ == nullptr)
+            return false;
+        auto it = gencode_index_ptr_->upper_bound(*modoffs);
+        if (it == gencode_index_ptr_->begin())
+            return false;
+        --it;
+        if (*modoffs - it->first >= modvec_()[it->second].seg_size)
+            return false;
+        *modidx = it->second;
+        *modoffs -= it->first;
+        return true;
+    }
+
     std::string
     append_bb_entries(void *tls, const offline_entry_t *in_entry, OUT bool *handled)
     {
         std::string error = "";
         uint instr_count = in_entry->pc.instr_count;
         const instr_summary_t *instr = nullptr;
-        app_pc start_pc = modvec_()[in_entry->pc.modidx].map_seg_base +
-            (in_entry->pc.modoffs - modvec_()[in_entry->pc.modidx].seg_offs);
-        app_pc pc, decode_pc = start_pc;
-        if ((in_entry->pc.modidx == 0 && in_entry->pc.modoffs == 0) ||
-            modvec_()[in_entry->pc.modidx].map_seg_base == NULL) {
-            // FIXME i#2062: add support for code not in a module (vsyscall, JIT, etc.).
-            // Once that support is in we can remove the bool return value and handle
-            // the memrefs up here.
+        uint64 modidx = in_entry->pc.modidx;
+        uint64 modoffs = in_entry->pc.modoffs;
+        if ((modidx == 0 && modoffs == 0) ||
+            (modidx == PC_MODIDX_GENCODE && !resolve_gencode_pc(&modidx, &modoffs)) ||
+            modvec_()[static_cast<size_t>(modidx)].map_seg_base == NULL) {
+            // FIXME i#2062: add support for code not in a module (vsyscall, etc.)
+            // beyond what -record_gencode provides.  Once that support is in we can
+            // remove the bool return value and handle the memrefs up here.
             impl()->log(
                 1, "Skipping ifetch for %u instrs not in a module (idx %d, +" PIFX ")\n",
                 instr_count, in_entry->pc.modidx, in_entry->pc.modoffs);
             *handled = false;
             return "";
-        } else {
-            impl()->log(3, "Appending %u instrs in bb " PFX " in mod %u +" PIFX " = %s\n",
-                        instr_count, (ptr_uint_t)start_pc, (uint)in_entry->pc.modidx,
-                        (ptr_uint_t)in_entry->pc.modoffs,
-                        modvec_()[in_entry->pc.modidx].path);
         }
+        const module_t &module = modvec_()[static_cast<size_t>(modidx)];
+        app_pc start_pc = module.map_seg_base + (modoffs - module.seg_offs);
+        app_pc pc, decode_pc = start_pc;
+        impl()->log(3, "Appending %u instrs in bb " PFX " in mod %u +" PIFX " = %s\n",
+                    instr_count, (ptr_uint_t)start_pc, (uint)modidx, (ptr_uint_t)modoffs,
+                    module.path);
         bool skip_icache = false;
         // This indicates that each memref has its own PC entry and that each
         // icache entry does not need to be considered a memref PC entry as well.
@@ -1046,11 +1109,11 @@ private:
         bool is_instr_only_trace =
             TESTANY(OFFLINE_FILE_TYPE_INSTRUCTION_ONLY, impl()->get_file_type(tls));
         // Cast to unsigned pointer-sized int first to avoid sign-extending.
-        uint64_t cur_pc = static_cast<uint64_t>(reinterpret_cast<ptr_uint_t>(
-                              modvec_()[in_entry->pc.modidx].orig_seg_base)) +
-            (in_entry->pc.modoffs - modvec_()[in_entry->pc.modidx].seg_offs);
+        uint64_t cur_pc = static_cast<uint64_t>(
+                              reinterpret_cast<ptr_uint_t>(module.orig_seg_base)) +
+            (modoffs - module.seg_offs);
         // Legacy traces need the offset, not the pc.
-        uint64_t cur_offs = in_entry->pc.modoffs;
+        uint64_t cur_offs = modoffs;
         std::unordered_map<reg_id_t, addr_t> reg_vals;
         if (instr_count == 0) {
             // L0 filtering adds a PC entry with a count of 0 prior to each memref.
@@ -1061,11 +1124,9 @@ private:
             // OFFLINE_FILE_TYPE_IFILTERED.
             DR_ASSERT(instrs_are_separate);
         } else {
-            if (!impl()->instr_summary_exists(tls, in_entry->pc.modidx,
-                                              in_entry->pc.modoffs, start_pc, 0,
+            if (!impl()->instr_summary_exists(tls, modidx, modoffs, start_pc, 0,
                                               decode_pc)) {
-                std::string res = analyze_elidable_addresses(tls, in_entry->pc.modidx,
-                                                             in_entry->pc.modoffs,
+                std::string res = analyze_elidable_addresses(tls, modidx, modoffs,
                                                              start_pc, instr_count);
                 if (!res.empty())
                     return res;
@@ -1076,15 +1137,13 @@ private:
         for (uint i = 0; i < instr_count; ++i) {
             trace_entry_t *buf_start = impl()->get_write_buffer(tls);
             trace_entry_t *buf = buf_start;
-            app_pc orig_pc = decode_pc - modvec_()[in_entry->pc.modidx].map_seg_base +
-                modvec_()[in_entry->pc.modidx].orig_seg_base;
+            app_pc orig_pc = decode_pc - module.map_seg_base + module.orig_seg_base;
             // To avoid repeatedly decoding the same instruction on every one of its
             // dynamic executions, we cache the decoding in a hashtable.
             pc = decode_pc;
             impl()->log_instruction(4, decode_pc, orig_pc);
-            instr =
-                impl()->get_instr_summary(tls, in_entry->pc.modidx, in_entry->pc.modoffs,
-                                          start_pc, instr_count, i, &pc, orig_pc);
+            instr = impl()->get_instr_summary(tls, modidx, modoffs, start_pc,
+                                              instr_count, i, &pc, orig_pc);
             if (instr == nullptr) {
                 // We hit some error somewhere, and already reported it. Just exit the
                 // loop.
@@ -1508,6 +1567,7 @@ private:
 
     offline_instru_t instru_offline_;
     const std::vector<module_t> *modvec_ptr_ = nullptr;
+    const std::map<uint64_t, size_t> *gencode_index_ptr_ = nullptr;
 
 #undef DR_CHECK
 };
@@ -1551,6 +1611,19 @@ public:
                                                  void *user_data),
                        void *process_cb_user_data, void (*free_cb)(void *data));
 
+    /**
+     * Provides the contents of the #DRMEMTRACE_GENCODE_FILENAME file for traces
+     * gathered with -record_gencode, allowing the code snapshots it contains to be
+     * decoded.  Must be called before do_conversion().  The contents are not copied
+     * and must remain valid for the lifetime of this object.
+     */
+    void
+    set_gencode_snapshots(const char *contents, size_t size)
+    {
+        gencode_ = contents;
+        gencode_size_ = size;
+    }
+
     /**
      * Performs the first step of do_conversion() without further action: parses and
      * iterates over the list of modules.  This is provided to give the user a method
@@ -1602,6 +1675,19 @@ public:
     virtual std::string
     do_conversion();
 
+    /**
+     * Converts every process listed in the -process_manifest manifest in \p outdir,
+     * the -outdir of a multi-process tracing run, into a final trace in its own
+     * sub-directory.  Processes whose final trace directory is already non-empty are
+     * skipped.  Up to \p worker_count conversions run concurrently, sharing one
+     * DR context and one mapping of each application module.  Returns a non-empty
+     * error message on failure.
+     */
+    static std::string
+    convert_process_manifest(const std::string &outdir, unsigned int verbosity = 0,
+                             int worker_count = -1,
+                             const std::string &alt_module_dir = "");
+
     static std::string
     check_thread_file(std::istream *f);
 
@@ -1789,6 +1875,8 @@ private:
     void *user_process_data_ = nullptr;
 
     const char *modmap_;
+    const char *gencode_ = nullptr;
+    size_t gencode_size_ = 0;
     std::unique_ptr<module_mapper_t> module_mapper_;
 
     unsigned int verbosity_ = 0;
@@ -114,7 +114,8 @@ raw2trace_directory_t::open_thread_log_file(const char *basename)
           basename);
     // Skip the auxiliary files.
     if (strcmp(basename, DRMEMTRACE_MODULE_LIST_FILENAME) == 0 ||
-        strcmp(basename, DRMEMTRACE_FUNCTION_LIST_FILENAME) == 0)
+        strcmp(basename, DRMEMTRACE_FUNCTION_LIST_FILENAME) == 0 ||
+        strcmp(basename, DRMEMTRACE_GENCODE_FILENAME) == 0)
         return "";
     // Skip any non-.raw in case someone put some other file in there.
     const char *basename_dot = strrchr(basename, '.');
@@ -236,6 +237,27 @@ raw2trace_directory_t::read_module_file(const std::string &modfilename)
     return "";
 }
 
+std::string
+raw2trace_directory_t::read_gencode_file(const std::string &gencode_filename)
+{
+    // The file is only present with -record_gencode.
+    file_t file = dr_open_file(gencode_filename.c_str(), DR_FILE_READ);
+    if (file == INVALID_FILE)
+        return "";
+    uint64 file_size;
+    std::string err;
+    if (!dr_file_size(file, &file_size))
+        err = "Failed to get generated code file size: " + gencode_filename;
+    else {
+        gencode_size_ = (size_t)file_size;
+        gencode_bytes_ = new char[gencode_size_];
+        if (dr_read_file(file, gencode_bytes_, gencode_size_) < (ssize_t)gencode_size_)
+            err = "Didn't read whole generated code file " + gencode_filename;
+    }
+    dr_close_file(file);
+    return err;
+}
+
 bool
 raw2trace_directory_t::is_window_subdir(const std::string &dir)
 {
@@ -340,6 +362,10 @@ raw2trace_directory_t::initialize(const std::string &indir, const std::string &o
     std::string err = read_module_file(modfilename);
     if (!err.empty())
         return err;
+    err = read_gencode_file(modfile_dir + std::string(DIRSEP) +
+                            DRMEMTRACE_GENCODE_FILENAME);
+    if (!err.empty())
+        return err;
 
     return open_thread_files();
 }
@@ -376,6 +402,8 @@ raw2trace_directory_t::~raw2trace_directory_t()
 {
     if (modfile_bytes_ != nullptr)
         delete[] modfile_bytes_;
+    if (gencode_bytes_ != nullptr)
+        delete[] gencode_bytes_;
     if (modfile_ != INVALID_FILE)
         dr_close_file(modfile_);
     for (std::vector<std::istream *>::iterator fi = in_files_.begin();
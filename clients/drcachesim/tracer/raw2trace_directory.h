@@ -43,6 +43,8 @@ class raw2trace_directory_t {
 public:
     raw2trace_directory_t(unsigned int verbosity = 0)
         : modfile_bytes_(nullptr)
+        , gencode_bytes_(nullptr)
+        , gencode_size_(0)
         , modfile_(INVALID_FILE)
         , indir_("")
         , outdir_("")
@@ -79,6 +81,9 @@ public:
     is_window_subdir(const std::string &dir);
 
     char *modfile_bytes_;
+    // The contents of the -record_gencode snapshot file, or nullptr if there is none.
+    char *gencode_bytes_;
+    size_t gencode_size_;
     std::vector<std::istream *> in_files_;
     std::vector<std::ostream *> out_files_;
 
@@ -86,6 +91,8 @@ private:
     std::string
     read_module_file(const std::string &modfilename);
     std::string
+    read_gencode_file(const std::string &gencode_filename);
+    std::string
     open_thread_files();
     std::string
     open_thread_log_file(const char *basename);
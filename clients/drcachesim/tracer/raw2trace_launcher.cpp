@@ -43,6 +43,7 @@
 #include "dr_frontend.h"
 #include "raw2trace.h"
 #include "raw2trace_directory.h"
+#include "../common/process_manifest.h"
 
 static droption_t<std::string>
     op_indir(DROPTION_SCOPE_FRONTEND, "indir", "",
@@ -94,6 +95,18 @@ _tmain(int argc, const TCHAR *targv[])
                     droption_parser_t::usage_short(DROPTION_SCOPE_ALL).c_str());
     }
 
+    std::vector<process_manifest_entry_t> processes;
+    if (op_outdir.get_value().empty() &&
+        read_process_manifest(op_indir.get_value(), &processes)) {
+        // A -process_manifest run: convert each process into its own trace dir.
+        std::string error = raw2trace_t::convert_process_manifest(
+            op_indir.get_value(), op_verbose.get_value(), op_jobs.get_value(),
+            op_alt_module_dir.get_value());
+        if (!error.empty())
+            FATAL_ERROR("Conversion failed: %s", error.c_str());
+        return 0;
+    }
+
     raw2trace_directory_t dir(op_verbose.get_value());
     std::string dir_err = dir.initialize(op_indir.get_value(), op_outdir.get_value());
     if (!dir_err.empty())
@@ -101,6 +114,8 @@ _tmain(int argc, const TCHAR *targv[])
     raw2trace_t raw2trace(dir.modfile_bytes_, dir.in_files_, dir.out_files_, NULL,
                           op_verbose.get_value(), op_jobs.get_value(),
                           op_alt_module_dir.get_value());
+    if (dir.gencode_bytes_ != nullptr)
+        raw2trace.set_gencode_snapshots(dir.gencode_bytes_, dir.gencode_size_);
     std::string error = raw2trace.do_conversion();
     if (!error.empty())
         FATAL_ERROR("Conversion failed: %s", error.c_str());
@@ -103,6 +103,7 @@ static char logsubdir[MAXIMUM_PATH];
 static char subdir_prefix[MAXIMUM_PATH]; /* Holds op_subdir_prefix. */
 static file_t module_file;
 static file_t funclist_file = INVALID_FILE;
+static file_t gencode_file = INVALID_FILE;
 static int notify_beyond_global_max_once;
 
 /* Max number of entries a buffer can have. It should be big enough
@@ -161,6 +162,12 @@ typedef struct {
     uint64 num_phys_markers;
     byte *v2p_buf;
     uint64 num_v2p_writeouts; /* v2p_buf writeout instances. */
+    /* For -flight_recorder: a ring of the most recent buffers and their sizes. */
+    byte *history;
+    size_t *history_size;
+    uint history_next;
+    uint history_count;
+    uint64 history_trigger; /* The trigger count as of the last dump. */
 } per_thread_t;
 
 #define MAX_NUM_DELAY_INSTRS 32
@@ -238,6 +245,18 @@ static bool thread_filtering_enabled;
 #define INSTR_COUNT_LOCAL_UNIT 10000
 static std::atomic<uint64> cur_window_instr_count;
 
+/* For -flight_recorder: the number of dumps triggered so far, and the number of
+ * buffers of history kept by each thread.
+ */
+static std::atomic<uint64> flight_recorder_triggers;
+static uint history_slots;
+
+static inline bool
+flight_recorder_enabled();
+
+static void
+flight_recorder_trigger();
+
 static bool
 count_traced_instrs(void *drcontext, int toadd);
 
@@ -437,6 +456,15 @@ drmemtrace_custom_module_data(void *(*load_cb)(module_data_t *module, int seg_id
         return DRMEMTRACE_ERROR;
 }
 
+drmemtrace_status_t
+drmemtrace_flight_recorder_dump(void)
+{
+    if (!flight_recorder_enabled())
+        return DRMEMTRACE_ERROR_NOT_IMPLEMENTED;
+    flight_recorder_trigger();
+    return DRMEMTRACE_SUCCESS;
+}
+
 drmemtrace_status_t
 drmemtrace_filter_threads(bool (*should_trace_thread)(thread_id_t tid, void *user_data),
                           void *user_value)
@@ -1136,6 +1164,100 @@ process_buffer_for_physaddr(void *drcontext, per_thread_t *data, size_t header_s
     return skip;
 }
 
+/***************************************************************************
+ * Flight recorder: in-memory trace history written out only on a trigger.
+ */
+
+static inline bool
+flight_recorder_enabled()
+{
+    return op_flight_recorder.get_value() > 0;
+}
+
+static inline bool
+flight_recorder_dump_pending(per_thread_t *data)
+{
+    return data->history_trigger !=
+        flight_recorder_triggers.load(std::memory_order_acquire);
+}
+
+static void
+flight_recorder_trigger()
+{
+    uint64 count = flight_recorder_triggers.fetch_add(1, std::memory_order_release) + 1;
+    NOTIFY(1, "Flight recorder dump #" UINT64_FORMAT_STRING " triggered\n", count);
+}
+
+static void
+init_history(per_thread_t *data)
+{
+    if (data->history == NULL) {
+        data->history = (byte *)dr_raw_mem_alloc(
+            history_slots * max_buf_size, DR_MEMPROT_READ | DR_MEMPROT_WRITE, NULL);
+        data->history_size =
+            (size_t *)dr_global_alloc(history_slots * sizeof(*data->history_size));
+    }
+    data->history_next = 0;
+    data->history_count = 0;
+    data->history_trigger = flight_recorder_triggers.load(std::memory_order_acquire);
+}
+
+static void
+free_history(per_thread_t *data)
+{
+    if (data->history == NULL)
+        return;
+    dr_raw_mem_free(data->history, history_slots * max_buf_size);
+    dr_global_free(data->history_size, history_slots * sizeof(*data->history_size));
+    data->history = NULL;
+}
+
+/* Copies the trace data from buf_start to buf_ptr into the thread's history,
+ * replacing the oldest buffer once the history is full.
+ */
+static void
+record_history(per_thread_t *data, byte *buf_start, byte *buf_ptr)
+{
+    size_t size = buf_ptr - buf_start;
+    DR_ASSERT(size <= max_buf_size);
+    memcpy(data->history + data->history_next * max_buf_size, buf_start, size);
+    data->history_size[data->history_next] = size;
+    data->history_next = (data->history_next + 1) % history_slots;
+    if (data->history_count < history_slots)
+        ++data->history_count;
+}
+
+/* Writes the thread's history, oldest first, and empties it.  The thread header
+ * is not kept in the history, so we write it before the first dump, using the
+ * trace buffer as scratch space: the caller must have consumed its contents.
+ */
+static uint
+dump_history(void *drcontext, per_thread_t *data)
+{
+    uint current_num_refs = 0;
+    data->history_trigger = flight_recorder_triggers.load(std::memory_order_acquire);
+    if (data->history_count == 0)
+        return 0;
+    if (data->file == INVALID_FILE) {
+        open_new_thread_file(drcontext, get_local_window(data));
+        size_t size = reinterpret_cast<offline_instru_t *>(instru)->append_thread_header(
+            data->buf_base, dr_get_thread_id(drcontext), get_file_type());
+        current_num_refs +=
+            output_buffer(drcontext, data, data->buf_base, data->buf_base + size, 0);
+    }
+    NOTIFY(2, "T%d writing %u buffers of history\n", dr_get_thread_id(drcontext),
+           data->history_count);
+    uint slot =
+        (data->history_next + history_slots - data->history_count) % history_slots;
+    for (; data->history_count > 0; --data->history_count) {
+        byte *start = data->history + slot * max_buf_size;
+        current_num_refs +=
+            output_buffer(drcontext, data, start, start + data->history_size[slot], 0);
+        slot = (slot + 1) % history_slots;
+    }
+    return current_num_refs;
+}
+
 // Should be invoked only in the middle of an active tracing window.
 static void
 memtrace(void *drcontext, bool skip_size_cap)
@@ -1147,7 +1269,8 @@ memtrace(void *drcontext, bool skip_size_cap)
     size_t header_size = 0;
     uint current_num_refs = 0;
 
-    if (op_offline.get_value() && data->file == INVALID_FILE) {
+    if (op_offline.get_value() && data->file == INVALID_FILE &&
+        !flight_recorder_enabled()) {
         // We've delayed opening a new window file to avoid an empty final file.
         DR_ASSERT(has_tracing_windows() || op_trace_after_instrs.get_value() > 0);
         open_new_thread_file(drcontext, get_local_window(data));
@@ -1167,6 +1290,10 @@ memtrace(void *drcontext, bool skip_size_cap)
         return;
     }
 
+    // The offline thread header at the top of the first buffer is written
+    // separately from any -flight_recorder history.
+    size_t thread_header_size =
+        data->has_thread_header && op_offline.get_value() ? data->init_header_size : 0;
     header_size = add_buffer_header(drcontext, data, data->buf_base);
 
     bool window_changed = false;
@@ -1239,12 +1366,18 @@ memtrace(void *drcontext, bool skip_size_cap)
                 reached_traced_instrs_threshold(drcontext);
             }
         }
-        size_t skip = 0;
-        if (op_use_physical.get_value()) {
-            skip = process_buffer_for_physaddr(drcontext, data, header_size, buf_ptr);
+        if (flight_recorder_enabled()) {
+            record_history(data, data->buf_base + thread_header_size, buf_ptr);
+            if (flight_recorder_dump_pending(data))
+                current_num_refs += dump_history(drcontext, data);
+        } else {
+            size_t skip = 0;
+            if (op_use_physical.get_value()) {
+                skip = process_buffer_for_physaddr(drcontext, data, header_size, buf_ptr);
+            }
+            current_num_refs += output_buffer(drcontext, data, data->buf_base + skip,
+                                              buf_ptr, header_size);
         }
-        current_num_refs +=
-            output_buffer(drcontext, data, data->buf_base + skip, buf_ptr, header_size);
     }
 
     if (file_ops_func.handoff_buf == NULL) {
@@ -1347,6 +1480,9 @@ event_filter_syscall(void *drcontext, int sysnum);
 static bool
 event_pre_syscall(void *drcontext, int sysnum);
 
+static void
+event_post_syscall(void *drcontext, int sysnum);
+
 static void
 event_kernel_xfer(void *drcontext, const dr_kernel_xfer_info_t *info);
 
@@ -1489,6 +1625,7 @@ instrumentation_exit()
 {
     dr_unregister_filter_syscall_event(event_filter_syscall);
     if (!drmgr_unregister_pre_syscall_event(event_pre_syscall) ||
+        !drmgr_unregister_post_syscall_event(event_post_syscall) ||
         !drmgr_unregister_kernel_xfer_event(event_kernel_xfer) ||
         !drmgr_unregister_bb_app2app_event(event_bb_app2app))
         DR_ASSERT(false);
@@ -1532,6 +1669,7 @@ instrumentation_init()
 {
     instrumentation_drbbdup_init();
     if (!drmgr_register_pre_syscall_event(event_pre_syscall) ||
+        !drmgr_register_post_syscall_event(event_post_syscall) ||
         !drmgr_register_kernel_xfer_event(event_kernel_xfer) ||
         !drmgr_register_bb_app2app_event(event_bb_app2app, &pri_pre_bbdup))
         DR_ASSERT(false);
@@ -2094,6 +2232,93 @@ instrument_instr(void *drcontext, void *tag, user_data_t *ud, instrlist_t *ilist
     return adjust;
 }
 
+/* For -record_inline_entry, inserts code at the entry to a traced function to write
+ * the function id, return address, and argument markers directly into the trace
+ * buffer, in place of a clean call to func_trace's pre-function callback.
+ */
+static void
+instrument_func_entry(void *drcontext, instrlist_t *ilist, instr_t *where, int func_id,
+                      int arg_num)
+{
+    offline_instru_t *offline_instru = reinterpret_cast<offline_instru_t *>(instru);
+    reg_id_t reg_ptr, reg_val;
+    drvector_t rvec;
+    /* As in event_app_instruction(), reg_ptr must be ECX or RCX for jecxz on x86. */
+    drreg_init_and_fill_vector(&rvec, false);
+#ifdef X86
+    drreg_set_vector_entry(&rvec, DR_REG_XCX, true);
+#else
+    for (reg_ptr = DR_REG_R0; reg_ptr <= DR_REG_R7; reg_ptr++)
+        drreg_set_vector_entry(&rvec, reg_ptr, true);
+#endif
+    if (drreg_reserve_register(drcontext, ilist, where, &rvec, &reg_ptr) !=
+        DRREG_SUCCESS)
+        FATAL("Fatal error: failed to reserve scratch registers\n");
+    drvector_delete(&rvec);
+    /* Avoid the argument registers for the value register to reduce the chance
+     * of a dead argument register losing its value.
+     */
+    drreg_init_and_fill_vector(&rvec, true);
+    for (int i = 0; i < arg_num; i++)
+        drreg_set_vector_entry(&rvec, func_trace_get_arg_reg(i), false);
+    if (drreg_reserve_register(drcontext, ilist, where, &rvec, &reg_val) !=
+        DRREG_SUCCESS)
+        FATAL("Fatal error: failed to reserve scratch registers\n");
+    drvector_delete(&rvec);
+
+    insert_load_buf_ptr(drcontext, ilist, where, reg_ptr);
+    instr_t *skip_instru = INSTR_CREATE_label(drcontext);
+    reg_id_t reg_skip = DR_REG_NULL;
+    reg_id_set_t app_regs_at_skip;
+    if (thread_filtering_enabled) {
+        insert_conditional_skip(drcontext, ilist, where, reg_ptr, &reg_skip, skip_instru,
+                                false, app_regs_at_skip);
+    }
+
+    int adjust = offline_instru->insert_save_marker(drcontext, ilist, where, reg_ptr,
+                                                    reg_val, 0, TRACE_MARKER_TYPE_FUNC_ID,
+                                                    static_cast<uintptr_t>(func_id));
+#ifdef X86
+    MINSERT(ilist, where,
+            XINST_CREATE_load(drcontext, opnd_create_reg(reg_val),
+                              OPND_CREATE_MEMPTR(DR_REG_XSP, 0)));
+#elif defined(AARCHXX)
+    if (drreg_get_app_value(drcontext, ilist, where, DR_REG_LR, reg_val) !=
+        DRREG_SUCCESS)
+        FATAL("Fatal error: failed to obtain the return address\n");
+#endif
+    adjust = offline_instru->insert_save_marker_from_reg(drcontext, ilist, where, reg_ptr,
+                                                         adjust,
+                                                         TRACE_MARKER_TYPE_FUNC_RETADDR,
+                                                         reg_val);
+    for (int i = 0; i < arg_num; i++) {
+        drreg_status_t res = drreg_get_app_value(drcontext, ilist, where,
+                                                 func_trace_get_arg_reg(i), reg_val);
+        if (res == DRREG_ERROR_NO_APP_VALUE) {
+            /* The register is dead in this block and was clobbered by our own
+             * reservation, so the function cannot be reading this argument.
+             */
+            instrlist_insert_mov_immed_ptrsz(drcontext, 0, opnd_create_reg(reg_val),
+                                             ilist, where, NULL, NULL);
+        } else if (res != DRREG_SUCCESS)
+            FATAL("Fatal error: failed to obtain a function argument\n");
+        adjust = offline_instru->insert_save_marker_from_reg(drcontext, ilist, where,
+                                                             reg_ptr, adjust,
+                                                             TRACE_MARKER_TYPE_FUNC_ARG,
+                                                             reg_val);
+    }
+    /* The block-final redzone check handles any buffer overflow, as the redzone
+     * has ample room for these few entries.
+     */
+    insert_update_buf_ptr(drcontext, ilist, where, reg_ptr, DR_PRED_NONE, adjust);
+
+    insert_conditional_skip_target(drcontext, ilist, where, skip_instru, reg_skip,
+                                   app_regs_at_skip);
+    if (drreg_unreserve_register(drcontext, ilist, where, reg_val) != DRREG_SUCCESS ||
+        drreg_unreserve_register(drcontext, ilist, where, reg_ptr) != DRREG_SUCCESS)
+        DR_ASSERT(false);
+}
+
 static bool
 is_last_instr(void *drcontext, instr_t *instr)
 {
@@ -2123,6 +2348,15 @@ event_app_instruction(void *drcontext, void *tag, instrlist_t *bb, instr_t *inst
     dr_emit_flags_t func_flags = func_trace_enabled_instrument_event(
         drcontext, tag, bb, instr, where, for_trace, translating, NULL);
     flags = static_cast<dr_emit_flags_t>(flags | func_flags);
+    // With -record_inline_entry we write the function entry markers ourselves,
+    // after any drwrap instrumentation and under the same first-instruction
+    // assumption.
+    if (op_record_inline_entry.get_value() && op_offline.get_value() &&
+        is_first_nonlabel(drcontext, instr)) {
+        int func_id, arg_num;
+        if (func_trace_inline_entry(instr_get_app_pc(instr), &func_id, &arg_num))
+            instrument_func_entry(drcontext, bb, where, func_id, arg_num);
+    }
 
     drmgr_disable_auto_predication(drcontext, bb);
 
@@ -2402,6 +2636,16 @@ event_pre_syscall(void *drcontext, int sysnum)
     return true;
 }
 
+static void
+event_post_syscall(void *drcontext, int sysnum)
+{
+    // The buffer was translated in event_pre_syscall using the old mappings.
+    // Now that the kernel has changed them, discard the stale translations
+    // cached by every thread.
+    if (op_use_physical.get_value() && physaddr_t::syscall_changes_mappings(sysnum))
+        physaddr_t::invalidate_all();
+}
+
 static void
 event_kernel_xfer(void *drcontext, const dr_kernel_xfer_info_t *info)
 {
@@ -2827,7 +3071,10 @@ init_thread_in_process(void *drcontext)
         set_local_window(drcontext, tracing_window.load(std::memory_order_acquire));
 
     if (op_offline.get_value()) {
-        if (tracing_disabled.load(std::memory_order_acquire) == BBDUP_MODE_TRACE) {
+        // With -flight_recorder the file is opened on the first dump.
+        if (flight_recorder_enabled())
+            init_history(data);
+        else if (tracing_disabled.load(std::memory_order_acquire) == BBDUP_MODE_TRACE) {
             open_new_thread_file(drcontext, get_local_window(data));
         }
         if (!has_tracing_windows()) {
@@ -2925,6 +3172,13 @@ event_thread_exit(void *drcontext)
             BUF_PTR(data->seg_base) += instru->append_marker(
                 BUF_PTR(data->seg_base), TRACE_MARKER_TYPE_INSTRUCTION_COUNT, icount);
         }
+        if (flight_recorder_enabled() && !flight_recorder_dump_pending(data)) {
+            // Drop the activity since the last dump: we only terminate the trace
+            // written by that dump, if there was one.
+            BUF_PTR(data->seg_base) = data->buf_base + buf_hdr_slots_size +
+                (data->has_thread_header ? data->init_header_size : 0);
+            data->history_count = 0;
+        }
         if (tracing_disabled.load(std::memory_order_acquire) == BBDUP_MODE_TRACE ||
             !op_split_windows.get_value()) {
             BUF_PTR(data->seg_base) += instru->append_thread_exit(
@@ -2941,7 +3195,10 @@ event_thread_exit(void *drcontext)
                     BUF_PTR(data->seg_base), dr_get_thread_id(drcontext));
                 memtrace(drcontext, data->bytes_written > 0);
             }
+            if (flight_recorder_enabled() && data->file != INVALID_FILE)
+                dump_history(drcontext, data);
         }
+        free_history(data);
 
         if (op_L0D_filter.get_value()) {
             if (op_L0D_size.get_value() > 0) {
@@ -3015,6 +3272,8 @@ event_exit(void)
         file_ops_func.close_file(module_file);
         if (funclist_file != INVALID_FILE)
             file_ops_func.close_file(funclist_file);
+        if (gencode_file != INVALID_FILE)
+            file_ops_func.close_file(gencode_file);
     } else
         ipc_pipe.close();
 
@@ -3060,6 +3319,38 @@ event_exit(void)
     droption_parser_t::clear_values();
 }
 
+/* Appends this process to the -process_manifest manifest in -outdir.  Other
+ * processes may be appending concurrently, so we write the whole line at once
+ * to a file opened for appending.
+ */
+static bool
+register_in_process_manifest(const char *subdir)
+{
+    char path[MAXIMUM_PATH];
+    char line[MAXIMUM_PATH + 64];
+    dr_snprintf(path, BUFFER_SIZE_ELEMENTS(path), "%s%s%s",
+                op_outdir.get_value().c_str(), DIRSEP,
+                DRMEMTRACE_PROCESS_MANIFEST_FILENAME);
+    NULL_TERMINATE_BUFFER(path);
+    const char *name = strrchr(subdir, DIRSEP[0]);
+    name = (name == NULL) ? subdir : name + 1;
+#ifdef UNIX
+    int parent_id = (int)dr_get_parent_id();
+#else
+    int parent_id = 0;
+#endif
+    int len = dr_snprintf(line, BUFFER_SIZE_ELEMENTS(line), "%d,%d,%s\n",
+                          (int)dr_get_process_id(), parent_id, name);
+    if (len < 0)
+        return false;
+    file_t file = file_ops_func.open_file(path, DR_FILE_WRITE_APPEND);
+    if (file == INVALID_FILE)
+        return false;
+    bool ok = file_ops_func.write_file(file, line, len) == len;
+    file_ops_func.close_file(file);
+    return ok;
+}
+
 static bool
 init_offline_dir(void)
 {
@@ -3073,6 +3364,12 @@ init_offline_dir(void)
     dr_snprintf(subdir_prefix, BUFFER_SIZE_ELEMENTS(subdir_prefix), "%s",
                 op_subdir_prefix.get_value().c_str());
     NULL_TERMINATE_BUFFER(subdir_prefix);
+    /* The -outdir shared by a process tree is created by whichever process gets
+     * there first; a failure here is caught when creating the sub-directory.
+     */
+    if (op_process_manifest.get_value() &&
+        !dr_directory_exists(op_outdir.get_value().c_str()))
+        file_ops_func.create_dir(op_outdir.get_value().c_str());
     /* We do not need to call drx_init before using drx_open_unique_appid_file. */
     for (i = 0; i < NUM_OF_TRIES; i++) {
         /* We use drx_open_unique_appid_file with DRX_FILE_SKIP_OPEN to get a
@@ -3089,6 +3386,8 @@ init_offline_dir(void)
     }
     if (i == NUM_OF_TRIES)
         return false;
+    if (op_process_manifest.get_value() && !register_in_process_manifest(buf))
+        return false;
     /* We group the raw thread files in a further subdir to isolate from the
      * processed trace file.
      */
@@ -3117,6 +3416,17 @@ init_offline_dir(void)
     funclist_file = file_ops_func.open_file(
         funclist_path, DR_FILE_WRITE_REQUIRE_NEW IF_UNIX(| DR_FILE_CLOSE_ON_FORK));
 
+    if (op_record_gencode.get_value()) {
+        char gencode_path[MAXIMUM_PATH];
+        dr_snprintf(gencode_path, BUFFER_SIZE_ELEMENTS(gencode_path), "%s%s%s",
+                    logsubdir, DIRSEP, DRMEMTRACE_GENCODE_FILENAME);
+        NULL_TERMINATE_BUFFER(gencode_path);
+        gencode_file = file_ops_func.open_file(
+            gencode_path, DR_FILE_WRITE_REQUIRE_NEW IF_UNIX(| DR_FILE_CLOSE_ON_FORK));
+        if (gencode_file == INVALID_FILE)
+            return false;
+    }
+
     return (module_file != INVALID_FILE && funclist_file != INVALID_FILE);
 }
 
@@ -3148,11 +3458,30 @@ fork_init(void *drcontext)
         if (!init_offline_dir()) {
             FATAL("Failed to create a subdir in %s\n", op_outdir.get_value().c_str());
         }
+        if (op_record_gencode.get_value())
+            static_cast<offline_instru_t *>(instru)->set_gencode_file(gencode_file);
     }
     init_thread_in_process(drcontext);
 }
 #endif
 
+static void
+event_nudge(void *drcontext, uint64 argument)
+{
+    flight_recorder_trigger();
+}
+
+#ifdef UNIX
+static dr_signal_action_t
+event_signal(void *drcontext, dr_siginfo_t *info)
+{
+    if (info->sig != op_flight_recorder_signal.get_value())
+        return DR_SIGNAL_DELIVER;
+    flight_recorder_trigger();
+    return DR_SIGNAL_SUPPRESS;
+}
+#endif
+
 /* We export drmemtrace_client_main so that a global dr_client_main can initialize
  * drmemtrace client by calling drmemtrace_client_main in a statically linked
  * multi-client executable.
@@ -3181,6 +3510,11 @@ drmemtrace_client_main(client_id_t id, int argc, const char *argv[])
     } else if (!op_offline.get_value() &&
                (op_record_heap.get_value() || !op_record_function.get_value().empty())) {
         FATAL("Usage error: function recording is only supported for -offline\n");
+    } else if (op_flight_recorder.get_value() > 0 &&
+               (!op_offline.get_value() || op_use_physical.get_value() ||
+                has_tracing_windows() || file_ops_func.handoff_buf != NULL)) {
+        FATAL("Usage error: -flight_recorder requires -offline and does not support "
+              "-use_physical, tracing windows, or buffer handoff\n");
     }
 
     if (op_L0_filter_deprecated.get_value()) {
@@ -3240,6 +3574,8 @@ drmemtrace_client_main(client_id_t id, int argc, const char *argv[])
         instru = new (placement) offline_instru_t(
             insert_load_buf_ptr, op_L0I_filter.get_value(), &scratch_reserve_vec,
             file_ops_func.write_file, module_file, op_disable_optimizations.get_value());
+        if (op_record_gencode.get_value())
+            static_cast<offline_instru_t *>(instru)->set_gencode_file(gencode_file);
     } else {
         void *placement;
         /* we use placement new for better isolation */
@@ -3382,6 +3718,21 @@ drmemtrace_client_main(client_id_t id, int argc, const char *argv[])
 
     if (op_use_physical.get_value() && !physaddr_t::global_init())
         FATAL("Unable to open pagemap for physical addresses: check privileges.\n");
+
+    if (flight_recorder_enabled()) {
+        history_slots = static_cast<uint>(
+            ALIGN_FORWARD(op_flight_recorder.get_value(), trace_buf_size) /
+            trace_buf_size);
+        dr_register_nudge_event(event_nudge, id);
+#ifdef UNIX
+        if (op_flight_recorder_signal.get_value() != 0 &&
+            !drmgr_register_signal_event(event_signal))
+            DR_ASSERT(false);
+#endif
+        dr_annotation_register_call("drmemtrace_flight_recorder_dump",
+                                    (void *)flight_recorder_trigger, false, 0,
+                                    DR_ANNOTATION_CALL_TYPE_FASTCALL);
+    }
 }
 
 /* To support statically linked multiple clients, we add drmemtrace_client_main